@@ -0,0 +1,116 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "StdAfx.h"
+#include "bench.h"
+
+
+static bench::isa s_isa = bench::isa::avx2;
+
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+bool winstd::cpu_has_ssse3()
+{
+    return s_isa >= bench::isa::ssse3 && __builtin_cpu_supports("ssse3");
+}
+
+
+bool winstd::cpu_has_avx2()
+{
+    return s_isa >= bench::isa::avx2 && __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+
+const char *bench::isa_name(isa level)
+{
+    switch (level) {
+    case isa::scalar: return "scalar";
+    case isa::ssse3 : return "ssse3";
+    case isa::avx2  : return "avx2";
+    }
+    return "?";
+}
+
+
+bool bench::isa_supported(isa level)
+{
+    switch (level) {
+    case isa::scalar: return true;
+#if defined(_M_IX86) || defined(_M_X64)
+    case isa::ssse3 : return __builtin_cpu_supports("ssse3");
+    case isa::avx2  : return __builtin_cpu_supports("avx2");
+#else
+    default         : return false;
+#endif
+    }
+    return false;
+}
+
+
+void bench::set_isa(isa level)
+{
+    s_isa = level;
+}
+
+
+double bench::seconds()
+{
+    static double s = -1;
+    if (s < 0) {
+        const char *env = getenv("WINSTD_BENCH_SECONDS");
+        s = env ? atof(env) : 0.2;
+        if (s < 0)
+            s = 0;
+    }
+    return s;
+}
+
+
+void bench::report(const char *name, const char *arg, double value, const char *unit)
+{
+    printf("%-48s %-10s %12.1f %s\n", name, arg, value, unit);
+    fflush(stdout);
+}
+
+
+void bench::report_mbps(const char *name, size_t size, double calls_per_sec)
+{
+    char buf[32];
+    report(name, size_name(size, buf, _countof(buf)), calls_per_sec*size/1e6, "MB/s");
+}
+
+
+const char *bench::size_name(size_t size, char *buf, size_t buf_size)
+{
+    if (size >= 0x100000 && size % 0x100000 == 0)
+        snprintf(buf, buf_size, "%zu MiB", size >> 20);
+    else if (size >= 0x400 && size % 0x400 == 0)
+        snprintf(buf, buf_size, "%zu KiB", size >> 10);
+    else
+        snprintf(buf, buf_size, "%zu B", size);
+    return buf;
+}
+
+
+size_t bench::failures = 0;
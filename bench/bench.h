@@ -0,0 +1,170 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Benchmark and test harness helpers
+//
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+
+namespace bench
+{
+    ///
+    /// Instruction set level the SIMD dispatchers may use
+    ///
+    enum class isa {
+        scalar = 0,     ///< Plain C only
+        ssse3,          ///< Up to SSSE3
+        avx2,           ///< Up to AVX2
+    };
+
+    ///
+    /// All instruction set levels, in ascending order
+    ///
+    static const isa isa_all[] = { isa::scalar, isa::ssse3, isa::avx2 };
+
+    ///
+    /// Returns instruction set level name
+    ///
+    const char *isa_name(isa level);
+
+    ///
+    /// Returns true when the CPU and the build support the instruction set level
+    ///
+    bool isa_supported(isa level);
+
+    ///
+    /// Limits the SIMD dispatchers to the given instruction set level
+    ///
+    void set_isa(isa level);
+
+
+    ///
+    /// Small fast pseudo-random generator (xorshift64*)
+    ///
+    class rng
+    {
+    public:
+        inline rng(uint64_t seed = 0x9e3779b97f4a7c15) : m_state(seed ? seed : 1) {}
+
+        inline uint64_t next()
+        {
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return m_state * 0x2545f4914f6cdd1d;
+        }
+
+        /// Returns a number in `[0, n)`
+        inline size_t below(size_t n) { return n ? (size_t)(next() % n) : 0; }
+
+        inline void fill(void *data, size_t size)
+        {
+            unsigned char *p = reinterpret_cast<unsigned char*>(data);
+            for (size_t i = 0; i < size; i++)
+                p[i] = (unsigned char)next();
+        }
+
+    protected:
+        uint64_t m_state;
+    };
+
+
+    ///
+    /// Returns seconds each measurement should run: `WINSTD_BENCH_SECONDS` environment variable, or 0.2
+    ///
+    double seconds();
+
+
+    ///
+    /// Calls `fn()` repeatedly for at least `seconds()` and returns the number of calls per second
+    ///
+    template<class _Fn>
+    inline double rate(_Fn fn)
+    {
+        typedef std::chrono::steady_clock clock;
+        const double limit = seconds();
+        size_t n = 0, batch = 1;
+        clock::time_point start = clock::now();
+        double elapsed;
+        for (;;) {
+            for (size_t i = 0; i < batch; i++)
+                fn();
+            n += batch;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            if (elapsed >= limit)
+                break;
+            if (batch < 0x10000)
+                batch *= 2;
+        }
+        return n/elapsed;
+    }
+
+
+    ///
+    /// Prints one result line
+    ///
+    /// \param[in] name   Benchmark name
+    /// \param[in] arg    Benchmark argument (size, thread count...)
+    /// \param[in] value  Result
+    /// \param[in] unit   Result unit
+    ///
+    void report(const char *name, const char *arg, double value, const char *unit);
+
+
+    ///
+    /// Prints one throughput line in MB/s
+    ///
+    void report_mbps(const char *name, size_t size, double calls_per_sec);
+
+
+    ///
+    /// Returns human-readable size: `64 B`, `4 KiB`, `16 MiB`
+    ///
+    const char *size_name(size_t size, char *buf, size_t buf_size);
+
+
+    ///
+    /// Counts test failures
+    ///
+    extern size_t failures;
+
+    ///
+    /// Records a failure when the condition is false
+    ///
+#define BENCH_CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s(%d): check failed: %s: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__); \
+            fputc('\n', stderr); \
+            if (++bench::failures >= 20) { fputs("Too many failures.\n", stderr); exit(1); } \
+        } \
+    } while (0)
+}
@@ -0,0 +1,286 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Throughput benchmark of the Base64 and hexadecimal codecs
+//
+// Measures encoding and decoding of random data of several sizes, in one call
+// and streamed in blocks, with narrow and wide characters, at every instruction
+// set level the CPU supports. Multi-threaded Base64 is measured on the largest
+// size with 1, 2, 4... threads up to the number of logical processors.
+// Benchmarks named `reference` measure the code WinStd used before, for
+// comparison.
+//
+// Usage: codec_bench [filter]
+//
+// Only benchmarks with names containing `filter` are run. Set the
+// WINSTD_BENCH_SECONDS environment variable to change the measurement time.
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+#include "reference.h"
+
+using namespace std;
+using namespace winstd;
+
+
+static const char *s_filter = NULL;
+static const size_t s_sizes[] = { 64, 0x1000, 0x10000, 0x1000000 };
+static const size_t s_block = 0x1000;
+
+
+///
+/// Runs and reports one benchmark, unless filtered out
+///
+template<class _Fn>
+static void run(const char *codec, const char *mode, const char *chr, const char *isa, size_t size, _Fn fn)
+{
+    char name[128];
+    snprintf(name, _countof(name), "%s/%s/%s/%s", codec, mode, chr, isa);
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    bench::report_mbps(name, size, bench::rate(fn));
+}
+
+
+template<class _Tchr> static const char *char_name();
+template<> const char *char_name<char   >() { return "char"; }
+template<> const char *char_name<wchar_t>() { return "wchar_t"; }
+
+
+template<class _Tchr>
+static void bench_base64(const vector<unsigned char> &data, const char *isa)
+{
+    const size_t size = data.size();
+    basic_string<_Tchr> encoded;
+    encoded.reserve(size/3*4 + 4);
+    vector<unsigned char> decoded;
+    decoded.reserve(size);
+
+    run("base64_enc", "one-shot", char_name<_Tchr>(), isa, size, [&] {
+        base64_enc enc;
+        encoded.clear();
+        enc.encode(encoded, data.data(), size);
+    });
+    if (size > s_block) {
+        run("base64_enc", "streamed", char_name<_Tchr>(), isa, size, [&] {
+            base64_enc enc;
+            encoded.clear();
+            for (size_t i = 0; i < size; i += s_block)
+                enc.encode(encoded, data.data() + i, std::min<size_t>(s_block, size - i), i + s_block >= size);
+        });
+    }
+
+    encoded.clear();
+    base64_enc().encode(encoded, data.data(), size);
+    const size_t encoded_size = encoded.size();
+
+    run("base64_dec", "one-shot", char_name<_Tchr>(), isa, size, [&] {
+        base64_dec dec;
+        bool is_last;
+        decoded.clear();
+        dec.decode(decoded, is_last, encoded.data(), encoded_size);
+    });
+    run("base64_dec", "strict", char_name<_Tchr>(), isa, size, [&] {
+        base64_dec dec;
+        bool is_last;
+        decoded.clear();
+        dec.decode_strict(decoded, is_last, encoded.data(), encoded_size);
+    });
+    if (size > s_block) {
+        run("base64_dec", "streamed", char_name<_Tchr>(), isa, size, [&] {
+            base64_dec dec;
+            bool is_last = false;
+            decoded.clear();
+            for (size_t i = 0; i < encoded_size && !is_last; i += s_block)
+                dec.decode(decoded, is_last, encoded.data() + i, std::min<size_t>(s_block, encoded_size - i));
+        });
+    }
+}
+
+
+///
+/// Measures the character by character encoder WinStd used before
+///
+template<class _Tchr>
+static void bench_base64_reference(const vector<unsigned char> &data)
+{
+    const size_t size = data.size();
+    basic_string<_Tchr> encoded;
+    encoded.reserve(size/3*4 + 4);
+
+    run("base64_enc", "one-shot", char_name<_Tchr>(), "reference", size, [&] {
+        reference::base64_enc enc;
+        encoded.clear();
+        enc.encode(encoded, data.data(), size);
+    });
+    if (size > s_block) {
+        run("base64_enc", "streamed", char_name<_Tchr>(), "reference", size, [&] {
+            reference::base64_enc enc;
+            encoded.clear();
+            for (size_t i = 0; i < size; i += s_block)
+                enc.encode(encoded, data.data() + i, std::min<size_t>(s_block, size - i), i + s_block >= size);
+        });
+    }
+}
+
+
+template<class _Tchr>
+static void bench_base64_parallel(const vector<unsigned char> &data, const char *isa)
+{
+    const size_t size = data.size();
+    basic_string<_Tchr> encoded;
+    encoded.reserve(size/3*4 + 4);
+    vector<unsigned char> decoded;
+    decoded.reserve(size);
+    base64_enc().encode(encoded, data.data(), size);
+    const basic_string<_Tchr> reference(encoded);
+
+    size_t threads_max = std::max<size_t>(thread::hardware_concurrency(), 1);
+    for (size_t threads = 1;; threads = std::min<size_t>(threads*2, threads_max)) {
+        char mode[32];
+        snprintf(mode, _countof(mode), "parallel-%zu", threads);
+
+        run("base64_enc", mode, char_name<_Tchr>(), isa, size, [&] {
+            base64_enc enc;
+            encoded.clear();
+            enc.encode_parallel(encoded, data.data(), size, true, threads);
+        });
+        run("base64_dec", mode, char_name<_Tchr>(), isa, size, [&] {
+            base64_dec dec;
+            bool is_last;
+            decoded.clear();
+            dec.decode_parallel(decoded, is_last, reference.data(), reference.size(), threads);
+        });
+
+        if (threads >= threads_max)
+            break;
+    }
+}
+
+
+template<class _Tchr>
+static void bench_hex(const vector<unsigned char> &data, const char *isa)
+{
+    const size_t size = data.size();
+    basic_string<_Tchr> encoded;
+    encoded.reserve(size*2);
+    vector<unsigned char> decoded;
+    decoded.reserve(size);
+
+    run("hex_enc", "one-shot", char_name<_Tchr>(), isa, size, [&] {
+        hex_enc enc;
+        encoded.clear();
+        enc.encode(encoded, data.data(), size);
+    });
+    run("hex_enc", "lowercase", char_name<_Tchr>(), isa, size, [&] {
+        hex_enc enc(true);
+        encoded.clear();
+        enc.encode(encoded, data.data(), size);
+    });
+    if (size > s_block) {
+        run("hex_enc", "streamed", char_name<_Tchr>(), isa, size, [&] {
+            hex_enc enc;
+            encoded.clear();
+            for (size_t i = 0; i < size; i += s_block)
+                enc.encode(encoded, data.data() + i, std::min<size_t>(s_block, size - i));
+        });
+    }
+
+    encoded.clear();
+    hex_enc().encode(encoded, data.data(), size);
+    const size_t encoded_size = encoded.size();
+
+    run("hex_dec", "one-shot", char_name<_Tchr>(), isa, size, [&] {
+        hex_dec dec;
+        bool is_last;
+        decoded.clear();
+        dec.decode(decoded, is_last, encoded.data(), encoded_size);
+    });
+    if (size > s_block) {
+        run("hex_dec", "streamed", char_name<_Tchr>(), isa, size, [&] {
+            hex_dec dec;
+            bool is_last;
+            decoded.clear();
+            for (size_t i = 0; i < encoded_size; i += s_block)
+                dec.decode(decoded, is_last, encoded.data() + i, std::min<size_t>(s_block, encoded_size - i));
+        });
+    }
+}
+
+
+///
+/// Measures the character by character encoder WinStd used before
+///
+template<class _Tchr>
+static void bench_hex_reference(const vector<unsigned char> &data)
+{
+    const size_t size = data.size();
+    basic_string<_Tchr> encoded;
+    encoded.reserve(size*2);
+
+    run("hex_enc", "one-shot", char_name<_Tchr>(), "reference", size, [&] {
+        reference::hex_enc enc;
+        encoded.clear();
+        enc.encode(encoded, data.data(), size);
+    });
+    if (size > s_block) {
+        run("hex_enc", "streamed", char_name<_Tchr>(), "reference", size, [&] {
+            reference::hex_enc enc;
+            encoded.clear();
+            for (size_t i = 0; i < size; i += s_block)
+                enc.encode(encoded, data.data() + i, std::min<size_t>(s_block, size - i));
+        });
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    bench::rng rng;
+    for (size_t size : s_sizes) {
+        vector<unsigned char> data(size);
+        rng.fill(data.data(), size);
+
+        bench_base64_reference<char   >(data);
+        bench_base64_reference<wchar_t>(data);
+        bench_hex_reference   <char   >(data);
+        bench_hex_reference   <wchar_t>(data);
+        for (bench::isa level : bench::isa_all) {
+            if (!bench::isa_supported(level))
+                continue;
+            bench::set_isa(level);
+            bench_base64<char   >(data, bench::isa_name(level));
+            bench_base64<wchar_t>(data, bench::isa_name(level));
+            bench_hex   <char   >(data, bench::isa_name(level));
+            bench_hex   <wchar_t>(data, bench::isa_name(level));
+            if (size == s_sizes[_countof(s_sizes) - 1]) {
+                bench_base64_parallel<char   >(data, bench::isa_name(level));
+                bench_base64_parallel<wchar_t>(data, bench::isa_name(level));
+            }
+        }
+    }
+    return 0;
+}
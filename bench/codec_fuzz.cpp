@@ -0,0 +1,522 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Differential fuzz test of the Base64 and hexadecimal codecs
+//
+// Random inputs are encoded and decoded by every API flavour (one-shot,
+// streamed in random blocks, into buffers of random capacity, through output
+// iterators, narrow and wide characters) at every instruction set level, and
+// the results are compared against the reference codecs.
+//
+// Usage: codec_fuzz [iterations [seed]]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+#include "reference.h"
+
+#include <iterator>
+
+using namespace std;
+using namespace winstd;
+
+
+static size_t s_iterations = 300;
+static bench::rng s_rng;
+
+
+///
+/// Returns random data size: mostly small, sometimes several SIMD blocks
+///
+static size_t random_size()
+{
+    switch (s_rng.below(4)) {
+    case 0 : return s_rng.below(8);
+    case 1 : return s_rng.below(100);
+    default: return s_rng.below(3000);
+    }
+}
+
+
+///
+/// Splits `size` into random block sizes
+///
+static vector<size_t> random_blocks(size_t size)
+{
+    vector<size_t> blocks;
+    while (size) {
+        size_t n = s_rng.below(4) ? 1 + s_rng.below(std::min<size_t>(size, 1 + s_rng.below(200))) : size;
+        blocks.push_back(n);
+        size -= n;
+    }
+    if (blocks.empty() || s_rng.below(8) == 0)
+        blocks.push_back(0);
+    return blocks;
+}
+
+
+template<class _Tchr>
+static basic_string<_Tchr> widen(const string &s)
+{
+    return basic_string<_Tchr>(s.begin(), s.end());
+}
+
+
+static string hex_lower(string s)
+{
+    for (auto &c : s)
+        if ('A' <= c && c <= 'F')
+            c += 'a' - 'A';
+    return s;
+}
+
+
+///
+/// Transforms standard padded Base64 into the given alphabet's flavour
+///
+template<class _Alphabet>
+static string base64_flavour(const string &s)
+{
+    string r;
+    for (char c : s) {
+        if (c == '=' && !_Alphabet::padding)
+            continue;
+        if (_Alphabet::line_max && r.size() % (_Alphabet::line_max + 2) == _Alphabet::line_max && !r.empty())
+            r += "\r\n";
+        r += c == '+' ? _Alphabet::lookup_enc[62] : c == '/' ? _Alphabet::lookup_enc[63] : c;
+    }
+    return r;
+}
+
+
+template<class _Alphabet, class _Tchr>
+static void test_base64_enc(const vector<unsigned char> &data, const string &expected_std)
+{
+    const basic_string<_Tchr> expected = widen<_Tchr>(base64_flavour<_Alphabet>(expected_std));
+
+    {
+        // One shot
+        basic_base64_enc<_Alphabet> enc;
+        basic_string<_Tchr> out;
+        enc.encode(out, data.data(), data.size());
+        BENCH_CHECK(out == expected, "one-shot, size %zu", data.size());
+    }
+
+    {
+        // Streamed
+        basic_base64_enc<_Alphabet> enc;
+        basic_string<_Tchr> out;
+        size_t offset = 0;
+        vector<size_t> blocks = random_blocks(data.size());
+        for (size_t k = 0; k < blocks.size(); k++) {
+            enc.encode(out, data.data() + offset, blocks[k], k + 1 == blocks.size());
+            offset += blocks[k];
+        }
+        BENCH_CHECK(out == expected, "streamed, size %zu", data.size());
+    }
+
+    {
+        // Output iterator
+        basic_base64_enc<_Alphabet> enc;
+        basic_string<_Tchr> out;
+        enc.encode(back_inserter(out), data.data(), data.size());
+        BENCH_CHECK(out == expected, "iterator, size %zu", data.size());
+    }
+
+    {
+        // Buffers of random capacity
+        basic_base64_enc<_Alphabet> enc;
+        basic_string<_Tchr> out;
+        vector<_Tchr> buf;
+        size_t offset = 0, rounds = 0;
+        do {
+            // The last bytes are consumed only once there is room to flush them.
+            buf.resize((_Alphabet::line_max ? 6 : 4) + s_rng.below(s_rng.below(2) ? 16 : 400));
+            size_t consumed, n = enc.encode(buf.data(), buf.size(), consumed, data.data() + offset, data.size() - offset);
+            BENCH_CHECK(n <= buf.size(), "buffer overrun, size %zu", data.size());
+            out.append(buf.data(), n);
+            offset += consumed;
+        } while (offset < data.size() && ++rounds < data.size() + 10);
+        BENCH_CHECK(out == expected, "buffer, size %zu", data.size());
+    }
+}
+
+
+///
+/// Returns a random character to mix into encoded data
+///
+template<class _Tchr>
+static _Tchr random_noise(bool with_terminator)
+{
+    static const char whitespace[] = { ' ', '\t', '\r', '\n' };
+    switch (s_rng.below(with_terminator ? 8 : 7)) {
+    case 0 : return (_Tchr)(unsigned char)(0x80 + s_rng.below(0x80));
+    case 1 : return sizeof(_Tchr) > 1 ? (_Tchr)(0x100 + s_rng.below(0x100)) : (_Tchr)'*';
+    case 2 : return (_Tchr)"!\"#$%&'()*,.:;<>?@[\\]^`{|}~-_"[s_rng.below(30)];
+    case 7 : return (_Tchr)0;
+    default: return (_Tchr)whitespace[s_rng.below(_countof(whitespace))];
+    }
+}
+
+
+///
+/// Mixes noise into encoded data
+///
+template<class _Tchr>
+static basic_string<_Tchr> add_noise(const basic_string<_Tchr> &s, size_t level)
+{
+    if (!level)
+        return s;
+    basic_string<_Tchr> r;
+    r.reserve(s.size()*2);
+    bool terminator = s_rng.below(8) == 0;
+    for (auto c : s) {
+        if (s_rng.below(level) == 0)
+            r += random_noise<_Tchr>(terminator);
+        r += c;
+    }
+    if (s_rng.below(4) == 0)
+        r += widen<_Tchr>("QUJD");  // Data after the padding
+    return r;
+}
+
+
+template<class _Tchr>
+static void test_base64_dec(const basic_string<_Tchr> &encoded)
+{
+    // Reference result, streamed in the same blocks
+    vector<size_t> blocks = random_blocks(encoded.size());
+    vector<unsigned char> expected, expected_oneshot;
+    {
+        reference::base64_dec dec;
+        bool is_last;
+        size_t offset = 0;
+        for (size_t k = 0; k < blocks.size(); k++) {
+            dec.decode(expected, is_last, encoded.data() + offset, blocks[k]);
+            offset += blocks[k];
+            if (is_last) break;
+        }
+    }
+    {
+        reference::base64_dec dec;
+        bool is_last;
+        dec.decode(expected_oneshot, is_last, encoded.data(), encoded.size());
+    }
+
+    {
+        // One shot
+        base64_dec dec;
+        vector<unsigned char> out;
+        bool is_last;
+        dec.decode(out, is_last, encoded.data(), encoded.size());
+        BENCH_CHECK(out == expected_oneshot, "one-shot, size %zu", encoded.size());
+    }
+
+    {
+        // Streamed
+        base64_dec dec;
+        vector<unsigned char> out;
+        bool is_last;
+        size_t offset = 0;
+        for (size_t k = 0; k < blocks.size(); k++) {
+            dec.decode(out, is_last, encoded.data() + offset, blocks[k]);
+            offset += blocks[k];
+            if (is_last) break;
+        }
+        BENCH_CHECK(out == expected, "streamed, size %zu", encoded.size());
+    }
+
+    {
+        // Output iterator
+        base64_dec dec;
+        vector<unsigned char> out;
+        bool is_last;
+        dec.decode(back_inserter(out), is_last, encoded.data(), encoded.size());
+        BENCH_CHECK(out == expected_oneshot, "iterator, size %zu", encoded.size());
+    }
+
+    {
+        // Buffers of random capacity
+        base64_dec dec;
+        vector<unsigned char> out, buf;
+        bool is_last = false;
+        for (size_t offset = 0; !is_last && offset < encoded.size() && encoded[offset]; ) {
+            buf.resize(3 + s_rng.below(s_rng.below(2) ? 16 : 400));
+            size_t consumed, n = dec.decode(buf.data(), buf.size(), consumed, is_last, encoded.data() + offset, encoded.size() - offset);
+            BENCH_CHECK(n <= buf.size(), "buffer overrun, size %zu", encoded.size());
+            out.insert(out.end(), buf.data(), buf.data() + n);
+            if (!consumed && !is_last && encoded[offset]) {
+                BENCH_CHECK(false, "buffer decoding makes no progress, size %zu", encoded.size());
+                break;
+            }
+            offset += consumed;
+        }
+        BENCH_CHECK(out == expected_oneshot, "buffer, size %zu", encoded.size());
+    }
+}
+
+
+template<class _Tchr>
+static void test_base64_dec_strict(const string &encoded_std)
+{
+    static const char whitespace[] = { ' ', '\t', '\r', '\n' };
+    static const char invalid[] = { '*', '-', '_', '.', '\0', '\x80', '\xff' };
+
+    // Valid data with white-space, and optionally one invalid character
+    basic_string<_Tchr> encoded;
+    size_t level = s_rng.below(2) ? 0 : 1 + s_rng.below(20);
+    for (char c : encoded_std) {
+        if (level && s_rng.below(level) == 0)
+            encoded += (_Tchr)whitespace[s_rng.below(_countof(whitespace))];
+        encoded += (_Tchr)c;
+    }
+    size_t end = encoded.size(), data_size = encoded_std.size();
+    if (s_rng.below(2) && !encoded_std.empty()) {
+        end = s_rng.below(encoded.size());
+        encoded.insert(end, 1, sizeof(_Tchr) > 1 && s_rng.below(4) == 0 ? (_Tchr)(0x100 + 'A') : (_Tchr)(unsigned char)invalid[s_rng.below(_countof(invalid))]);
+        data_size = 0;
+        for (size_t i = 0; i < end; i++)
+            if (encoded[i] != ' ' && encoded[i] != '\t' && encoded[i] != '\r' && encoded[i] != '\n')
+                data_size++;
+    }
+    bool padded = data_size == encoded_std.size() && encoded_std.find('=') != string::npos;
+
+    vector<unsigned char> expected;
+    bool is_last_expected;
+    reference::base64_dec().decode(expected, is_last_expected, encoded_std.data(), data_size);
+
+    base64_dec dec;
+    vector<unsigned char> out;
+    bool is_last = false;
+    size_t offset = 0, result = encoded.size();
+    for (size_t n : random_blocks(encoded.size())) {
+        size_t r = dec.decode_strict(out, is_last, encoded.data() + offset, n);
+        if (r < n || is_last) {
+            result = offset + r;
+            break;
+        }
+        offset += n;
+    }
+    BENCH_CHECK(result == end, "strict position %zu, expected %zu", result, end);
+    BENCH_CHECK(out == expected, "strict, size %zu", encoded.size());
+    BENCH_CHECK(is_last == padded, "strict is_last, size %zu", encoded.size());
+}
+
+
+///
+/// Checks strict Base64 decoding of a string
+///
+static void check_base64_dec_strict(const char *encoded, size_t result_expected, const char *decoded_expected, bool is_last_expected)
+{
+    base64_dec dec;
+    vector<unsigned char> out;
+    bool is_last;
+    size_t result = dec.decode_strict(out, is_last, encoded, strlen(encoded));
+    BENCH_CHECK(result == result_expected, "\"%s\": position %zu, expected %zu", encoded, result, result_expected);
+    BENCH_CHECK(string(out.begin(), out.end()) == decoded_expected, "\"%s\": wrong data", encoded);
+    BENCH_CHECK(is_last == is_last_expected, "\"%s\": is_last", encoded);
+}
+
+
+static void test_base64_dec_strict_padding()
+{
+    check_base64_dec_strict("QUJD"        ,  4, "ABC" , false);
+    check_base64_dec_strict("QUJD\r\nRA==", 10, "ABCD", true );
+    check_base64_dec_strict("QUI="        ,  4, "AB"  , true );
+    check_base64_dec_strict("QQ = = QUJD" ,  6, "A"   , true );
+    check_base64_dec_strict("QQ=A"        ,  3, ""    , false);
+    check_base64_dec_strict("Q==="        ,  1, ""    , false);
+    check_base64_dec_strict("=QUJD"       ,  0, ""    , false);
+    check_base64_dec_strict("QUJDQQ=*"    ,  7, "ABC" , false);
+    check_base64_dec_strict("QUJD-QUJD"   ,  4, "ABC" , false);
+}
+
+
+static void test_base64()
+{
+    vector<unsigned char> data(random_size());
+    s_rng.fill(data.data(), data.size());
+
+    string expected;
+    reference::base64_enc().encode(expected, data.data(), data.size());
+
+    test_base64_enc<base64_std      , char   >(data, expected);
+    test_base64_enc<base64_std      , wchar_t>(data, expected);
+    test_base64_enc<base64_std_nopad, char   >(data, expected);
+    test_base64_enc<base64_url      , char   >(data, expected);
+    test_base64_enc<base64_url_nopad, wchar_t>(data, expected);
+    test_base64_enc<base64_mime     , char   >(data, expected);
+    test_base64_enc<base64_mime     , wchar_t>(data, expected);
+
+    size_t noise = s_rng.below(3) ? 0 : 1 + s_rng.below(40);
+    test_base64_dec<char   >(add_noise(expected, noise));
+    test_base64_dec<wchar_t>(add_noise(widen<wchar_t>(expected), noise));
+    test_base64_dec_strict<char   >(expected);
+    test_base64_dec_strict<wchar_t>(expected);
+}
+
+
+template<class _Tchr>
+static void test_hex_enc(const vector<unsigned char> &data, const string &expected_upper)
+{
+    for (int lowercase = 0; lowercase < 2; lowercase++) {
+        const basic_string<_Tchr> expected = widen<_Tchr>(lowercase ? hex_lower(expected_upper) : expected_upper);
+
+        {
+            // Streamed
+            hex_enc enc(lowercase != 0);
+            basic_string<_Tchr> out;
+            size_t offset = 0;
+            for (size_t n : random_blocks(data.size())) {
+                enc.encode(out, data.data() + offset, n);
+                offset += n;
+            }
+            BENCH_CHECK(out == expected, "streamed, size %zu", data.size());
+        }
+
+        {
+            // Output iterator
+            hex_enc enc(lowercase != 0);
+            basic_string<_Tchr> out;
+            enc.encode(back_inserter(out), data.data(), data.size());
+            BENCH_CHECK(out == expected, "iterator, size %zu", data.size());
+        }
+
+        {
+            // Buffers of random capacity
+            hex_enc enc(lowercase != 0);
+            basic_string<_Tchr> out;
+            vector<_Tchr> buf;
+            for (size_t offset = 0; offset < data.size(); ) {
+                buf.resize(2 + s_rng.below(s_rng.below(2) ? 16 : 400));
+                size_t consumed, n = enc.encode(buf.data(), buf.size(), consumed, data.data() + offset, data.size() - offset);
+                BENCH_CHECK(n <= buf.size(), "buffer overrun, size %zu", data.size());
+                out.append(buf.data(), n);
+                offset += consumed;
+            }
+            BENCH_CHECK(out == expected, "buffer, size %zu", data.size());
+        }
+    }
+}
+
+
+template<class _Tchr>
+static void test_hex_dec(const basic_string<_Tchr> &encoded)
+{
+    vector<size_t> blocks = random_blocks(encoded.size());
+    vector<unsigned char> expected;
+    {
+        reference::hex_dec dec;
+        bool is_last;
+        size_t offset = 0;
+        for (size_t n : blocks) {
+            dec.decode(expected, is_last, encoded.data() + offset, n);
+            offset += n;
+        }
+    }
+
+    {
+        // Streamed
+        hex_dec dec;
+        vector<unsigned char> out;
+        bool is_last;
+        size_t offset = 0;
+        for (size_t n : blocks) {
+            dec.decode(out, is_last, encoded.data() + offset, n);
+            offset += n;
+        }
+        BENCH_CHECK(out == expected, "streamed, size %zu", encoded.size());
+    }
+
+    {
+        // Strict, stops at the first character that is not a hexadecimal digit
+        size_t invalid = 0;
+        while (invalid < encoded.size() && (unsigned)encoded[invalid] < 0x80 && isxdigit((int)encoded[invalid]))
+            invalid++;
+        vector<unsigned char> expected_strict;
+        bool is_last_ref;
+        reference::hex_dec().decode(expected_strict, is_last_ref, encoded.data(), invalid);
+
+        hex_dec dec;
+        vector<unsigned char> out;
+        bool is_last = false;
+        size_t offset = 0, result = encoded.size();
+        for (size_t n : blocks) {
+            size_t r = dec.decode_strict(out, is_last, encoded.data() + offset, n);
+            if (r < n) {
+                result = offset + r;
+                break;
+            }
+            offset += n;
+        }
+        BENCH_CHECK(result == (invalid < encoded.size() ? invalid : encoded.size()), "strict position %zu, expected %zu", result, invalid);
+        BENCH_CHECK(out == expected_strict, "strict, size %zu", encoded.size());
+        BENCH_CHECK(is_last == (invalid % 2 == 0) || !encoded.size(), "strict is_last, size %zu", encoded.size());
+    }
+}
+
+
+static void test_hex()
+{
+    vector<unsigned char> data(random_size());
+    s_rng.fill(data.data(), data.size());
+
+    string expected;
+    reference::hex_enc().encode(expected, data.data(), data.size());
+
+    test_hex_enc<char   >(data, expected);
+    test_hex_enc<wchar_t>(data, expected);
+
+    size_t noise = s_rng.below(3) ? 0 : 1 + s_rng.below(40);
+    string encoded = s_rng.below(2) ? expected : hex_lower(expected);
+    test_hex_dec<char   >(add_noise(encoded, noise));
+    test_hex_dec<wchar_t>(add_noise(widen<wchar_t>(encoded), noise));
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_iterations = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        s_rng = bench::rng(strtoull(argv[2], NULL, 0));
+
+    for (bench::isa level : bench::isa_all) {
+        if (!bench::isa_supported(level)) {
+            printf("%-8s skipped: not supported\n", bench::isa_name(level));
+            continue;
+        }
+        bench::set_isa(level);
+        test_base64_dec_strict_padding();
+        for (size_t i = 0; i < s_iterations; i++) {
+            test_base64();
+            test_hex();
+        }
+        printf("%-8s %zu iterations\n", bench::isa_name(level), s_iterations);
+    }
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Differential test of multi-threaded Base64 encoding and decoding
+//
+// The target is built with WINSTD_PARALLEL_CHUNK_BYTES=1, so even the smallest
+// blocks are split among threads. Random data is streamed in blocks of one
+// character, a few characters, and random sizes through encode_parallel() and
+// decode_parallel(), and the results are compared against encode() and
+// decode() streamed in the same blocks. Exceptions thrown on worker threads
+// are checked to reach the calling thread.
+//
+// Usage: codec_parallel [iterations [seed]]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+
+#include <atomic>
+#include <iterator>
+
+using namespace std;
+using namespace winstd;
+
+
+static size_t s_iterations = 50;
+static bench::rng s_rng;
+
+
+///
+/// Splits `size` into blocks: all of size 1, all of size 2 or 3, or random
+///
+static vector<size_t> random_blocks(size_t size)
+{
+    size_t mode = s_rng.below(3);
+    vector<size_t> blocks;
+    while (size) {
+        size_t n =
+            mode == 0 ? 1 :
+            mode == 1 ? 2 + s_rng.below(2) :
+            1 + s_rng.below(1 + s_rng.below(300));
+        n = std::min<size_t>(n, size);
+        blocks.push_back(n);
+        size -= n;
+    }
+    if (blocks.empty())
+        blocks.push_back(0);
+    return blocks;
+}
+
+
+///
+/// Mixes white-space and an occasional terminator into encoded data
+///
+template<class _Tchr>
+static basic_string<_Tchr> add_noise(const string &s)
+{
+    static const char noise[] = { ' ', '\t', '\r', '\n', '*' };
+    size_t level = s_rng.below(2) ? 0 : 1 + s_rng.below(8);
+    basic_string<_Tchr> r;
+    for (char c : s) {
+        if (level && s_rng.below(level) == 0)
+            r += (_Tchr)(s_rng.below(200) ? noise[s_rng.below(_countof(noise))] : 0);
+        r += (_Tchr)c;
+    }
+    return r;
+}
+
+
+template<class _Alphabet, class _Tchr>
+static void test_encode(const vector<unsigned char> &data)
+{
+    vector<size_t> blocks = random_blocks(data.size());
+    size_t threads = 2 + s_rng.below(7);
+
+    basic_base64_enc<_Alphabet> enc, enc_parallel;
+    basic_string<_Tchr> expected, out;
+    size_t offset = 0;
+    for (size_t k = 0; k < blocks.size(); k++) {
+        bool is_last = k + 1 == blocks.size();
+        enc.encode(expected, data.data() + offset, blocks[k], is_last);
+        enc_parallel.encode_parallel(out, data.data() + offset, blocks[k], is_last, threads);
+        offset += blocks[k];
+    }
+    BENCH_CHECK(out == expected, "encode, size %zu, %zu threads", data.size(), threads);
+}
+
+
+template<class _Tchr>
+static void test_decode(const basic_string<_Tchr> &encoded)
+{
+    vector<size_t> blocks = random_blocks(encoded.size());
+    size_t threads = 2 + s_rng.below(7);
+
+    base64_dec dec;
+    vector<unsigned char> expected;
+    bool is_last = false;
+    for (size_t k = 0, offset = 0; k < blocks.size() && !is_last; offset += blocks[k++])
+        dec.decode(expected, is_last, encoded.data() + offset, blocks[k]);
+
+    base64_dec dec_parallel;
+    vector<unsigned char> out;
+    bool is_last_parallel = false;
+    for (size_t k = 0, offset = 0; k < blocks.size() && !is_last_parallel; offset += blocks[k++])
+        dec_parallel.decode_parallel(out, is_last_parallel, encoded.data() + offset, blocks[k], threads);
+
+    BENCH_CHECK(out == expected, "decode, size %zu, %zu threads", encoded.size(), threads);
+    BENCH_CHECK(is_last_parallel == is_last, "decode is_last, size %zu, %zu threads", encoded.size(), threads);
+}
+
+
+///
+/// Checks exceptions thrown on worker threads reach the calling thread
+///
+static void test_exceptions()
+{
+    for (size_t thrower = 0; thrower < 4; thrower++) {
+        atomic<size_t> calls(0);
+        string what;
+        try {
+            parallel_for(4, [&](size_t k) {
+                calls++;
+                if (k >= thrower)
+                    throw runtime_error(to_string(k));
+            });
+        } catch (const runtime_error &e) {
+            what = e.what();
+        }
+        BENCH_CHECK(calls == 4, "%zu calls, expected 4", calls.load());
+        BENCH_CHECK(what == to_string(thrower), "exception \"%s\" rethrown, expected \"%zu\"", what.c_str(), thrower);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_iterations = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        s_rng = bench::rng(strtoull(argv[2], NULL, 0));
+
+    test_exceptions();
+    for (bench::isa level : bench::isa_all) {
+        if (!bench::isa_supported(level)) {
+            printf("%-8s skipped: not supported\n", bench::isa_name(level));
+            continue;
+        }
+        bench::set_isa(level);
+        for (size_t i = 0; i < s_iterations; i++) {
+            vector<unsigned char> data(s_rng.below(2) ? s_rng.below(20) : s_rng.below(3000));
+            s_rng.fill(data.data(), data.size());
+
+            test_encode<base64_std , char   >(data);
+            test_encode<base64_mime, char   >(data);
+            test_encode<base64_mime, wchar_t>(data);
+
+            string encoded;
+            base64_enc().encode(encoded, data.data(), data.size());
+            test_decode<char   >(add_noise<char   >(encoded));
+            test_decode<wchar_t>(add_noise<wchar_t>(encoded));
+        }
+        printf("%-8s %zu iterations\n", bench::isa_name(level), s_iterations);
+    }
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
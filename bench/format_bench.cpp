@@ -0,0 +1,223 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Throughput benchmark of string formatting
+//
+// Measures sprintf() into std::string for results of 100 B, 4 KiB and 64 KiB,
+// against the original implementation. Results are formatted into a new string
+// each time, and into the same string reused. Parsing of large widths and
+// precisions, and templates or arguments pointing into the target string are
+// checked first.
+//
+// Usage: format_bench [filter]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+#include "reference.h"
+
+using namespace std;
+
+
+static const char *s_filter = NULL;
+static const size_t s_sizes[] = { 100, 0x1000, 0x10000 };
+
+
+///
+/// Runs and reports one benchmark, unless filtered out
+///
+template<class _Fn>
+static void run(const char *impl, const char *format, const char *mode, size_t size, _Fn fn)
+{
+    char name[128];
+    snprintf(name, _countof(name), "%s/%s/%s", impl, format, mode);
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    bench::report_mbps(name, size, bench::rate(fn));
+}
+
+
+///
+/// Returns true when parsing the format string throws
+///
+static bool parse_throws(const char *fmt, winstd::format_spec &spec)
+{
+    try {
+        winstd::format_parse(fmt, 0, spec);
+        return false;
+    } catch (const invalid_argument &) {
+        return true;
+    }
+}
+
+
+///
+/// Checks width and precision parse without overflowing `int`
+///
+static void check_format_parse()
+{
+    winstd::format_spec spec;
+    BENCH_CHECK(!parse_throws("%2147483639d", spec) && spec.width == 2147483639, "width %d, expected 2147483639", spec.width);
+    BENCH_CHECK(!parse_throws("%.2147483639d", spec) && spec.precision == 2147483639, "precision %d, expected 2147483639", spec.precision);
+    BENCH_CHECK(!parse_throws("%0000000000000000007d", spec) && spec.width == 7, "width %d, expected 7", spec.width);
+    BENCH_CHECK(parse_throws("%2147483640d", spec), "width 2147483640 accepted");
+    BENCH_CHECK(parse_throws("%.2147483648d", spec), "precision above INT_MAX accepted");
+    BENCH_CHECK(parse_throws("%99999999999d", spec), "width above INT_MAX accepted");
+}
+
+
+///
+/// Checks sprintf() with the template pointing into the string being formatted
+///
+static void check_sprintf_aliasing()
+{
+    static const struct {
+        const char *name;
+        string format;
+    } tests[] = {
+        { "integer", "%d" },
+        { "short", "%d: %d" },
+        { "long", "%d" + string(1096, '.') + "%d" },
+        { "growing", "%1100d0123456789abcdef" },
+    };
+    for (const auto &t : tests) {
+        char expected[0x1000];
+        snprintf(expected, _countof(expected), t.format.c_str(), 123456789, 7);
+        string s(t.format);
+        sprintf(s, s.c_str(), 123456789, 7);
+        BENCH_CHECK(s == expected, "sprintf %s: aliased template produced %zu characters, expected %zu", t.name, s.size(), strlen(expected));
+    }
+}
+
+
+///
+/// Checks GUID arguments, including ones of classes derived from GUID
+///
+static void check_format_guid()
+{
+    const winstd::guid g(0x01234567, 0x89ab, 0xcdef, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef);
+    const GUID &raw = g;
+    static const char expected[] = "{01234567-89AB-CDEF-0123-456789ABCDEF}";
+    string s;
+    winstd::format(s, "%s", raw);
+    BENCH_CHECK(s == expected, "format: GUID produced \"%s\"", s.c_str());
+    winstd::format(s, "%s", g);
+    BENCH_CHECK(s == expected, "format: winstd::guid produced \"%s\"", s.c_str());
+    winstd::format(s, WINSTD_FORMAT("%s"), g);
+    BENCH_CHECK(s == expected, "format: winstd::guid with compiled format produced \"%s\"", s.c_str());
+    winstd::format_msg(s, "%1", g);
+    BENCH_CHECK(s == expected, "format_msg: winstd::guid produced \"%s\"", s.c_str());
+}
+
+
+///
+/// Checks format() with the format string or arguments pointing into the string being formatted
+///
+static void check_format_aliasing()
+{
+    string s("error");
+    winstd::format(s, "%s: %d", s.c_str(), 5);
+    BENCH_CHECK(s == "error: 5", "format: aliased argument produced \"%s\"", s.c_str());
+    s = "error";
+    winstd::format(s, "%s: %d", s, 5);
+    BENCH_CHECK(s == "error: 5", "format: aliased string argument produced \"%s\"", s.c_str());
+    s = "error";
+    winstd::format(s, WINSTD_FORMAT("%s: %d"), s.c_str(), 5);
+    BENCH_CHECK(s == "error: 5", "format: aliased argument of compiled format produced \"%s\"", s.c_str());
+    s = "%d: %s" + string(100, '.');
+    winstd::format(s, s.c_str(), 5, "error");
+    BENCH_CHECK(s == "5: error" + string(100, '.'), "format: aliased format string produced \"%s\"", s.c_str());
+    wstring ws(L"error");
+    winstd::format(ws, L"%s: %d", ws.c_str(), 5);
+    BENCH_CHECK(ws == L"error: 5", "format: aliased wide argument produced %zu characters", ws.size());
+}
+
+
+///
+/// Checks format_msg() with arguments pointing into the string being formatted
+///
+static void check_format_msg_aliasing()
+{
+    string m("open");
+    winstd::format_msg(m, "%1 failed", m);
+    BENCH_CHECK(m == "open failed", "format_msg: aliased string argument produced \"%s\"", m.c_str());
+    m = "open";
+    static const winstd::msg_format fmt("%2: %1!s! failed");
+    winstd::format_msg(m, fmt, m.c_str(), 5);
+    BENCH_CHECK(m == "5: open failed", "format_msg: aliased argument produced \"%s\"", m.c_str());
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    check_format_parse();
+    check_sprintf_aliasing();
+    check_format_guid();
+    check_format_aliasing();
+    check_format_msg_aliasing();
+
+    for (size_t size : s_sizes) {
+        // Both templates produce `size` characters.
+        const string payload(size - 6, 'x');
+        const int width = (int)size - 6;
+        string str;
+
+        run("reference", "string", "new", size, [&] {
+            string s;
+            reference::sprintf(s, "%s: %04u", payload.c_str(), 42u);
+        });
+        run("sprintf", "string", "new", size, [&] {
+            string s;
+            sprintf(s, "%s: %04u", payload.c_str(), 42u);
+        });
+        run("reference", "string", "reused", size, [&] {
+            reference::sprintf(str, "%s: %04u", payload.c_str(), 42u);
+        });
+        run("sprintf", "string", "reused", size, [&] {
+            sprintf(str, "%s: %04u", payload.c_str(), 42u);
+        });
+
+        run("reference", "padded", "new", size, [&] {
+            string s;
+            reference::sprintf(s, "%*u: %04u", width, 7u, 42u);
+        });
+        run("sprintf", "padded", "new", size, [&] {
+            string s;
+            sprintf(s, "%*u: %04u", width, 7u, 42u);
+        });
+        run("reference", "padded", "reused", size, [&] {
+            reference::sprintf(str, "%*u: %04u", width, 7u, 42u);
+        });
+        run("sprintf", "padded", "reused", size, [&] {
+            sprintf(str, "%*u: %04u", width, 7u, 42u);
+        });
+    }
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+//
+// Must not compile: the format string declared using WINSTD_FORMAT() does not
+// match argument types. Built by the format_static_assert test, which expects
+// the static assertion message in the compiler output.
+//
+
+#include "StdAfx.h"
+
+void format_static_assert()
+{
+    std::string s;
+    winstd::format(s, WINSTD_FORMAT("%d"), "not an integer");
+}
@@ -0,0 +1,302 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+//
+// Differential test of type-safe formatting
+//
+// winstd::format() is checked against the C library snprintf() on random
+// conversion specifications of every kind: flags, fixed and `*` width and
+// precision, and length modifiers. Each result is checked formatted into a
+// single-byte string, a wide string and a buffer truncated to random
+// capacity.
+//
+// Format strings declared using WINSTD_FORMAT() are checked to give the same
+// results as when parsed at run time. The compile-time parser and argument
+// check are verified by static assertions. That mismatching arguments fail to
+// compile is tested by the format_static_assert test.
+//
+// Usage: format_test [iterations [seed]]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace std;
+using namespace winstd;
+
+
+static size_t s_iterations = 200000;
+static bench::rng s_rng;
+
+
+//
+// Compile-time parser
+//
+static_assert(format_count("") == 0, "empty format string");
+static_assert(format_count("text") == 1, "literal text only");
+static_assert(format_count("a%db%%c%s") == 3, "literal text, conversions and escaped percent sign");
+
+static constexpr format_ops<1> s_ops = format_compile<1>("x%-+08.3llde");
+static_assert(s_ops.spec[0].lit_start == 0 && s_ops.spec[0].lit_len == 1, "literal text before conversion");
+static_assert(s_ops.spec[0].flags == (format_spec::flag_left | format_spec::flag_sign | format_spec::flag_zero), "flags");
+static_assert(s_ops.spec[0].width == 8 && s_ops.spec[0].precision == 3, "width and precision");
+static_assert(s_ops.spec[0].size == 8 && s_ops.spec[0].conv == 'd', "length modifier and conversion");
+static_assert(s_ops.spec[1].lit_start == 11 && s_ops.spec[1].lit_len == 1 && !s_ops.spec[1].conv, "literal text after conversion");
+
+static constexpr format_ops<1> s_ops_star = format_compile<1>(L"%*.*s");
+static_assert(s_ops_star.spec[0].width == format_spec::from_arg && s_ops_star.spec[0].precision == format_spec::from_arg, "width and precision from arguments");
+
+static_assert(format_check("%d %s", format_arg_kinds<int, const char*>::value, 2), "matching arguments");
+static_assert(format_check("%*.*f %p", format_arg_kinds<int, unsigned, double, void*>::value, 4), "width and precision arguments");
+static_assert(format_check(L"%s %s %s", format_arg_kinds<wstring, string, guid>::value, 3), "strings of both character types and GUIDs");
+static_assert(!format_check("%d %s", format_arg_kinds<const char*, int>::value, 2), "mismatching arguments");
+static_assert(!format_check("%*d", format_arg_kinds<double, int>::value, 2), "non-integer width");
+static_assert(!format_check("%d", format_arg_kinds<int, int>::value, 2), "too many arguments");
+static_assert(!format_check("%d %d", format_arg_kinds<int>::value, 1), "too few arguments");
+
+
+///
+/// Returns random literal text
+///
+static const char *random_text()
+{
+    static const char *text[] = { "", "", "x", "value: ", "%%", "a%%b " };
+    return text[s_rng.below(_countof(text))];
+}
+
+
+///
+/// Checks one format string against `snprintf()`
+///
+template<class... _Args>
+static void check(const char *fmt, const _Args&... args)
+{
+    char expected[0x400];
+    int n = snprintf(expected, _countof(expected), fmt, args...);
+    if (n < 0 || (size_t)n >= _countof(expected)) {
+        BENCH_CHECK(false, "\"%s\": snprintf() returned %d", fmt, n);
+        return;
+    }
+
+    string s("previous content");
+    size_t len = format(s, fmt, args...);
+    BENCH_CHECK(len == (size_t)n && s == expected, "\"%s\": \"%s\", expected \"%s\"", fmt, s.c_str(), expected);
+
+    wstring wfmt(fmt, fmt + strlen(fmt)), ws;
+    len = format(ws, wfmt.c_str(), args...);
+    BENCH_CHECK(len == (size_t)n && ws == wstring(expected, expected + n), "\"%s\": wide result differs from \"%s\"", fmt, expected);
+
+    char buf[32];
+    size_t capacity = s_rng.below(_countof(buf) + 1);
+    memset(buf, '?', sizeof(buf));
+    len = format(buf, capacity, fmt, args...);
+    bool ok = len == (size_t)n;
+    if (capacity) {
+        size_t kept = std::min<size_t>(n, capacity - 1);
+        ok = ok && memcmp(buf, expected, kept) == 0 && buf[kept] == 0;
+    }
+    for (size_t i = capacity; i < _countof(buf); i++)
+        ok = ok && buf[i] == '?';
+    BENCH_CHECK(ok, "\"%s\": buffer of %zu characters holds \"%.*s\", expected \"%s\"", fmt, capacity, (int)std::min<size_t>(capacity, _countof(buf)), buf, expected);
+}
+
+
+///
+/// Checks one conversion, passing width and precision arguments when `*` is used
+///
+template<class T>
+static void check_conv(const string &fmt, bool star_width, bool star_precision, const T &value)
+{
+    int width = (int)s_rng.below(41) - 20, precision = (int)s_rng.below(24) - 3;
+    if (star_width && star_precision)
+        check(fmt.c_str(), width, precision, value);
+    else if (star_width)
+        check(fmt.c_str(), width, value);
+    else if (star_precision)
+        check(fmt.c_str(), precision, value);
+    else
+        check(fmt.c_str(), value);
+}
+
+
+///
+/// Returns random integer of all magnitudes
+///
+static uint64_t random_int()
+{
+    uint64_t v = s_rng.next();
+    switch (s_rng.below(4)) {
+    case 0: return v >> s_rng.below(64);
+    case 1: return (uint64_t)0 - (v >> s_rng.below(64));
+    case 2: return s_rng.below(3) - 1;
+    default: return v;
+    }
+}
+
+
+///
+/// Checks random conversion
+///
+static void check_random()
+{
+    static const char *int_convs[] = { "d", "i", "u", "o", "x", "X" };
+    static const char *int_mods[] = { "", "hh", "h", "l", "ll", "j", "z", "t" };
+    static const char *float_convs[] = { "e", "E", "f", "F", "g", "G", "a", "A" };
+    static const char *strings[] = { "", "a", "text", "longer text than most widths" };
+    static const double floats[] = { 0.0, -0.0, 1.0, -1.5, 0.1, 123456.789, 1e-300, 1e300, 3.0e-310, HUGE_VAL, -HUGE_VAL, NAN };
+
+    size_t kind = s_rng.below(4);
+    const char *conv =
+        kind == 0 ? int_convs[s_rng.below(_countof(int_convs))] :
+        kind == 1 ? float_convs[s_rng.below(_countof(float_convs))] :
+        kind == 2 ? "c" : "s";
+    bool is_signed = kind == 0 && (conv[0] == 'd' || conv[0] == 'i');
+
+    // Only flags with defined behavior: '#' for octal, hexadecimal and floating point; '0' for numbers.
+    string fmt(random_text());
+    fmt += '%';
+    for (const char *f = "-+ #0"; *f; f++) {
+        if (s_rng.below(4))
+            continue;
+        if (*f == '#' && !(kind == 1 || (kind == 0 && conv[0] != 'd' && conv[0] != 'i' && conv[0] != 'u')))
+            continue;
+        if ((*f == '0' || *f == '+' || *f == ' ') && kind >= 2)
+            continue;
+        fmt += *f;
+    }
+    bool star_width = false, star_precision = false;
+    switch (s_rng.below(3)) {
+    case 0: break;
+    case 1: fmt += to_string(s_rng.below(21)); break;
+    default: fmt += '*'; star_width = true;
+    }
+    if (kind != 2) {
+        switch (s_rng.below(3)) {
+        case 0: break;
+        case 1: fmt += '.'; fmt += to_string(s_rng.below(21)); break;
+        default: fmt += ".*"; star_precision = true;
+        }
+    }
+    const char *mod = kind == 0 ? int_mods[s_rng.below(_countof(int_mods))] : "";
+    fmt += mod;
+    fmt += conv;
+    fmt += random_text();
+
+    if (kind == 0) {
+        uint64_t v = random_int();
+        string m(mod);
+        if (m == "hh" || m == "h" || m.empty()) {
+            if (is_signed) check_conv(fmt, star_width, star_precision, (int)v);
+            else           check_conv(fmt, star_width, star_precision, (unsigned int)v);
+        } else if (m == "l") {
+            if (is_signed) check_conv(fmt, star_width, star_precision, (long)v);
+            else           check_conv(fmt, star_width, star_precision, (unsigned long)v);
+        } else if (m == "ll") {
+            if (is_signed) check_conv(fmt, star_width, star_precision, (long long)v);
+            else           check_conv(fmt, star_width, star_precision, (unsigned long long)v);
+        } else if (m == "j") {
+            if (is_signed) check_conv(fmt, star_width, star_precision, (intmax_t)v);
+            else           check_conv(fmt, star_width, star_precision, (uintmax_t)v);
+        } else {
+            if (is_signed) check_conv(fmt, star_width, star_precision, (ptrdiff_t)v);
+            else           check_conv(fmt, star_width, star_precision, (size_t)v);
+        }
+    } else if (kind == 1) {
+        double v = s_rng.below(2) ? floats[s_rng.below(_countof(floats))] : (double)(int64_t)s_rng.next() / (double)(s_rng.next() | 1);
+        check_conv(fmt, star_width, star_precision, v);
+    } else if (kind == 2)
+        check_conv(fmt, star_width, star_precision, (int)(' ' + s_rng.below(0x5f)));
+    else
+        check_conv(fmt, star_width, star_precision, strings[s_rng.below(_countof(strings))]);
+}
+
+
+///
+/// Checks a format string declared using `WINSTD_FORMAT()` gives the same results as parsed at run time
+///
+template<class _Fmt, class... _Args>
+static void check_parity(const _Fmt &fmt, const _Args&... args)
+{
+    typedef typename _Fmt::elem_type elem_type;
+    basic_string<elem_type> compiled, runtime;
+    size_t len_compiled = format(compiled, fmt, args...), len_runtime = format(runtime, _Fmt::c_str(), args...);
+    BENCH_CHECK(len_compiled == len_runtime && compiled == runtime, "\"%s\": compiled and run-time format strings differ", string(_Fmt::c_str(), _Fmt::c_str() + char_traits<elem_type>::length(_Fmt::c_str())).c_str());
+
+    elem_type buf_compiled[16], buf_runtime[16];
+    len_compiled = format(buf_compiled, _countof(buf_compiled), fmt, args...);
+    len_runtime = format(buf_runtime, _countof(buf_runtime), _Fmt::c_str(), args...);
+    BENCH_CHECK(len_compiled == len_runtime && char_traits<elem_type>::compare(buf_compiled, buf_runtime, std::min<size_t>(len_runtime + 1, _countof(buf_runtime))) == 0, "compiled and run-time format strings differ in buffer");
+}
+
+
+#define CHECK_PARITY(fmt, ...) \
+    do { \
+        check_parity(WINSTD_FORMAT(fmt), __VA_ARGS__); \
+        check_parity(WINSTD_FORMAT(L ## fmt), __VA_ARGS__); \
+    } while (0)
+
+
+static void test_parity()
+{
+    const guid g(0x01234567, 0x89ab, 0xcdef, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef);
+    const string str("string");
+    const wstring wstr(L"wide string");
+    int value = 42;
+
+    CHECK_PARITY("%d", -123);
+    CHECK_PARITY("%5d|%-5d|%05d|%+d|% d", 1, 2, 3, 4, 5);
+    CHECK_PARITY("%hhd %hd %ld %lld %I64d %I32d %zu", 0x1ff, 0x1ffff, -1L, -1LL, 0x7fffffffffffffffLL, -1, (size_t)-1);
+    CHECK_PARITY("%#o %#x %#X %o %x %X", 8u, 255u, 255u, 0u, 0u, 0xabcdefu);
+    CHECK_PARITY("%.0d|%.5u|%8.3x", 0, 7u, 0xfu);
+    CHECK_PARITY("%*d|%-*d|%.*d|%*.*d", 6, 1, 6, 2, 4, 3, -8, 3, 4);
+    CHECK_PARITY("%c%c%c", 'a', 'b', 'c');
+    CHECK_PARITY("%s|%10s|%-10s|%.3s", "text", "right", "left", "truncated");
+    CHECK_PARITY("%s %s %s %s", str, wstr, str.c_str(), wstr.c_str());
+    CHECK_PARITY("%s|%40s|%.9s", g, g, g);
+    CHECK_PARITY("%e %f %g %a %10.3f %-+10.2e", 1.5, -2.25, 1e-10, 0.5, 3.14159, 12345.678);
+    CHECK_PARITY("%p %p", &value, (void*)NULL);
+    CHECK_PARITY("100%% of %d", 7);
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_iterations = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        s_rng = bench::rng(strtoull(argv[2], NULL, 0));
+
+    test_parity();
+    for (size_t i = 0; i < s_iterations; i++)
+        check_random();
+    printf("%zu iterations\n", s_iterations);
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
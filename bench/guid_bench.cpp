@@ -0,0 +1,128 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Throughput benchmark of the GUID parser
+//
+// Parses a table of random braced GUIDs with the strtoul() based parser
+// WinStd used before, the portable guid_parse() template, and the exported
+// guid_parse() overloads at every instruction set level the CPU supports.
+//
+// Usage: guid_bench [filter]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+#include "reference.h"
+
+using namespace std;
+using namespace winstd;
+
+
+static const char *s_filter = NULL;
+static const size_t s_count = 1024;
+
+
+///
+/// Runs and reports one benchmark, unless filtered out
+///
+/// \param[in] name  Benchmark name
+/// \param[in] chr   Character type name
+/// \param[in] fn    Benchmark parsing `s_count` GUIDs
+///
+template<class _Fn>
+static void run(const char *name, const char *chr, _Fn fn)
+{
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    bench::report(name, chr, bench::rate(fn)*s_count/1e6, "M/s");
+}
+
+
+template<class _Tchr>
+static void make_table(vector<_Tchr> &table)
+{
+    bench::rng rng;
+    table.resize(s_count*39);
+    for (size_t i = 0; i < s_count; i++) {
+        GUID guid;
+        rng.fill(&guid, sizeof(guid));
+        _Tchr *str = table.data() + i*39;
+        str[guid_format(str, guid) - str] = 0;
+    }
+}
+
+
+///
+/// Parses every GUID in the table and keeps the result alive
+///
+template<class _Tchr, class _Parse>
+static void parse_all(const vector<_Tchr> &table, _Parse parse)
+{
+    unsigned long sum = 0;
+    for (size_t i = 0; i < s_count; i++) {
+        GUID guid;
+        if (parse(table.data() + i*39, guid))
+            sum += guid.Data1;
+    }
+    volatile unsigned long result = sum;
+    (void)result;
+}
+
+
+template<class _Tchr>
+static void bench_guid(const char *chr)
+{
+    vector<_Tchr> table;
+    make_table(table);
+
+    run("guid_parse<> portable", chr, [&] {
+        parse_all(table, [](const _Tchr *str, GUID &guid) { return guid_parse<_Tchr>(str, guid) != NULL; });
+    });
+    for (bench::isa level : bench::isa_all) {
+        if (!bench::isa_supported(level))
+            continue;
+        bench::set_isa(level);
+        char name[64];
+        snprintf(name, _countof(name), "guid_parse %s", bench::isa_name(level));
+        run(name, chr, [&] {
+            parse_all(table, [](const _Tchr *str, GUID &guid) { return guid_parse(str, guid) != NULL; });
+        });
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    {
+        vector<char> table;
+        make_table(table);
+        run("StringToGuidA reference", "char", [&] {
+            parse_all(table, [](const char *str, GUID &guid) { return reference::StringToGuidA(str, &guid); });
+        });
+    }
+    bench_guid<char   >("char"   );
+    bench_guid<wchar_t>("wchar_t");
+    return 0;
+}
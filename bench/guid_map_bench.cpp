@@ -0,0 +1,238 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Lookup benchmark of maps keyed by winstd::guid
+//
+// A flat open-addressing map using std::hash<winstd::guid> is compared against
+// std::unordered_map with the same hash, std::unordered_map with the byte-wise
+// FNV-1a hash and memcmp() projects used to roll for GUID keys, and std::map
+// using winstd::guid ordering. Lookups alternate between present and missing
+// keys in random order.
+//
+// Usage: guid_map_bench [filter]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+using namespace winstd;
+
+
+static const char *s_filter = NULL;
+static const size_t s_lookups = 1024;
+
+
+///
+/// Runs and reports one benchmark, unless filtered out
+///
+/// \param[in] name  Benchmark name
+/// \param[in] size  Number of keys in the map
+/// \param[in] fn    Benchmark performing `s_lookups` lookups
+///
+template<class _Fn>
+static void run(const char *name, size_t size, _Fn fn)
+{
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    char arg[32];
+    snprintf(arg, _countof(arg), "%zu", size);
+    bench::report(name, arg, 1e9/(bench::rate(fn)*s_lookups), "ns/lookup");
+}
+
+
+///
+/// Byte-wise FNV-1a hash of GUID
+///
+struct fnv1a_hash
+{
+    size_t operator()(const GUID &g) const
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char*>(&g);
+        unsigned long long h = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < sizeof(GUID); i++)
+            h = (h ^ p[i]) * 0x100000001b3ull;
+        return (size_t)h;
+    }
+};
+
+
+///
+/// GUID comparison using memcmp()
+///
+struct memcmp_equal
+{
+    bool operator()(const GUID &a, const GUID &b) const
+    {
+        return memcmp(&a, &b, sizeof(GUID)) == 0;
+    }
+};
+
+
+///
+/// Flat open-addressing map with linear probing
+///
+/// Keys and values are stored inline in a power-of-two table kept at most half full. Null GUID marks empty slots.
+///
+template<class _Ty>
+class flat_guid_map
+{
+public:
+    flat_guid_map(size_t count) : m_mask(1), m_slots()
+    {
+        while (m_mask + 1 < 2*count)
+            m_mask = 2*m_mask + 1;
+        m_slots.resize(m_mask + 1);
+    }
+
+    void insert(const guid &key, const _Ty &value)
+    {
+        for (size_t i = std::hash<guid>()(key) & m_mask;; i = (i + 1) & m_mask) {
+            if (m_slots[i].first == key || m_slots[i].first == guid()) {
+                m_slots[i].first  = key;
+                m_slots[i].second = value;
+                return;
+            }
+        }
+    }
+
+    const _Ty* find(const guid &key) const
+    {
+        for (size_t i = std::hash<guid>()(key) & m_mask;; i = (i + 1) & m_mask) {
+            if (m_slots[i].first == key)
+                return &m_slots[i].second;
+            if (m_slots[i].first == guid())
+                return NULL;
+        }
+    }
+
+protected:
+    size_t m_mask;                          ///< Index mask: table size minus one
+    vector<pair<guid, _Ty> > m_slots;       ///< Table
+};
+
+
+static void random_guid(bench::rng &rng, guid &g)
+{
+    do {
+        rng.fill(static_cast<GUID*>(&g), sizeof(GUID));
+    } while (g == guid());
+}
+
+
+///
+/// Builds maps of `size` random keys and measures lookups
+///
+static void bench_size(size_t size)
+{
+    bench::rng rng;
+    vector<guid> keys(size), probes(s_lookups);
+    for (size_t i = 0; i < size; i++)
+        random_guid(rng, keys[i]);
+    // Every other probe is a key in the map. Values are key indices, so all maps must find the same sum.
+    size_t expected = 0;
+    for (size_t i = 0; i < s_lookups; i++) {
+        if (i & 1) {
+            size_t k = rng.below(size);
+            probes[i] = keys[k];
+            expected += k;
+        } else
+            random_guid(rng, probes[i]);
+    }
+
+    {
+        flat_guid_map<size_t> m(size);
+        for (size_t i = 0; i < size; i++)
+            m.insert(keys[i], i);
+        run("flat_guid_map std::hash<guid>", size, [&] {
+            size_t sum = 0;
+            for (const guid &g : probes) {
+                const size_t *v = m.find(g);
+                if (v) sum += *v;
+            }
+            BENCH_CHECK(sum == expected, "flat_guid_map: %zu, expected %zu", sum, expected);
+        });
+    }
+
+    {
+        unordered_map<guid, size_t> m;
+        m.reserve(size);
+        for (size_t i = 0; i < size; i++)
+            m.emplace(keys[i], i);
+        run("unordered_map std::hash<guid>", size, [&] {
+            size_t sum = 0;
+            for (const guid &g : probes) {
+                auto v = m.find(g);
+                if (v != m.end()) sum += v->second;
+            }
+            BENCH_CHECK(sum == expected, "unordered_map: %zu, expected %zu", sum, expected);
+        });
+    }
+
+    {
+        unordered_map<GUID, size_t, fnv1a_hash, memcmp_equal> m;
+        m.reserve(size);
+        for (size_t i = 0; i < size; i++)
+            m.emplace(keys[i], i);
+        run("unordered_map FNV-1a memcmp", size, [&] {
+            size_t sum = 0;
+            for (const guid &g : probes) {
+                auto v = m.find(g);
+                if (v != m.end()) sum += v->second;
+            }
+            BENCH_CHECK(sum == expected, "unordered_map FNV-1a: %zu, expected %zu", sum, expected);
+        });
+    }
+
+    {
+        map<guid, size_t> m;
+        for (size_t i = 0; i < size; i++)
+            m.emplace(keys[i], i);
+        run("map guid::operator<", size, [&] {
+            size_t sum = 0;
+            for (const guid &g : probes) {
+                auto v = m.find(g);
+                if (v != m.end()) sum += v->second;
+            }
+            BENCH_CHECK(sum == expected, "map: %zu, expected %zu", sum, expected);
+        });
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    for (size_t size : { (size_t)0x400, (size_t)0x10000, (size_t)0x100000 })
+        bench_size(size);
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Test of the GUID parser
+//
+// guid_parse() is checked against a character-by-character model of the
+// `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` layout, with narrow and wide
+// characters, at every instruction set level the CPU supports:
+//
+// - random GUIDs formatted by guid_format() in every case and brace style,
+// - every character value at every position of the string,
+// - every truncation, with the terminator at every distance from an
+//   inaccessible page, so any read past the string faults.
+//
+// Usage: guid_test [iterations [seed]]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+#include "reference.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace winstd;
+
+
+static size_t s_iterations = 20;
+static bench::rng s_rng;
+
+
+///
+/// Returns the character class at position `i`: `{`, `}`, `-`, or `x` for a hexadecimal digit
+///
+static char layout(size_t i, bool braces)
+{
+    if (braces) {
+        if (i == 0)
+            return '{';
+        if (i == 37)
+            return '}';
+        i--;
+    }
+    return i == 8 || i == 13 || i == 18 || i == 23 ? '-' : 'x';
+}
+
+
+///
+/// Returns nibble value of a hexadecimal digit, or -1
+///
+static int nibble(unsigned int c)
+{
+    if ('0' <= c && c <= '9') return c - '0';
+    if ('a' <= c && c <= 'f') return c - 'a' + 10;
+    if ('A' <= c && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+
+///
+/// Parses GUID the slow way: returns the number of characters, or 0 when `str` does not match the layout
+///
+template<class _Tchr>
+static size_t model_parse(const _Tchr *str, GUID &guid)
+{
+    bool braces = str[0] == '{';
+    size_t len = braces ? 38 : 36;
+    unsigned char nibbles[32];
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned int c = (typename make_unsigned<_Tchr>::type)str[i];
+        char cls = layout(i, braces);
+        if (cls == 'x') {
+            int d = nibble(c);
+            if (d < 0)
+                return 0;
+            nibbles[n++] = (unsigned char)d;
+        } else if (c != (unsigned int)cls)
+            return 0;
+    }
+
+    unsigned char bytes[16];
+    for (size_t i = 0; i < 16; i++)
+        bytes[i] = (unsigned char)(nibbles[2*i] << 4 | nibbles[2*i + 1]);
+    guid.Data1 = (unsigned long)bytes[0] << 24 | (unsigned long)bytes[1] << 16 | (unsigned long)bytes[2] << 8 | bytes[3];
+    guid.Data2 = (unsigned short)(bytes[4] << 8 | bytes[5]);
+    guid.Data3 = (unsigned short)(bytes[6] << 8 | bytes[7]);
+    memcpy(guid.Data4, bytes + 8, 8);
+    return len;
+}
+
+
+static void random_guid(GUID &guid)
+{
+    guid.Data1 = (unsigned long)s_rng.next();
+    guid.Data2 = (unsigned short)s_rng.next();
+    guid.Data3 = (unsigned short)s_rng.next();
+    s_rng.fill(guid.Data4, sizeof(guid.Data4));
+}
+
+
+///
+/// Formats random GUID in random case and brace style, and returns its length
+///
+template<class _Tchr>
+static size_t random_string(_Tchr str[38], GUID &guid)
+{
+    random_guid(guid);
+    return guid_format(str, guid, s_rng.next() & 1, s_rng.next() & 1) - str;
+}
+
+
+///
+/// Compares guid_parse() against the model
+///
+template<class _Tchr>
+static void check(const _Tchr *str, const char *what, size_t pos, unsigned int value)
+{
+    GUID expected, actual;
+    size_t len = model_parse(str, expected);
+    const _Tchr *end = guid_parse(str, actual);
+    if (!len) {
+        BENCH_CHECK(end == NULL, "%s: position %zu, value 0x%x accepted", what, pos, value);
+        return;
+    }
+    BENCH_CHECK(end == str + len, "%s: position %zu, value 0x%x: parsed %td characters, expected %zu", what, pos, value, end ? end - str : (ptrdiff_t)-1, len);
+    if (end)
+        BENCH_CHECK(memcmp(&actual, &expected, sizeof(GUID)) == 0, "%s: position %zu, value 0x%x: GUID mismatch", what, pos, value);
+}
+
+
+template<class _Tchr>
+static void test_round_trip(const char *what)
+{
+    for (size_t i = 0; i < 1000; i++) {
+        GUID guid, parsed;
+        _Tchr str[39];
+        size_t len = random_string(str, guid);
+        str[len] = 0;
+        const _Tchr *end = guid_parse(str, parsed);
+        BENCH_CHECK(end == str + len, "%s: round trip of %zu characters failed", what, len);
+        if (end)
+            BENCH_CHECK(memcmp(&parsed, &guid, sizeof(GUID)) == 0, "%s: round trip GUID mismatch", what);
+    }
+}
+
+
+///
+/// Compares the reference parser against the model on braced narrow strings
+///
+static void test_reference()
+{
+    for (size_t i = 0; i < 1000; i++) {
+        GUID guid, expected, parsed;
+        char str[39];
+        random_guid(guid);
+        size_t len = guid_format(str, guid, s_rng.next() & 1, true) - str;
+        str[len] = 0;
+        const char *end;
+        BENCH_CHECK(model_parse(str, expected) == len && reference::StringToGuidA(str, &parsed, &end) && end == str + len, "reference parser rejected %s", str);
+        BENCH_CHECK(memcmp(&parsed, &expected, sizeof(GUID)) == 0, "reference parser mismatch on %s", str);
+    }
+}
+
+
+///
+/// Replaces every character of a valid GUID string with every test value in turn
+///
+template<class _Tchr>
+static void test_every_value(const char *what, const vector<unsigned int> &values)
+{
+    for (int braces = 0; braces < 2; braces++) {
+        GUID guid;
+        _Tchr str[39];
+        random_guid(guid);
+        size_t len = guid_format(str, guid, s_rng.next() & 1, braces != 0) - str;
+        str[len] = 0;
+        for (size_t pos = 0; pos < len; pos++) {
+            _Tchr orig = str[pos];
+            for (unsigned int value : values) {
+                str[pos] = (_Tchr)value;
+                check(str, what, pos, value);
+            }
+            str[pos] = orig;
+        }
+    }
+}
+
+
+///
+/// Places every truncation of a valid GUID string at every distance from an inaccessible page
+///
+template<class _Tchr>
+static void test_truncation(const char *what, unsigned char *page_end)
+{
+    for (int braces = 0; braces < 2; braces++) {
+        GUID guid;
+        _Tchr src[38];
+        random_guid(guid);
+        size_t len = guid_format(src, guid, s_rng.next() & 1, braces != 0) - src;
+        for (size_t trunc = 0; trunc <= len; trunc++) {
+            for (size_t slack = 0; slack <= 64; slack++) {
+                _Tchr *str = reinterpret_cast<_Tchr*>(page_end) - (trunc + 1 + slack);
+                memcpy(str, src, trunc*sizeof(_Tchr));
+                str[trunc] = 0;
+                // Fill the rest of the page with what the complete string would continue with.
+                for (size_t i = trunc + 1; i < trunc + 1 + slack; i++)
+                    str[i] = i < len ? src[i] : '0';
+                check<_Tchr>(str, what, trunc, slack);
+            }
+        }
+    }
+}
+
+
+template<class _Tchr>
+static void test_all(const char *what, const vector<unsigned int> &values, unsigned char *page_end)
+{
+    test_round_trip<_Tchr>(what);
+    test_every_value<_Tchr>(what, values);
+    test_truncation<_Tchr>(what, page_end);
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_iterations = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        s_rng = bench::rng(strtoull(argv[2], NULL, 0));
+
+    // Two pages: the second one is inaccessible.
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *pages = reinterpret_cast<unsigned char*>(mmap(NULL, 2*page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (pages == MAP_FAILED || mprotect(pages + page_size, page_size, PROT_NONE) != 0) {
+        perror("guid_test");
+        return 1;
+    }
+
+    vector<unsigned int> values_char, values_wchar;
+    for (unsigned int c = 0; c < 0x100; c++)
+        values_char.push_back(c);
+    values_wchar = values_char;
+    // Wide characters that narrow to digits or dashes when truncated, and ones that saturate.
+    for (unsigned int c : { 0x0130u, 0x0141u, 0x0161u, 0x012du, 0x017bu, 0x017du, 0x3030u, 0x2d2du, 0x7f30u, 0x8030u, 0xff30u, 0xff10u, 0xffffu })
+        values_wchar.push_back(c);
+
+    test_reference();
+    for (bench::isa level : bench::isa_all) {
+        if (!bench::isa_supported(level)) {
+            printf("%-8s skipped: not supported\n", bench::isa_name(level));
+            continue;
+        }
+        bench::set_isa(level);
+        for (size_t i = 0; i < s_iterations; i++) {
+            test_all<char   >("char"   , values_char , pages + page_size);
+            test_all<wchar_t>("wchar_t", values_wchar, pages + page_size);
+        }
+        printf("%-8s %zu iterations\n", bench::isa_name(level), s_iterations);
+    }
+
+    munmap(pages, 2*page_size);
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
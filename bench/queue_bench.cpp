@@ -0,0 +1,544 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Throughput benchmark of the queues
+//
+// vector_queue is compared against std::deque: in steady state, with a fixed
+// number of elements queued while one is pushed and one popped per operation,
+// and growing from empty.
+//
+// spsc_queue is compared against vector_queue guarded by a mutex, passing
+// elements from a producer thread to a consumer thread one by one and in
+// batches.
+//
+// mpmc_queue is compared against vector_queue guarded by a mutex, with 1, 2,
+// 4, 8 and 16 producer threads and as many consumer threads.
+//
+// Usage: queue_bench [filter]
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+using namespace winstd;
+
+
+static const char *s_filter = NULL;
+
+
+///
+/// Runs and reports one benchmark, unless filtered out
+///
+/// \param[in] name  Benchmark name
+/// \param[in] arg   Benchmark argument
+/// \param[in] ops   Number of operations `fn()` performs
+/// \param[in] fn    Benchmark
+///
+template<class _Fn>
+static void run(const char *name, size_t arg, size_t ops, _Fn fn)
+{
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    char arg_str[32];
+    snprintf(arg_str, _countof(arg_str), "%zu", arg);
+    bench::report(name, arg_str, bench::rate(fn)*ops/1e6, "Mops/s");
+}
+
+
+///
+/// Pushes and pops `ops` elements, keeping the queue at its current length
+///
+template<class _Queue>
+static void steady(_Queue &q, size_t ops)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < ops; i++) {
+        q.push_back(i);
+        sum += q.front();
+        q.pop_front();
+    }
+    volatile uint64_t result = sum;
+    (void)result;
+}
+
+
+///
+/// Pushes `n` elements into an empty queue, then pops them
+///
+template<class _Queue>
+static void fill_drain(_Queue &q, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        q.push_back(i);
+    for (size_t i = 0; i < n; i++) {
+        sum += q.front();
+        q.pop_front();
+    }
+    volatile uint64_t result = sum;
+    (void)result;
+}
+
+
+///
+/// Checks absolute positions wrap around for any relative position
+///
+static void check_vector_queue_abs()
+{
+    vector_queue<uint64_t> q(5);
+    for (uint64_t i = 0; i < 3; i++) {
+        q.push_back(i);
+        q.pop_front();
+    }
+    for (size_t pos = 0; pos < 20; pos++)
+        BENCH_CHECK(q.abs(pos) == (3 + pos) % 5, "abs(%zu) is %zu, expected %zu", pos, q.abs(pos), (3 + pos) % 5);
+}
+
+
+static void bench_vector_queue()
+{
+    check_vector_queue_abs();
+
+    static const size_t depths[] = { 16, 1024, 0x10000 };
+    const size_t ops = 0x10000;
+
+    for (size_t depth : depths) {
+        {
+            vector_queue<uint64_t> q(depth + 1);
+            for (size_t i = 0; i < depth; i++) q.push_back(i);
+            run("vector_queue/steady", depth, ops, [&] { steady(q, ops); });
+        }
+        {
+            vector_queue<uint64_t, true> q(depth + 1);
+            for (size_t i = 0; i < depth; i++) q.push_back(i);
+            run("vector_queue<POW2>/steady", depth, ops, [&] { steady(q, ops); });
+        }
+        {
+            vector_queue<uint64_t, false, true> q(0);
+            for (size_t i = 0; i < depth; i++) q.push_back(i);
+            run("vector_queue<GROW>/steady", depth, ops, [&] { steady(q, ops); });
+        }
+        {
+            deque<uint64_t> q;
+            for (size_t i = 0; i < depth; i++) q.push_back(i);
+            run("std::deque/steady", depth, ops, [&] { steady(q, ops); });
+        }
+    }
+
+    for (size_t depth : depths) {
+        run("vector_queue<GROW>/fill-drain", depth, depth*2, [&] {
+            vector_queue<uint64_t, false, true> q(0);
+            fill_drain(q, depth);
+        });
+        vector_queue<uint64_t, false, true> reused(0);
+        run("vector_queue<GROW>/fill-drain-reused", depth, depth*2, [&] {
+            fill_drain(reused, depth);
+        });
+        run("std::deque/fill-drain", depth, depth*2, [&] {
+            deque<uint64_t> q;
+            fill_drain(q, depth);
+        });
+    }
+}
+
+
+///
+/// vector_queue guarded by a mutex: the way to share it between threads without a lock-free queue
+///
+template<class T>
+class locked_queue
+{
+public:
+    locked_queue(size_t size_max) : m_queue(size_max) {}
+
+    bool push(const T &v)
+    {
+        lock_guard<mutex> lock(m_lock);
+        if (m_queue.size() >= m_queue.capacity())
+            return false;
+        m_queue.push_back(v);
+        return true;
+    }
+
+    size_t push_n(const T *data, size_t count)
+    {
+        lock_guard<mutex> lock(m_lock);
+        size_t n = std::min<size_t>(count, m_queue.capacity() - m_queue.size());
+        for (size_t i = 0; i < n; i++)
+            m_queue.push_back(data[i]);
+        return n;
+    }
+
+    bool pop(T &v)
+    {
+        lock_guard<mutex> lock(m_lock);
+        if (m_queue.empty())
+            return false;
+        v = m_queue.front();
+        m_queue.pop_front();
+        return true;
+    }
+
+    size_t pop_n(T *data, size_t count)
+    {
+        lock_guard<mutex> lock(m_lock);
+        size_t n = std::min<size_t>(count, m_queue.size());
+        for (size_t i = 0; i < n; i++) {
+            data[i] = m_queue.front();
+            m_queue.pop_front();
+        }
+        return n;
+    }
+
+protected:
+    mutex m_lock;
+    vector_queue<T> m_queue;
+};
+
+
+///
+/// Passes `n` elements from a producer thread to the calling thread one by one
+///
+template<class _Queue>
+static void spsc_transfer(_Queue &q, size_t n)
+{
+    thread producer([&] {
+        for (uint64_t i = 0; i < n; i++)
+            while (!q.push(i))
+                this_thread::yield();
+    });
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v;
+        while (!q.pop(v))
+            this_thread::yield();
+        sum += v;
+    }
+    producer.join();
+    BENCH_CHECK(sum == (uint64_t)n*(n - 1)/2, "sum %llu, expected %llu", (unsigned long long)sum, (unsigned long long)n*(n - 1)/2);
+}
+
+
+///
+/// Passes `n` elements from a producer thread to the calling thread in batches of up to `batch` elements
+///
+template<class _Queue>
+static void spsc_transfer_n(_Queue &q, size_t n, size_t batch)
+{
+    thread producer([&] {
+        vector<uint64_t> data(batch);
+        for (size_t i = 0; i < n;) {
+            size_t count = std::min<size_t>(batch, n - i);
+            for (size_t j = 0; j < count; j++)
+                data[j] = i + j;
+            for (size_t j = 0; j < count;) {
+                size_t pushed = q.push_n(data.data() + j, count - j);
+                if (!pushed)
+                    this_thread::yield();
+                j += pushed;
+            }
+            i += count;
+        }
+    });
+    vector<uint64_t> data(batch);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n;) {
+        size_t popped = q.pop_n(data.data(), batch);
+        if (!popped)
+            this_thread::yield();
+        for (size_t j = 0; j < popped; j++)
+            sum += data[j];
+        i += popped;
+    }
+    producer.join();
+    BENCH_CHECK(sum == (uint64_t)n*(n - 1)/2, "sum %llu, expected %llu", (unsigned long long)sum, (unsigned long long)n*(n - 1)/2);
+}
+
+
+///
+/// Pushes `n` increasing elements in batches of `batch` into an overwriting queue and checks the consumer sees them in
+/// order
+///
+template<class _Queue>
+static void spsc_overwrite_n(_Queue &q, size_t n, size_t batch)
+{
+    atomic<bool> done(false);
+    thread producer([&] {
+        vector<uint64_t> data(batch);
+        for (size_t i = 0; i < n; i += batch) {
+            for (size_t j = 0; j < batch; j++)
+                data[j] = i + j + 1;
+            BENCH_CHECK(q.push_n(data.data(), batch) == batch, "overwriting push_n() dropped elements");
+        }
+        done = true;
+    });
+    vector<uint64_t> data(batch);
+    uint64_t last = 0;
+    for (;;) {
+        bool finished = done;
+        size_t popped = q.pop_n(data.data(), batch);
+        for (size_t j = 0; j < popped; j++) {
+            BENCH_CHECK(data[j] > last, "popped %llu after %llu", (unsigned long long)data[j], (unsigned long long)last);
+            last = data[j];
+        }
+        if (!popped) {
+            if (finished)
+                break;
+            this_thread::yield();
+        }
+    }
+    producer.join();
+    BENCH_CHECK(last == n, "last popped %llu, expected %zu", (unsigned long long)last, n);
+}
+
+
+///
+/// Checks overwriting batch push keeps the last elements
+///
+static void check_spsc_overwrite()
+{
+    spsc_queue<uint64_t, true> q(8);
+    uint64_t data[20];
+    for (size_t i = 0; i < _countof(data); i++)
+        data[i] = i;
+    BENCH_CHECK(q.push_n(data, 5) == 5, "push_n() failed");
+    BENCH_CHECK(q.push_n(data + 5, 5) == 5, "push_n() failed");
+    BENCH_CHECK(q.size() == 8, "size %zu, expected 8", q.size());
+    BENCH_CHECK(q.pop_n(data, 1) == 1 && data[0] == 2, "popped %llu, expected 2", (unsigned long long)data[0]);
+    for (size_t i = 0; i < _countof(data); i++)
+        data[i] = 100 + i;
+    BENCH_CHECK(q.push_n(data, 20) == 20, "push_n() failed");
+    uint64_t out[8];
+    BENCH_CHECK(q.pop_n(out, 8) == 8 && q.empty(), "queue did not hold 8 elements");
+    for (size_t i = 0; i < 8; i++)
+        BENCH_CHECK(out[i] == 112 + i, "element %zu is %llu, expected %zu", i, (unsigned long long)out[i], 112 + i);
+}
+
+
+///
+/// Checks the consumer of an overwriting queue never keeps an element torn by the producer
+///
+/// Elements span two words, holding a counter and its complement. The producer pushes much faster than the consumer
+/// pops, so most pops race with overwrites.
+///
+static void check_spsc_overwrite_torn()
+{
+    struct pair64 { uint64_t value, check; };
+    spsc_queue<pair64, true> q(4);
+    const uint64_t n = 0x100000;
+    size_t torn = 0, reordered = 0;
+    uint64_t last = 0;
+    atomic<bool> done(false);
+    thread consumer([&] {
+        for (;;) {
+            bool finished = done.load(memory_order_acquire);
+            pair64 v[2];
+            for (size_t i = 0, count = q.pop_n(v, _countof(v)); i < count; i++) {
+                if (v[i].check != ~v[i].value)
+                    torn++;
+                else if (v[i].value <= last && last)
+                    reordered++;
+                last = v[i].value;
+            }
+            if (finished && q.empty())
+                break;
+        }
+    });
+    for (uint64_t i = 1; i <= n; i++) {
+        pair64 v = { i, ~i };
+        if (i & 1)
+            q.push(v);
+        else
+            q.push_n(&v, 1);
+    }
+    done.store(true, memory_order_release);
+    consumer.join();
+    BENCH_CHECK(!torn, "%zu torn elements popped", torn);
+    BENCH_CHECK(!reordered, "%zu elements popped out of order", reordered);
+    BENCH_CHECK(last == n, "last element popped %llu, expected %llu", (unsigned long long)last, (unsigned long long)n);
+}
+
+
+static void bench_spsc_queue()
+{
+    check_spsc_overwrite();
+    check_spsc_overwrite_torn();
+
+    static const size_t capacities[] = { 64, 1024 };
+    static const size_t batch = 32;
+    const size_t ops = 0x40000;
+
+    for (size_t capacity : capacities) {
+        {
+            locked_queue<uint64_t> q(capacity);
+            run("vector_queue+mutex/spsc", capacity, ops, [&] { spsc_transfer(q, ops); });
+            run("vector_queue+mutex/spsc-batch", capacity, ops, [&] { spsc_transfer_n(q, ops, batch); });
+        }
+        {
+            spsc_queue<uint64_t> q(capacity);
+            run("spsc_queue/spsc", capacity, ops, [&] { spsc_transfer(q, ops); });
+            run("spsc_queue/spsc-batch", capacity, ops, [&] { spsc_transfer_n(q, ops, batch); });
+        }
+        {
+            spsc_queue<uint64_t, true> q(capacity);
+            run("spsc_queue<OVERWRITE>/spsc-batch", capacity, ops, [&] { spsc_overwrite_n(q, ops, batch); });
+        }
+    }
+}
+
+
+///
+/// Passes `n` elements from `threads` producer threads to `threads` consumer threads
+///
+/// \param[in] q        Queue
+/// \param[in] n        Number of elements. Must be a multiple of `threads`.
+/// \param[in] threads  Number of producers, and number of consumers
+/// \param[in] push     Pushes an element, waiting for room
+/// \param[in] pop      Pops an element, waiting for one
+///
+template<class _Queue, class _Push, class _Pop>
+static void mpmc_transfer(_Queue &q, size_t n, size_t threads, _Push push, _Pop pop)
+{
+    vector<thread> workers;
+    vector<uint64_t> sums(threads);
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (uint64_t i = t; i < n; i += threads)
+                push(q, i);
+        });
+        workers.emplace_back([&, t] {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < n/threads; i++)
+                sum += pop(q);
+            sums[t] = sum;
+        });
+    }
+    for (thread &w : workers)
+        w.join();
+    uint64_t sum = 0;
+    for (uint64_t s : sums)
+        sum += s;
+    BENCH_CHECK(sum == (uint64_t)n*(n - 1)/2, "sum %llu, expected %llu", (unsigned long long)sum, (unsigned long long)n*(n - 1)/2);
+}
+
+
+///
+/// Element throwing on every other copy
+///
+struct throwing_copy
+{
+    static size_t copies;
+    uint64_t value;
+
+    throwing_copy(uint64_t v = 0) : value(v) {}
+    throwing_copy(const throwing_copy &other) : value(other.value)
+    {
+        if (copies++ & 1)
+            throw runtime_error("copy failed");
+    }
+    throwing_copy& operator=(const throwing_copy &other)
+    {
+        if (copies++ & 1)
+            throw runtime_error("copy failed");
+        value = other.value;
+        return *this;
+    }
+    throwing_copy(throwing_copy &&other) noexcept = default;
+    throwing_copy& operator=(throwing_copy &&other) noexcept = default;
+};
+
+size_t throwing_copy::copies = 0;
+
+
+///
+/// Checks the queue keeps working after element copies throw
+///
+static void check_mpmc_throwing_copy()
+{
+    mpmc_queue<throwing_copy> q(4);
+    size_t pushed = 0, popped = 0, thrown = 0;
+    for (uint64_t i = 0; i < 8; i++) {
+        const throwing_copy v(i);
+        try {
+            if (q.try_push(v))
+                pushed++;
+        } catch (const runtime_error &) {
+            thrown++;
+        }
+        throwing_copy w;
+        while (q.try_pop(w))
+            popped++;
+    }
+    BENCH_CHECK(thrown == 4, "%zu copies thrown, expected 4", thrown);
+    BENCH_CHECK(pushed == 4 && popped == pushed && q.empty(), "%zu elements pushed, %zu popped", pushed, popped);
+}
+
+
+static void bench_mpmc_queue()
+{
+    check_mpmc_throwing_copy();
+
+    static const size_t threads_all[] = { 1, 2, 4, 8, 16 };
+    const size_t capacity = 1024, ops = 0x40000;
+
+    for (size_t threads : threads_all) {
+        {
+            locked_queue<uint64_t> q(capacity);
+            run("vector_queue+mutex/mpmc", threads, ops, [&] {
+                mpmc_transfer(q, ops, threads,
+                    [](locked_queue<uint64_t> &q, uint64_t v) { while (!q.push(v)) this_thread::yield(); },
+                    [](locked_queue<uint64_t> &q) { uint64_t v; while (!q.pop(v)) this_thread::yield(); return v; });
+            });
+        }
+        {
+            mpmc_queue<uint64_t> q(capacity);
+            run("mpmc_queue/mpmc", threads, ops, [&] {
+                mpmc_transfer(q, ops, threads,
+                    [](mpmc_queue<uint64_t> &q, uint64_t v) { q.push(v); },
+                    [](mpmc_queue<uint64_t> &q) { uint64_t v; q.pop(v); return v; });
+            });
+        }
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1)
+        s_filter = argv[1];
+
+    bench_vector_queue();
+    bench_spsc_queue();
+    bench_mpmc_queue();
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
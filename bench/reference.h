@@ -0,0 +1,400 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Reference codecs
+//
+// Code as WinStd implemented it before the performance rework: character by
+// character Base64 and hexadecimal codecs, string formatting, and GUID parsing. Results of
+// the current code are compared against these, and benchmarks report them as
+// the baseline.
+//
+
+#pragma once
+
+#include <errno.h>
+#include <memory>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace reference
+{
+    ///
+    /// Base64 encoding session
+    ///
+    class base64_enc
+    {
+    public:
+        inline base64_enc() : num(0)
+        {
+            buf[0] = 0;
+            buf[1] = 0;
+            buf[2] = 0;
+        }
+
+        template<class _Elem, class _Traits, class _Ax>
+        inline void encode(std::basic_string<_Elem, _Traits, _Ax> &out, const void *data, size_t size, bool is_last = true)
+        {
+            out.reserve(out.size() + enc_size(size));
+
+            for (size_t i = 0;; i++) {
+                if (num >= 3) {
+                    encode(out);
+                    num = 0;
+                }
+
+                if (i >= size)
+                    break;
+
+                buf[num++] = reinterpret_cast<const unsigned char*>(data)[i];
+            }
+
+            if (is_last && num) {
+                encode(out, num);
+                num = 0;
+            }
+        }
+
+        inline size_t enc_size(size_t size) const
+        {
+            return ((num + size + 2)/3)*4;
+        }
+
+    protected:
+        template<class _Elem, class _Traits, class _Ax>
+        inline void encode(std::basic_string<_Elem, _Traits, _Ax> &out)
+        {
+            out += lookup[                  buf[0] >> 2         ];
+            out += lookup[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
+            out += lookup[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
+            out += lookup[                  buf[2]        & 0x3f];
+        }
+
+        template<class _Elem, class _Traits, class _Ax>
+        inline void encode(std::basic_string<_Elem, _Traits, _Ax> &out, size_t size)
+        {
+            if (size > 0) {
+                out += lookup[buf[0] >> 2];
+                if (size > 1) {
+                    out += lookup[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
+                    if (size > 2) {
+                        out += lookup[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
+                        out += lookup[buf[2] & 0x3f];
+                    } else {
+                        out += lookup[(buf[1] << 2) & 0x3f];
+                        out += '=';
+                    }
+                } else {
+                    out += lookup[(buf[0] << 4) & 0x3f];
+                    out += '=';
+                    out += '=';
+                }
+            } else {
+                out += '=';
+                out += '=';
+                out += '=';
+                out += '=';
+            }
+        }
+
+    protected:
+        unsigned char buf[3];
+        size_t num;
+
+        static constexpr const char *lookup = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    };
+
+
+    ///
+    /// Base64 decoding session
+    ///
+    class base64_dec
+    {
+    public:
+        inline base64_dec() : num(0)
+        {
+            buf[0] = 0;
+            buf[1] = 0;
+            buf[2] = 0;
+            buf[3] = 0;
+        }
+
+        template<class _Ty, class _Ax, class _Tchr>
+        inline void decode(std::vector<_Ty, _Ax> &out, bool &is_last, const _Tchr *data, size_t size)
+        {
+            is_last = false;
+
+            for (size_t k = 0; k < size; k++)
+                if (!data[k]) { size = k; break; }
+
+            out.reserve(out.size() + dec_size(size));
+
+            for (size_t i = 0;; i++) {
+                if (num >= 4) {
+                    size_t nibbles = decode(out);
+                    num = 0;
+                    if (nibbles < 3) {
+                        is_last = true;
+                        break;
+                    }
+                }
+
+                if (i >= size)
+                    break;
+
+                // The original indexed the table with a signed value; treat characters as unsigned here.
+                size_t x = static_cast<typename std::make_unsigned<_Tchr>::type>(data[i]);
+                if ((buf[num] = x < 256 ? value(x) : 255) != 255)
+                    num++;
+            }
+        }
+
+        inline size_t dec_size(size_t size) const
+        {
+            return ((num + size + 3)/4)*3;
+        }
+
+    protected:
+        template<class _Ty, class _Ax>
+        inline size_t decode(std::vector<_Ty, _Ax> &out)
+        {
+            out.push_back((_Ty)(((buf[0] << 2) | (buf[1] >> 4)) & 0xff));
+            if (buf[2] < 64) {
+                out.push_back((_Ty)(((buf[1] << 4) | (buf[2] >> 2)) & 0xff));
+                if (buf[3] < 64) {
+                    out.push_back((_Ty)(((buf[2] << 6) | buf[3]) & 0xff));
+                    return 3;
+                } else
+                    return 2;
+            } else
+                return 1;
+        }
+
+        static inline unsigned char value(size_t x)
+        {
+            if ('A' <= x && x <= 'Z') return (unsigned char)(x - 'A');
+            if ('a' <= x && x <= 'z') return (unsigned char)(x - 'a' + 26);
+            if ('0' <= x && x <= '9') return (unsigned char)(x - '0' + 52);
+            if (x == '+') return 62;
+            if (x == '/') return 63;
+            if (x == '=') return 64;
+            return 255;
+        }
+
+    protected:
+        unsigned char buf[4];
+        size_t num;
+    };
+
+
+    ///
+    /// Hexadecimal encoding session
+    ///
+    class hex_enc
+    {
+    public:
+        template<class _Elem, class _Traits, class _Ax>
+        inline void encode(std::basic_string<_Elem, _Traits, _Ax> &out, const void *data, size_t size)
+        {
+            out.reserve(out.size() + size*2);
+
+            for (size_t i = 0; i < size; i++) {
+                unsigned char
+                    x   = reinterpret_cast<const unsigned char*>(data)[i],
+                    x_h = ((x & 0xf0) >> 4),
+                    x_l = ((x & 0x0f)     );
+
+                out += x_h < 10 ? '0' + x_h : 'A' - 10 + x_h;
+                out += x_l < 10 ? '0' + x_l : 'A' - 10 + x_l;
+            }
+        }
+    };
+
+
+    ///
+    /// Hexadecimal decoding session
+    ///
+    class hex_dec
+    {
+    public:
+        inline hex_dec() :
+            buf(0),
+            num(0)
+        {
+        }
+
+        template<class _Ty, class _Ax, class _Tchr>
+        inline void decode(std::vector<_Ty, _Ax> &out, bool &is_last, const _Tchr *data, size_t size)
+        {
+            is_last = false;
+
+            for (size_t k = 0; k < size; k++)
+                if (!data[k]) { size = k; break; }
+
+            out.reserve(out.size() + (size + 1)/2);
+
+            for (size_t i = 0;; i++) {
+                if (num >= 2) {
+                    out.push_back(buf);
+                    num = 0;
+                    is_last = true;
+                } else
+                    is_last = false;
+
+                if (i >= size)
+                    break;
+
+                size_t x = static_cast<typename std::make_unsigned<_Tchr>::type>(data[i]);
+                if ('0' <= x && x <= '9') {
+                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - '0');
+                    num++;
+                } else if ('A' <= x && x <= 'F') {
+                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - ('A' - 10));
+                    num++;
+                } else if ('a' <= x && x <= 'f') {
+                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - ('a' - 10));
+                    num++;
+                }
+            }
+        }
+
+    protected:
+        unsigned char buf;
+        size_t num;
+    };
+
+
+    ///
+    /// `_vsnprintf()` semantics: returns -1 when the result does not fit
+    ///
+    inline int _vsnprintf(char *str, size_t capacity, const char *format, va_list arg)
+    {
+        va_list arg_copy;
+        va_copy(arg_copy, arg);
+        int count = ::vsnprintf(str, capacity, format, arg_copy);
+        va_end(arg_copy);
+        return 0 <= count && (size_t)count < capacity ? count : -1;
+    }
+
+
+    ///
+    /// Formats string using `printf()`: stack buffer first, then heap buffers of doubling size
+    ///
+    template<class _Traits, class _Ax>
+    inline int vsprintf(std::basic_string<char, _Traits, _Ax> &str, const char *format, va_list arg)
+    {
+        char buf[WINSTD_STACK_BUFFER_BYTES];
+
+        int count = _vsnprintf(buf, _countof(buf) - 1, format, arg);
+        if (count >= 0) {
+            str.assign(buf, count);
+        } else {
+            for (size_t capacity = 2*WINSTD_STACK_BUFFER_BYTES;; capacity *= 2) {
+                std::unique_ptr<char[]> buf_dyn(new char[capacity]);
+                count = _vsnprintf(buf_dyn.get(), capacity - 1, format, arg);
+                if (count >= 0) {
+                    str.assign(buf_dyn.get(), count);
+                    break;
+                }
+            }
+        }
+
+        return count;
+    }
+
+
+    template<class _Traits, class _Ax>
+    inline int sprintf(std::basic_string<char, _Traits, _Ax> &str, const char *format, ...)
+    {
+        va_list arg;
+        va_start(arg, format);
+        int res = vsprintf(str, format, arg);
+        va_end(arg);
+        return res;
+    }
+
+
+    ///
+    /// Parses `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` using `strtoul()`
+    ///
+    inline bool StringToGuidA(const char *lpszGuid, GUID *lpGuid, const char **lpszGuidEnd = NULL)
+    {
+        GUID g;
+        char *lpszEnd;
+        unsigned long ulTmp;
+        unsigned long long ullTmp;
+
+        if (!lpszGuid || !lpGuid || *lpszGuid != '{') return false;
+        lpszGuid++;
+
+        g.Data1 = strtoul(lpszGuid, &lpszEnd, 16);
+        if (errno == ERANGE) return false;
+        lpszGuid = lpszEnd;
+
+        if (*lpszGuid != '-') return false;
+        lpszGuid++;
+
+        ulTmp = strtoul(lpszGuid, &lpszEnd, 16);
+        if (errno == ERANGE || ulTmp > 0xFFFF) return false;
+        g.Data2 = (unsigned short)ulTmp;
+        lpszGuid = lpszEnd;
+
+        if (*lpszGuid != '-') return false;
+        lpszGuid++;
+
+        ulTmp = strtoul(lpszGuid, &lpszEnd, 16);
+        if (errno == ERANGE || ulTmp > 0xFFFF) return false;
+        g.Data3 = (unsigned short)ulTmp;
+        lpszGuid = lpszEnd;
+
+        if (*lpszGuid != '-') return false;
+        lpszGuid++;
+
+        ulTmp = strtoul(lpszGuid, &lpszEnd, 16);
+        if (errno == ERANGE || ulTmp > 0xFFFF) return false;
+        g.Data4[0] = (unsigned char)((ulTmp >> 8) & 0xff);
+        g.Data4[1] = (unsigned char)( ulTmp       & 0xff);
+        lpszGuid = lpszEnd;
+
+        if (*lpszGuid != '-') return false;
+        lpszGuid++;
+
+        ullTmp = strtoull(lpszGuid, &lpszEnd, 16);
+        if (errno == ERANGE || ullTmp > 0xFFFFFFFFFFFF) return false;
+        for (int i = 0; i < 6; i++)
+            g.Data4[2 + i] = (unsigned char)((ullTmp >> (40 - 8*i)) & 0xff);
+        lpszGuid = lpszEnd;
+
+        if (*lpszGuid != '}') return false;
+        lpszGuid++;
+
+        if (lpszGuidEnd)
+            *lpszGuidEnd = lpszGuid;
+
+        *lpGuid = g;
+        return true;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// Stand-in for src/StdAfx.h
+//
+// The sources built by the harness are copied next to this file, so they
+// include it instead of the full precompiled header.
+//
+
+#pragma once
+
+#if WINSTD_BENCH_SIMD
+#if defined(__x86_64__)
+#define _M_X64  100
+#elif defined(__i386__)
+#define _M_IX86 600
+#endif
+#endif
+
+#include <WinStd/Base64.h>
+#include <WinStd/Format.h>
+#include <WinStd/Hex.h>
+#include <WinStd/Common.h>
+
+#include <tchar.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+
+namespace winstd
+{
+    /// \cond internal
+    bool cpu_has_ssse3();
+    bool cpu_has_avx2();
+    /// \endcond
+}
+#endif
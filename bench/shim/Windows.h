@@ -0,0 +1,354 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// Minimal stand-in for the Windows SDK
+//
+// Declares just enough of the Windows API for Common.h, Base64.h, Hex.h and
+// Format.h to compile on Linux. Memory management maps to mmap()/mlock(),
+// SRW locks to std::shared_timed_mutex. Functions without a sensible POSIX
+// equivalent fail with ERROR_NOT_SUPPORTED.
+//
+// Build with -fshort-wchar, so wchar_t is 16-bit as on Windows.
+//
+
+#pragma once
+
+#if !defined(__cplusplus)
+#error This header is for C++ only.
+#endif
+
+#define _WIN32_WINNT_WIN10  0x0A00
+#define _WIN32_WINNT        _WIN32_WINNT_WIN10
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+
+static_assert(sizeof(wchar_t) == 2, "Build with -fshort-wchar");
+
+//
+// Compiler
+//
+#define __declspec(x)
+#define __forceinline   inline __attribute__((always_inline))
+#define WINAPI
+#define _byteswap_ushort    __builtin_bswap16
+#define _byteswap_ulong     __builtin_bswap32
+#define _byteswap_uint64    __builtin_bswap64
+#define _countof(a)     (sizeof(a)/sizeof((a)[0]))
+#define UNREFERENCED_PARAMETER(P)   (void)(P)
+
+//
+// Source annotations
+//
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_opt_z_
+#define _In_count_(x)
+#define _In_count_c_(x)
+#define _In_bytecount_(x)
+#define _In_z_count_(x)
+#define _In_reads_(x)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(x)
+#define _Out_writes_z_(x)
+#define _Out_writes_to_(x, y)
+#define _Out_z_cap_(x)
+#define _Inout_
+#define _Success_(x)
+#define _Printf_format_string_
+#define _FormatMessage_format_string_
+
+//
+// Types
+//
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef char CHAR;
+typedef uint32_t DWORD;
+typedef uintptr_t DWORD_PTR;
+typedef long HRESULT;
+typedef long LONG;
+typedef unsigned int UINT;
+typedef void VOID;
+typedef wchar_t WCHAR;
+typedef uint16_t WORD;
+typedef void *HINSTANCE, *HLOCAL;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef char *LPSTR;
+typedef const char *LPCSTR, *PCSTR;
+typedef wchar_t *LPWSTR;
+typedef const wchar_t *LPCWSTR, *PCWSTR;
+#ifdef _UNICODE
+typedef wchar_t TCHAR;
+typedef const wchar_t *LPCTSTR, *PCTSTR;
+#else
+typedef char TCHAR;
+typedef const char *LPCTSTR, *PCTSTR;
+#endif
+
+struct GUID
+{
+    uint32_t Data1;
+    uint16_t Data2;
+    uint16_t Data3;
+    uint8_t  Data4[8];
+};
+typedef GUID *LPGUID;
+typedef const GUID *LPCGUID;
+typedef const GUID &REFGUID;
+
+inline bool operator==(REFGUID a, REFGUID b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(REFGUID a, REFGUID b) { return !(a == b); }
+
+#define TRUE    1
+#define FALSE   0
+
+//
+// Errors
+//
+#define ERROR_SUCCESS                   0
+#define ERROR_OUTOFMEMORY               14
+#define ERROR_NOT_SUPPORTED             50
+#define ERROR_INVALID_PARAMETER         87
+#define ERROR_INSUFFICIENT_BUFFER       122
+
+#define S_OK                            ((HRESULT)0)
+#define E_INVALIDARG                    ((HRESULT)0x80070057L)
+
+inline DWORD &winstd_shim_last_error()
+{
+    static thread_local DWORD error = ERROR_SUCCESS;
+    return error;
+}
+
+inline DWORD GetLastError()                 { return winstd_shim_last_error(); }
+inline void SetLastError(_In_ DWORD error)  { winstd_shim_last_error() = error; }
+
+//
+// Memory
+//
+#define MEMORY_ALLOCATION_ALIGNMENT     16
+#define MEM_COMMIT                      0x1000
+#define MEM_RESERVE                     0x2000
+#define MEM_RELEASE                     0x8000
+#define PAGE_NOACCESS                   0x01
+#define PAGE_READWRITE                  0x04
+
+#define ZeroMemory(p, n)    memset((p), 0, (n))
+
+inline void SecureZeroMemory(_Out_writes_(size) void *ptr, _In_ size_t size)
+{
+    volatile unsigned char *p = static_cast<volatile unsigned char*>(ptr);
+    while (size--)
+        *p++ = 0;
+}
+
+inline HLOCAL LocalFree(_In_opt_ HLOCAL mem)
+{
+    free(mem);
+    return NULL;
+}
+
+struct SYSTEM_INFO
+{
+    DWORD dwPageSize;
+};
+
+inline void GetSystemInfo(_Out_ SYSTEM_INFO *si)
+{
+    si->dwPageSize = (DWORD)sysconf(_SC_PAGESIZE);
+}
+
+/// \cond internal
+inline std::map<void*, size_t> &winstd_shim_mappings(_Out_ std::mutex *&lock)
+{
+    static std::mutex m;
+    static std::map<void*, size_t> mappings;
+    lock = &m;
+    return mappings;
+}
+/// \endcond
+
+inline LPVOID VirtualAlloc(_In_opt_ LPVOID address, _In_ size_t size, _In_ DWORD type, _In_ DWORD protect)
+{
+    UNREFERENCED_PARAMETER(type);
+    if (address) {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return NULL;
+    }
+    void *p = mmap(NULL, size, protect == PAGE_NOACCESS ? PROT_NONE : PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        SetLastError(ERROR_OUTOFMEMORY);
+        return NULL;
+    }
+    std::mutex *lock;
+    auto &mappings = winstd_shim_mappings(lock);
+    std::lock_guard<std::mutex> l(*lock);
+    mappings[p] = size;
+    return p;
+}
+
+inline BOOL VirtualFree(_In_ LPVOID address, _In_ size_t size, _In_ DWORD type)
+{
+    UNREFERENCED_PARAMETER(size);
+    std::mutex *lock;
+    auto &mappings = winstd_shim_mappings(lock);
+    std::lock_guard<std::mutex> l(*lock);
+    auto m = mappings.find(address);
+    if (type != MEM_RELEASE || m == mappings.end()) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    munmap(m->first, m->second);
+    mappings.erase(m);
+    return TRUE;
+}
+
+inline BOOL VirtualProtect(_In_ LPVOID address, _In_ size_t size, _In_ DWORD protect, _Out_ DWORD *old_protect)
+{
+    *old_protect = PAGE_READWRITE;
+    if (mprotect(address, size, protect == PAGE_NOACCESS ? PROT_NONE : PROT_READ | PROT_WRITE) != 0) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+inline BOOL VirtualLock(_In_ LPVOID address, _In_ size_t size)
+{
+    if (mlock(address, size) != 0) {
+        SetLastError(ERROR_NOT_SUPPORTED);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+inline BOOL VirtualUnlock(_In_ LPVOID address, _In_ size_t size)
+{
+    return munlock(address, size) == 0;
+}
+
+//
+// Synchronization
+//
+typedef std::shared_timed_mutex SRWLOCK;
+
+inline void InitializeSRWLock(_Out_ SRWLOCK *lock)          { UNREFERENCED_PARAMETER(lock); }
+inline void AcquireSRWLockExclusive(_Inout_ SRWLOCK *lock)  { lock->lock(); }
+inline void ReleaseSRWLockExclusive(_Inout_ SRWLOCK *lock)  { lock->unlock(); }
+inline void AcquireSRWLockShared(_Inout_ SRWLOCK *lock)     { lock->lock_shared(); }
+inline void ReleaseSRWLockShared(_Inout_ SRWLOCK *lock)     { lock->unlock_shared(); }
+
+//
+// Strings
+//
+#define CP_ACP      0
+#define CP_UTF8     65001
+
+#define FORMAT_MESSAGE_ALLOCATE_BUFFER  0x00000100
+#define FORMAT_MESSAGE_IGNORE_INSERTS   0x00000200
+#define FORMAT_MESSAGE_FROM_STRING      0x00000400
+#define FORMAT_MESSAGE_FROM_HMODULE     0x00000800
+#define FORMAT_MESSAGE_FROM_SYSTEM      0x00001000
+#define FORMAT_MESSAGE_ARGUMENT_ARRAY   0x00002000
+#define FORMAT_MESSAGE_MAX_WIDTH_MASK   0x000000FF
+
+#define LANG_NEUTRAL        0x00
+#define SUBLANG_DEFAULT     0x01
+#define MAKELANGID(p, s)    ((((WORD)(s)) << 10) | (WORD)(p))
+
+inline DWORD FormatMessageA(_In_ DWORD flags, _In_opt_ LPCVOID source, _In_ DWORD id, _In_ DWORD lang, _Out_ LPSTR buffer, _In_ DWORD size, _In_opt_ va_list *args)
+{
+    UNREFERENCED_PARAMETER(flags); UNREFERENCED_PARAMETER(source); UNREFERENCED_PARAMETER(id); UNREFERENCED_PARAMETER(lang);
+    UNREFERENCED_PARAMETER(buffer); UNREFERENCED_PARAMETER(size); UNREFERENCED_PARAMETER(args);
+    SetLastError(ERROR_NOT_SUPPORTED);
+    return 0;
+}
+
+inline DWORD FormatMessageW(_In_ DWORD flags, _In_opt_ LPCVOID source, _In_ DWORD id, _In_ DWORD lang, _Out_ LPWSTR buffer, _In_ DWORD size, _In_opt_ va_list *args)
+{
+    UNREFERENCED_PARAMETER(flags); UNREFERENCED_PARAMETER(source); UNREFERENCED_PARAMETER(id); UNREFERENCED_PARAMETER(lang);
+    UNREFERENCED_PARAMETER(buffer); UNREFERENCED_PARAMETER(size); UNREFERENCED_PARAMETER(args);
+    SetLastError(ERROR_NOT_SUPPORTED);
+    return 0;
+}
+
+inline int WideCharToMultiByte(_In_ UINT cp, _In_ DWORD flags, _In_ LPCWSTR src, _In_ int src_len, _Out_opt_ LPSTR dst, _In_ int dst_len, _In_opt_ LPCSTR def, _Out_opt_ BOOL *used_def)
+{
+    // Latin-1 only
+    UNREFERENCED_PARAMETER(cp); UNREFERENCED_PARAMETER(flags); UNREFERENCED_PARAMETER(def);
+    if (used_def) *used_def = FALSE;
+    if (src_len < 0) for (src_len = 0; src[src_len++]; );
+    if (dst)
+        for (int i = 0; i < src_len && i < dst_len; i++)
+            dst[i] = (char)src[i];
+    return src_len;
+}
+
+inline int MultiByteToWideChar(_In_ UINT cp, _In_ DWORD flags, _In_ LPCSTR src, _In_ int src_len, _Out_opt_ LPWSTR dst, _In_ int dst_len)
+{
+    // Latin-1 only
+    UNREFERENCED_PARAMETER(cp); UNREFERENCED_PARAMETER(flags);
+    if (src_len < 0) src_len = (int)strlen(src) + 1;
+    if (dst)
+        for (int i = 0; i < src_len && i < dst_len; i++)
+            dst[i] = (unsigned char)src[i];
+    return src_len;
+}
+
+//
+// CRT
+//
+#define _vsnprintf  vsnprintf
+
+inline int _vscprintf(_In_z_ _Printf_format_string_ const char *format, _In_ va_list arg)
+{
+    return vsnprintf(NULL, 0, format, arg);
+}
+
+// glibc wide formatting assumes 32-bit wchar_t.
+inline int _vsnwprintf(_Out_z_cap_(capacity) wchar_t *str, _In_ size_t capacity, _In_z_ _Printf_format_string_ const wchar_t *format, _In_ va_list arg)
+{
+    UNREFERENCED_PARAMETER(str); UNREFERENCED_PARAMETER(capacity); UNREFERENCED_PARAMETER(format); UNREFERENCED_PARAMETER(arg);
+    fputs("_vsnwprintf() is not available on Linux\n", stderr);
+    abort();
+}
+
+inline int _vscwprintf(_In_z_ _Printf_format_string_ const wchar_t *format, _In_ va_list arg)
+{
+    UNREFERENCED_PARAMETER(format); UNREFERENCED_PARAMETER(arg);
+    fputs("_vscwprintf() is not available on Linux\n", stderr);
+    abort();
+}
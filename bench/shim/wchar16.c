@@ -0,0 +1,90 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/*
+    16-bit wchar_t string functions
+
+    The harness builds with -fshort-wchar to match the Windows wchar_t. The C
+    library's wide string functions assume 32-bit wchar_t, so the ones libstdc++
+    calls for std::wstring are replaced here.
+*/
+
+#include <stddef.h>
+#include <wchar.h>
+
+#if __SIZEOF_WCHAR_T__ != 2
+#error Build with -fshort-wchar
+#endif
+
+
+size_t wcslen(const wchar_t *s)
+{
+    const wchar_t *p = s;
+    while (*p) p++;
+    return (size_t)(p - s);
+}
+
+
+wchar_t *wmemcpy(wchar_t *dst, const wchar_t *src, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = src[i];
+    return dst;
+}
+
+
+wchar_t *wmemmove(wchar_t *dst, const wchar_t *src, size_t n)
+{
+    if (dst < src) {
+        for (size_t i = 0; i < n; i++)
+            dst[i] = src[i];
+    } else {
+        for (size_t i = n; i--; )
+            dst[i] = src[i];
+    }
+    return dst;
+}
+
+
+wchar_t *wmemset(wchar_t *dst, wchar_t c, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        dst[i] = c;
+    return dst;
+}
+
+
+int wmemcmp(const wchar_t *a, const wchar_t *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    return 0;
+}
+
+
+wchar_t *wmemchr(const wchar_t *s, wchar_t c, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        if (s[i] == c)
+            return (wchar_t*)s + i;
+    return NULL;
+}
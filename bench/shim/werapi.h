@@ -0,0 +1,43 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Stand-in for <werapi.h>
+//
+// Memory blocks excluded from Windows Error Reporting dumps map to
+// madvise(MADV_DONTDUMP), which keeps them out of Linux core dumps.
+//
+
+#pragma once
+
+#include <Windows.h>
+
+inline HRESULT WerRegisterExcludedMemoryBlock(_In_ const void *address, _In_ DWORD size)
+{
+    return madvise(const_cast<void*>(address), size, MADV_DONTDUMP) == 0 ? S_OK : E_INVALIDARG;
+}
+
+inline HRESULT WerUnregisterExcludedMemoryBlock(_In_ const void *address)
+{
+    // Unlike Windows, madvise() needs the size. The block is released right after, so leave it excluded.
+    UNREFERENCED_PARAMETER(address);
+    return S_OK;
+}
@@ -0,0 +1,260 @@
+/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+//
+// Memory use and throughput of the codec stream buffers
+//
+// Random data is encoded and decoded back through a pair of Base64 or
+// hexadecimal stream buffers, and compared against the original as it comes
+// out. The input stream buffers are chained and read from; the output stream
+// buffers are chained and written to. Resident set size is sampled while the
+// data flows and must not grow.
+//
+// Usage: stream_bench [MiB [filter]]
+//
+// The default size is 4096 MiB.
+//
+
+#include "StdAfx.h"
+#include "bench.h"
+
+#include <unistd.h>
+
+using namespace std;
+using namespace winstd;
+
+
+static const char *s_filter = NULL;
+static const size_t s_block = 0x10000;
+static const size_t s_sample = 0x1000000;
+
+
+///
+/// Returns resident set size in bytes
+///
+static size_t rss()
+{
+    size_t size, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%zu %zu", &size, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return resident*(size_t)sysconf(_SC_PAGESIZE);
+}
+
+
+///
+/// Endless pseudo-random byte sequence, generated in blocks
+///
+class random_bytes
+{
+public:
+    random_bytes() : m_pos(_countof(m_block)) {}
+
+    void read(unsigned char *data, size_t size)
+    {
+        while (size) {
+            if (m_pos >= _countof(m_block)) {
+                for (size_t i = 0; i < _countof(m_block); i += sizeof(uint64_t)) {
+                    uint64_t x = m_rng.next();
+                    memcpy(m_block + i, &x, sizeof(x));
+                }
+                m_pos = 0;
+            }
+            size_t n = std::min<size_t>(size, _countof(m_block) - m_pos);
+            memcpy(data, m_block + m_pos, n);
+            data += n;
+            size -= n;
+            m_pos += n;
+        }
+    }
+
+protected:
+    bench::rng m_rng;
+    unsigned char m_block[s_block];
+    size_t m_pos;
+};
+
+
+///
+/// Source stream buffer providing `size` bytes of random data
+///
+class source_streambuf : public std::streambuf
+{
+public:
+    source_streambuf(size_t size) : m_left(size) {}
+
+protected:
+    virtual int_type underflow()
+    {
+        if (!m_left)
+            return traits_type::eof();
+        size_t n = std::min<size_t>(m_left, _countof(m_buf));
+        m_data.read(reinterpret_cast<unsigned char*>(m_buf), n);
+        m_left -= n;
+        setg(m_buf, m_buf, m_buf + n);
+        return traits_type::to_int_type(m_buf[0]);
+    }
+
+protected:
+    random_bytes m_data;
+    size_t m_left;
+    char m_buf[s_block];
+};
+
+
+///
+/// Target stream buffer comparing data written against the random data, and sampling resident set size
+///
+class sink_streambuf : public std::streambuf
+{
+public:
+    sink_streambuf() : m_size(0), m_mismatch((size_t)-1), m_rss_base(0), m_rss_max(0) {}
+
+    size_t size() const { return m_size; }
+    size_t mismatch() const { return m_mismatch; }
+    size_t rss_growth() const { return m_rss_max - m_rss_base; }
+
+protected:
+    virtual int_type overflow(int_type ch = traits_type::eof())
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            char c = traits_type::to_char_type(ch);
+            xsputn(&c, 1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    virtual std::streamsize xsputn(const char *data, std::streamsize count)
+    {
+        for (size_t size = (size_t)count; size;) {
+            size_t n = std::min<size_t>(size, _countof(m_expected));
+            m_data.read(m_expected, n);
+            if (m_mismatch == (size_t)-1 && memcmp(data, m_expected, n) != 0)
+                m_mismatch = m_size;
+            if (m_size / s_sample != (m_size + n) / s_sample || !m_size) {
+                // The first sample is taken once the data flows through the whole pipeline.
+                size_t r = rss();
+                if (!m_size)
+                    m_rss_base = m_rss_max = r;
+                else if (m_rss_max < r)
+                    m_rss_max = r;
+            }
+            data += n;
+            size -= n;
+            m_size += n;
+        }
+        return count;
+    }
+
+protected:
+    random_bytes m_data;
+    unsigned char m_expected[s_block];
+    size_t m_size;
+    size_t m_mismatch;
+    size_t m_rss_base;
+    size_t m_rss_max;
+};
+
+
+///
+/// Reports and checks one pipeline
+///
+static void report(const char *name, size_t size, double elapsed, const sink_streambuf &sink)
+{
+    char arg[32];
+    bench::size_name(size, arg, _countof(arg));
+    BENCH_CHECK(sink.size() == size, "%s: %zu bytes out, expected %zu", name, sink.size(), size);
+    BENCH_CHECK(sink.mismatch() == (size_t)-1, "%s: data mismatch at %zu", name, sink.mismatch());
+    BENCH_CHECK(sink.rss_growth() < 0x100000, "%s: resident set grew by %zu bytes", name, sink.rss_growth());
+    bench::report(name, arg, size/elapsed/1e6, "MB/s");
+    bench::report(name, arg, sink.rss_growth()/1024.0, "KiB RSS growth");
+}
+
+
+///
+/// Encodes and decodes data by reading from chained input stream buffers
+///
+template<class _Enc, class _Dec>
+static void pipeline_istreambuf(const char *name, size_t size)
+{
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    source_streambuf source(size);
+    sink_streambuf sink;
+    {
+        _Enc enc(&source);
+        _Dec dec(&enc);
+        vector<char> buf(s_block);
+        for (streamsize n; (n = dec.sgetn(buf.data(), (streamsize)buf.size())) > 0;)
+            sink.sputn(buf.data(), n);
+    }
+    report(name, size, std::chrono::duration<double>(clock::now() - start).count(), sink);
+}
+
+
+///
+/// Encodes and decodes data by writing to chained output stream buffers
+///
+template<class _Enc, class _Dec>
+static void pipeline_ostreambuf(const char *name, size_t size)
+{
+    if (s_filter && !strstr(name, s_filter))
+        return;
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    source_streambuf source(size);
+    sink_streambuf sink;
+    {
+        // Destroyed in reverse order: the encoder finishes into the decoder first.
+        _Dec dec(&sink);
+        _Enc enc(&dec);
+        vector<char> buf(s_block);
+        for (streamsize n; (n = source.sgetn(buf.data(), (streamsize)buf.size())) > 0;)
+            enc.sputn(buf.data(), n);
+    }
+    report(name, size, std::chrono::duration<double>(clock::now() - start).count(), sink);
+}
+
+
+int main(int argc, char *argv[])
+{
+    size_t size = (size_t)4096 << 20;
+    if (argc > 1)
+        size = (size_t)strtoull(argv[1], NULL, 10) << 20;
+    if (argc > 2)
+        s_filter = argv[2];
+
+    pipeline_istreambuf<base64_enc_istreambuf, base64_dec_istreambuf>("base64 istreambuf", size);
+    pipeline_ostreambuf<base64_enc_ostreambuf, base64_dec_ostreambuf>("base64 ostreambuf", size);
+    pipeline_istreambuf<hex_enc_istreambuf, hex_dec_istreambuf>("hex istreambuf", size);
+    pipeline_ostreambuf<hex_enc_ostreambuf, hex_dec_ostreambuf>("hex ostreambuf", size);
+
+    if (bench::failures) {
+        printf("%zu failures\n", bench::failures);
+        return 1;
+    }
+    return 0;
+}
@@ -25,33 +25,287 @@
 
 #include "Common.h"
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace winstd
 {
-    class WINSTD_API base64_enc;
-    class WINSTD_API base64_dec;
+    struct WINSTD_API base64_std;
+    struct WINSTD_API base64_std_nopad;
+    struct WINSTD_API base64_url;
+    struct WINSTD_API base64_url_nopad;
+    struct WINSTD_API base64_mime;
+    template<class _Alphabet> class basic_base64_enc;
+    template<class _Alphabet> class basic_base64_dec;
+    template<class _Alphabet, class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_base64_enc_ostreambuf;
+    template<class _Alphabet, class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_base64_enc_istreambuf;
+    template<class _Alphabet, class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_base64_dec_ostreambuf;
+    template<class _Alphabet, class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_base64_dec_istreambuf;
+
+    /// \addtogroup WinStdBase64
+    /// @{
+
+    ///
+    /// Base64 encoding session using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_enc<base64_std> base64_enc;
+
+    ///
+    /// Base64 decoding session using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_dec<base64_std> base64_dec;
+
+    ///
+    /// Base64 encoding session using URL and filename safe RFC 4648 alphabet
+    ///
+    typedef basic_base64_enc<base64_url> base64url_enc;
+
+    ///
+    /// Base64 decoding session using URL and filename safe RFC 4648 alphabet
+    ///
+    typedef basic_base64_dec<base64_url> base64url_dec;
+
+    ///
+    /// Base64 encoding output stream buffer using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_enc_ostreambuf<base64_std> base64_enc_ostreambuf;
+
+    ///
+    /// Base64 encoding input stream buffer using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_enc_istreambuf<base64_std> base64_enc_istreambuf;
+
+    ///
+    /// Base64 decoding output stream buffer using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_dec_ostreambuf<base64_std> base64_dec_ostreambuf;
+
+    ///
+    /// Base64 decoding input stream buffer using standard RFC 4648 alphabet
+    ///
+    typedef basic_base64_dec_istreambuf<base64_std> base64_dec_istreambuf;
+
+    /// @}
+
+    /// \cond internal
+    WINSTD_API char *base64_encode_groups(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(64) const char *lookup);
+    WINSTD_API size_t base64_decode_groups(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const char *data, _In_ size_t size, _In_ char c62, _In_ char c63);
+    WINSTD_API size_t base64_decode_groups(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size, _In_ char c62, _In_ char c63);
+    /// \endcond
 }
 
 #pragma once
 
+#include <exception>
+#include <thread>
+
+
+/// \addtogroup WinStdBase64
+/// @{
+
+#ifndef WINSTD_PARALLEL_CHUNK_BYTES
+///
+/// Minimum size of input in bytes for each worker thread of parallel encoding and decoding
+///
+/// Inputs too small to give each thread at least this much work use fewer threads, or no threads at all.
+///
+#define WINSTD_PARALLEL_CHUNK_BYTES  0x10000
+#endif
+
+/// @}
+
 
 namespace winstd
 {
+    /// \cond internal
+
+    ///
+    /// Calls `fn(k)` for each `k` in `[0, n)`: `fn(0)` on the calling thread, others on worker threads.
+    ///
+    /// Worker threads are started for each call rather than kept in a pool. Calls are made only for inputs of at least
+    /// `WINSTD_PARALLEL_CHUNK_BYTES` per thread, where starting a thread costs little compared to the work, and a pool
+    /// would keep threads alive in every process using the header.
+    ///
+    /// An exception thrown by `fn` on any thread is rethrown on the calling thread once all calls finished. When more
+    /// calls throw, the exception of the lowest `k` is rethrown.
+    ///
+    template<class _Fn>
+    inline void parallel_for(_In_ size_t n, _In_ _Fn fn)
+    {
+        std::vector<std::exception_ptr> errors(n);
+        std::vector<std::thread> workers;
+        workers.reserve(n - 1);
+        try {
+            for (size_t k = 1; k < n; k++)
+                workers.emplace_back([&fn, &errors](size_t k) {
+                    try {
+                        fn(k);
+                    } catch (...) {
+                        errors[k] = std::current_exception();
+                    }
+                }, k);
+            fn(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (auto &w : workers)
+            w.join();
+        for (auto &e : errors)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
+
+    ///
+    /// Returns number of worker threads to use for parallel processing of `size` bytes
+    ///
+    inline size_t parallel_threads(_In_ size_t size, _In_ size_t threads)
+    {
+        if (!threads)
+            threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        return std::max<size_t>(std::min<size_t>(threads, size/WINSTD_PARALLEL_CHUNK_BYTES), 1);
+    }
+
+    /// \endcond
+
     /// \addtogroup WinStdBase64
     /// @{
 
+    ///
+    /// Standard RFC 4648 Base64 alphabet with padding
+    ///
+    struct WINSTD_API base64_std
+    {
+        ///
+        /// Characters for 6-bit values
+        ///
+        static constexpr char lookup_enc[64] = {
+            'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+            'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+            'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+            'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+        };
+
+        ///
+        /// 6-bit values for characters: 64 for padding, 255 for characters to skip
+        ///
+        static constexpr unsigned char lookup_dec[256] = {
+        /*           0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F  */
+        /* 0 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 1 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 2 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
+        /* 3 */     52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255,  64, 255, 255,
+        /* 4 */    255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+        /* 5 */     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
+        /* 6 */    255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+        /* 7 */     41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+        /* 8 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 9 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* A */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* B */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* C */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* D */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* E */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* F */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+        };
+
+        static constexpr bool padding = true;   ///< Pad the last group with `=`
+        static constexpr size_t line_max = 0;   ///< Maximum line length in characters (0 = no line wrapping)
+    };
+
+
+    ///
+    /// Standard RFC 4648 Base64 alphabet without padding
+    ///
+    struct WINSTD_API base64_std_nopad : base64_std
+    {
+        static constexpr bool padding = false;  ///< Pad the last group with `=`
+    };
+
+
+    ///
+    /// URL and filename safe RFC 4648 Base64 alphabet with padding
+    ///
+    struct WINSTD_API base64_url
+    {
+        ///
+        /// Characters for 6-bit values
+        ///
+        static constexpr char lookup_enc[64] = {
+            'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+            'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+            'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+            'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '_'
+        };
+
+        ///
+        /// 6-bit values for characters: 64 for padding, 255 for characters to skip
+        ///
+        static constexpr unsigned char lookup_dec[256] = {
+        /*           0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F  */
+        /* 0 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 1 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 2 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255,
+        /* 3 */     52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255,  64, 255, 255,
+        /* 4 */    255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+        /* 5 */     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255,  63,
+        /* 6 */    255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+        /* 7 */     41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+        /* 8 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* 9 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* A */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* B */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* C */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* D */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* E */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+        /* F */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+        };
+
+        static constexpr bool padding = true;   ///< Pad the last group with `=`
+        static constexpr size_t line_max = 0;   ///< Maximum line length in characters (0 = no line wrapping)
+    };
+
+
+    ///
+    /// URL and filename safe RFC 4648 Base64 alphabet without padding (as used by JWT)
+    ///
+    struct WINSTD_API base64_url_nopad : base64_url
+    {
+        static constexpr bool padding = false;  ///< Pad the last group with `=`
+    };
+
+
+    ///
+    /// MIME RFC 2045 Base64: standard alphabet with padding, lines wrapped at 76 characters using CRLF
+    ///
+    struct WINSTD_API base64_mime : base64_std
+    {
+        static constexpr size_t line_max = 76;  ///< Maximum line length in characters (0 = no line wrapping)
+    };
+
+
     ///
     /// Base64 encoding session
     ///
-    class WINSTD_API base64_enc
+    /// \tparam _Alphabet  Alphabet and padding policy: `base64_std`, `base64_std_nopad`, `base64_url`, `base64_url_nopad` or `base64_mime`
+    ///
+    template<class _Alphabet>
+    class basic_base64_enc
     {
+        static_assert(_Alphabet::line_max % 4 == 0, "line length must be a multiple of 4");
+
     public:
         ///
         /// Constructs blank encoding session
         ///
-        inline base64_enc() : num(0)
+        inline basic_base64_enc() :
+            num(0),
+            line(0)
         {
             buf[0] = 0;
             buf[1] = 0;
@@ -72,27 +326,162 @@ namespace winstd
         {
             assert(data || !size);
 
-            // Preallocate output
-            out.reserve(out.size() + enc_size(size));
+            // Preallocate output and convert directly into it.
+            size_t offset = out.size();
+            out.resize(offset + enc_size(size));
+            _Elem *end = encode(&out[0] + offset, data, size, is_last);
+            out.resize(end - &out[0]);
+        }
+
+
+        ///
+        /// Encodes one block of information into a buffer
+        ///
+        /// Encoding stops when the buffer is full. Only complete 4-character groups are written.
+        ///
+        /// \param[out] out       Output
+        /// \param[in ] capacity  Size of `out` in characters. `enc_size(size)` characters is always sufficient.
+        /// \param[out] consumed  Number of bytes of `data` consumed. Less than `size` when `out` is too small.
+        /// \param[in ] data      Data to encode
+        /// \param[in ] size      Length of `data` in bytes
+        /// \param[in ] is_last   Is this the last block of data?
+        ///
+        /// \returns Number of characters written to `out`
+        ///
+        template<class _Elem>
+        inline size_t encode(_Out_writes_to_(capacity, return) _Elem *out, _In_ size_t capacity, _Out_ size_t &consumed, _In_bytecount_(size) const void *data, _In_ size_t size, _In_opt_ bool is_last = true)
+        {
+            assert(data || !size);
+
+            // Take as much data as there is room for complete groups. The remainder of up to two bytes goes to the internal buffer.
+            size_t groups = groups_max(capacity);
+            consumed = std::min<size_t>(size, groups*3 + 2 - num);
+            bool flush = is_last && consumed == size;
+            if (flush && (num + consumed + 2)/3 > groups) {
+                // No room to flush the last group. Leave its data for the next call.
+                consumed = (num + consumed)/3*3 > num ? (num + consumed)/3*3 - num : 0;
+                flush = false;
+            }
+
+            return encode(out, data, consumed, flush) - out;
+        }
 
-            // Convert data character by character.
-            for (size_t i = 0;; i++) {
+
+        ///
+        /// Encodes one block of information, and writes it to the output iterator
+        ///
+        /// \param[out] out      Output iterator
+        /// \param[in ] data     Data to encode
+        /// \param[in ] size     Length of `data` in bytes
+        /// \param[in ] is_last  Is this the last block of data?
+        ///
+        /// \returns Output iterator past the last character written
+        ///
+        template<class _OutIt>
+        inline _OutIt encode(_In_ _OutIt out, _In_bytecount_(size) const void *data, _In_ size_t size, _In_opt_ bool is_last = true)
+        {
+            assert(data || !size);
+
+            const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+            size_t i = 0;
+
+            // Complete the group left over from the previous block first.
+            if (num) {
+                for (; num < 3 && i < size; i++)
+                    buf[num++] = in[i];
                 if (num >= 3) {
-                    encode(out);
+                    out = encode(out);
                     num = 0;
                 }
+            }
 
-                if (i >= size)
-                    break;
+            // Convert all complete groups directly from the input.
+            size_t size_bulk = (size - i)/3*3;
+            if (size_bulk) {
+                out = encode_bulk(out, in + i, size_bulk);
+                i += size_bulk;
+            }
 
-                buf[num++] = reinterpret_cast<const unsigned char*>(data)[i];
+            // Keep the remainder for the next block.
+            for (; i < size; i++)
+                buf[num++] = in[i];
+
+            // If this is the last block, flush the buffer.
+            if (is_last && num) {
+                out = encode(out, num);
+                num = 0;
+            }
+
+            return out;
+        }
+
+
+        ///
+        /// Encodes one block of information using multiple threads, and _appends_ it to the output
+        ///
+        /// The data is split into chunks of complete groups. Each thread encodes its chunk into its own precomputed part of
+        /// the output. The output is identical to `encode()`.
+        ///
+        /// \param[out] out      Output
+        /// \param[in ] data     Data to encode
+        /// \param[in ] size     Length of `data` in bytes
+        /// \param[in ] is_last  Is this the last block of data?
+        /// \param[in ] threads  Maximum number of threads to use (0 = number of logical processors)
+        ///
+        template<class _Elem, class _Traits, class _Ax>
+        inline void encode_parallel(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &out, _In_bytecount_(size) const void *data, _In_ size_t size, _In_opt_ bool is_last = true, _In_opt_ size_t threads = 0)
+        {
+            assert(data || !size);
+
+            threads = parallel_threads(size, threads);
+            if (threads <= 1) {
+                encode(out, data, size, is_last);
+                return;
+            }
+
+            // Preallocate output
+            size_t offset = out.size();
+            out.resize(offset + enc_size(size));
+            _Elem *dst = &out[0] + offset;
+
+            const unsigned char *in = reinterpret_cast<const unsigned char*>(data);
+            size_t i = 0;
+
+            // Complete the group left over from the previous block first.
+            if (num) {
+                for (; num < 3 && i < size; i++)
+                    buf[num++] = in[i];
+                if (num >= 3) {
+                    dst = encode(dst);
+                    num = 0;
+                }
             }
 
+            // Split complete groups evenly among threads.
+            size_t groups = (size - i)/3, line_end;
+            parallel_for(threads, [&](size_t k) {
+                size_t
+                    g_start = groups*k/threads,
+                    g_end   = groups*(k + 1)/threads;
+                basic_base64_enc<_Alphabet> worker;
+                _Elem *dst_worker = dst + advance(g_start, worker.line);
+                worker.encode_bulk(dst_worker, in + i + g_start*3, (g_end - g_start)*3);
+            });
+            dst += advance(groups, line_end);
+            line = line_end;
+            i += groups*3;
+
+            // Keep the remainder for the next block.
+            for (; i < size; i++)
+                buf[num++] = in[i];
+
             // If this is the last block, flush the buffer.
             if (is_last && num) {
-                encode(out, num);
+                dst = encode(dst, num);
                 num = 0;
             }
+
+            out.resize(dst - &out[0]);
         }
 
 
@@ -102,6 +491,7 @@ namespace winstd
         inline void clear()
         {
             num = 0;
+            line = 0;
         }
 
 
@@ -114,75 +504,225 @@ namespace winstd
         ///
         inline size_t enc_size(size_t size) const
         {
-            return ((num + size + 2)/3)*4;
+            size_t n = ((num + size + 2)/3)*4;
+            if (_Alphabet::line_max)
+                n += (line + n)/_Alphabet::line_max*2;
+            return n;
         }
 
 
     protected:
+        ///
+        /// Returns maximum number of 4-character groups that fit into given number of characters, line breaks included
+        ///
+        inline size_t groups_max(_In_ size_t capacity) const
+        {
+            if (!_Alphabet::line_max)
+                return capacity/4;
+
+            // Groups to complete the current line
+            const size_t line_groups = _Alphabet::line_max/4;
+            size_t groups = line_groups - line/4;
+            if (capacity <= groups*4)
+                return capacity/4;
+            capacity -= groups*4;
+
+            // Complete lines, each starting with a line break
+            const size_t line_size = 2 + _Alphabet::line_max;
+            groups += capacity/line_size*line_groups;
+            capacity %= line_size;
+
+            // Last incomplete line
+            return capacity > 2 ? groups + (capacity - 2)/4 : groups;
+        }
+
+
+        ///
+        /// Calculates the effect of encoding complete groups
+        ///
+        /// \param[in ] groups    Number of complete groups to encode
+        /// \param[out] line_end  Number of characters on the current line after encoding
+        ///
+        /// \returns Number of characters the groups encode to, line breaks included
+        ///
+        inline size_t advance(_In_ size_t groups, _Out_ size_t &line_end) const
+        {
+            if (!_Alphabet::line_max || !groups) {
+                line_end = line + groups*4;
+                return groups*4;
+            }
+
+            // A line break precedes each group starting at a multiple of line length.
+            size_t
+                pos    = line + groups*4,
+                breaks = pos - 4 >= _Alphabet::line_max ? (pos - 4)/_Alphabet::line_max : 0;
+            line_end = pos - breaks*_Alphabet::line_max;
+            return groups*4 + breaks*2;
+        }
+
+
+        ///
+        /// Starts a new line when the current one is full
+        ///
+        template<class _OutIt>
+        inline _OutIt wrap(_In_ _OutIt out)
+        {
+            if (_Alphabet::line_max && line >= _Alphabet::line_max) {
+                *out++ = '\r';
+                *out++ = '\n';
+                line = 0;
+            }
+            return out;
+        }
+
+
         ///
         /// Encodes one complete internal buffer of data
         ///
-        template<class _Elem, class _Traits, class _Ax>
-        inline void encode(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &out)
+        template<class _OutIt>
+        inline _OutIt encode(_In_ _OutIt out)
+        {
+            out = wrap(out);
+            *out++ = _Alphabet::lookup_enc[                  buf[0] >> 2         ];
+            *out++ = _Alphabet::lookup_enc[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
+            *out++ = _Alphabet::lookup_enc[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
+            *out++ = _Alphabet::lookup_enc[                  buf[2]        & 0x3f];
+            line += 4;
+            return out;
+        }
+
+
+        ///
+        /// Encodes complete groups of data, wrapping lines as required
+        ///
+        /// \param[out] out   Output iterator
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes. Must be a multiple of 3.
+        ///
+        /// \returns Output iterator past the last character written
+        ///
+        template<class _OutIt>
+        inline _OutIt encode_bulk(_In_ _OutIt out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size)
+        {
+            if (!_Alphabet::line_max)
+                return encode_groups(out, data, size);
+
+            for (size_t i = 0; i < size;) {
+                out = wrap(out);
+                size_t n = std::min<size_t>(size - i, (_Alphabet::line_max - line)/4*3);
+                out   = encode_groups(out, data + i, n);
+                line += n/3*4;
+                i    += n;
+            }
+            return out;
+        }
+
+
+        ///
+        /// Encodes complete groups of data
+        ///
+        /// \param[out] out   Output iterator
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes. Must be a multiple of 3.
+        ///
+        /// \returns Output iterator past the last character written
+        ///
+        template<class _OutIt>
+        static inline _OutIt encode_groups(_In_ _OutIt out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size)
+        {
+            assert(size % 3 == 0);
+
+            // Convert in stack buffer sized chunks, then copy.
+            char chunk[WINSTD_STACK_BUFFER_BYTES/4*4];
+            const size_t chunk_in = _countof(chunk)/4*3;
+            for (size_t i = 0; i < size; i += chunk_in) {
+                for (const char *c = chunk, *c_end = encode_groups(chunk, data + i, std::min<size_t>(size - i, chunk_in)); c < c_end; c++)
+                    *out++ = *c;
+            }
+            return out;
+        }
+
+
+        ///
+        /// Encodes complete groups of data
+        ///
+        /// Uses the fastest implementation the CPU supports: AVX2, SSSE3 or plain C.
+        ///
+        /// \param[out] out   Output. Must have room for `size/3*4` characters.
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes. Must be a multiple of 3.
+        ///
+        /// \returns Pointer past the last character written
+        ///
+        static inline char *encode_groups(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size)
         {
-            out += lookup[                  buf[0] >> 2         ];
-            out += lookup[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
-            out += lookup[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
-            out += lookup[                  buf[2]        & 0x3f];
+            return base64_encode_groups(out, data, size, _Alphabet::lookup_enc);
         }
 
 
         ///
         /// Encodes partial internal buffer of data
         ///
-        template<class _Elem, class _Traits, class _Ax>
-        inline void encode(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &out, _In_ size_t size)
+        template<class _OutIt>
+        inline _OutIt encode(_In_ _OutIt out, _In_ size_t size)
         {
+            out = wrap(out);
             if (size > 0) {
-                out += lookup[buf[0] >> 2];
+                *out++ = _Alphabet::lookup_enc[buf[0] >> 2];
                 if (size > 1) {
-                    out += lookup[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
+                    *out++ = _Alphabet::lookup_enc[((buf[0] << 4) | (buf[1] >> 4)) & 0x3f];
                     if (size > 2) {
-                        out += lookup[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
-                        out += lookup[buf[2] & 0x3f];
+                        *out++ = _Alphabet::lookup_enc[((buf[1] << 2) | (buf[2] >> 6)) & 0x3f];
+                        *out++ = _Alphabet::lookup_enc[buf[2] & 0x3f];
+                        line += 4;
                     } else {
-                        out += lookup[(buf[1] << 2) & 0x3f];
-                        out += '=';
+                        *out++ = _Alphabet::lookup_enc[(buf[1] << 2) & 0x3f];
+                        line += 3;
+                        if (_Alphabet::padding) {
+                            *out++ = '=';
+                            line++;
+                        }
                     }
                 } else {
-                    out += lookup[(buf[0] << 4) & 0x3f];
-                    out += '=';
-                    out += '=';
+                    *out++ = _Alphabet::lookup_enc[(buf[0] << 4) & 0x3f];
+                    line += 2;
+                    if (_Alphabet::padding) {
+                        *out++ = '=';
+                        *out++ = '=';
+                        line += 2;
+                    }
                 }
-            } else {
-                out += '=';
-                out += '=';
-                out += '=';
-                out += '=';
+            } else if (_Alphabet::padding) {
+                *out++ = '=';
+                *out++ = '=';
+                *out++ = '=';
+                *out++ = '=';
+                line += 4;
             }
+            return out;
         }
 
 
     protected:
         unsigned char buf[3];           ///< Internal buffer
         size_t num;                     ///< Number of bytes used in `buf`
-
-        /// \cond internal
-        static const char lookup[64];
-        /// \endcond
+        size_t line;                    ///< Number of characters on the current line
     };
 
 
     ///
     /// Base64 decoding session
     ///
-    class WINSTD_API base64_dec
+    /// \tparam _Alphabet  Alphabet policy: `base64_std`, `base64_std_nopad`, `base64_url`, `base64_url_nopad` or `base64_mime`
+    ///
+    template<class _Alphabet>
+    class basic_base64_dec
     {
     public:
         ///
         /// Constructs blank decoding session
         ///
-        inline base64_dec() : num(0)
+        inline basic_base64_dec() : num(0)
         {
             buf[0] = 0;
             buf[1] = 0;
@@ -202,19 +742,42 @@ namespace winstd
         template<class _Ty, class _Ax, class _Tchr>
         inline void decode(_Inout_ std::vector<_Ty, _Ax> &out, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
         {
-            is_last = false;
+            // Preallocate output and decode directly into it.
+            size_t offset = out.size(), consumed;
+            out.resize(offset + dec_size(size));
+            out.resize(offset + decode(out.data() + offset, out.size() - offset, consumed, is_last, data, size));
+        }
 
-            // Trim data size to first terminator.
-            for (size_t k = 0; k < size; k++)
-                if (!data[k]) { size = k; break; }
 
-            // Preallocate output
-            out.reserve(out.size() + dec_size(size));
+        ///
+        /// Decodes one block of information into a buffer
+        ///
+        /// Decoding stops at the terminator, after the padding, or when the buffer might not have enough room for the next group.
+        ///
+        /// \param[out] out       Output
+        /// \param[in ] capacity  Size of `out` in elements. `dec_size(size)` elements is always sufficient.
+        /// \param[out] consumed  Number of characters of `data` consumed
+        /// \param[out] is_last   Was this the last block of data?
+        /// \param[in ] data      Data to decode
+        /// \param[in ] size      Length of `data` in characters
+        ///
+        /// \returns Number of elements written to `out`
+        ///
+        template<class _Ty, class _Tchr>
+        inline size_t decode(_Out_writes_to_(capacity, return) _Ty *out, _In_ size_t capacity, _Out_ size_t &consumed, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            is_last = false;
 
-            for (size_t i = 0;; i++) {
+            // Take only as much data as there is room for all groups it might complete.
+            size = std::min<size_t>(size, capacity/3*4 + 3 - num);
+
+            _Ty *dst = out;
+            size_t i = 0;
+            for (;;) {
                 if (num >= 4) {
                     // Buffer full; decode it.
-                    size_t nibbles = decode(out);
+                    size_t nibbles = decode(dst);
+                    dst += nibbles;
                     num = 0;
                     if (nibbles < 3) {
                         is_last = true;
@@ -222,50 +785,355 @@ namespace winstd
                     }
                 }
 
+                if (!num && sizeof(_Ty) == 1) {
+                    // Decode as many complete groups as possible directly from the input.
+                    size_t n = decode_bulk(reinterpret_cast<unsigned char*>(dst), data + i, size - i);
+                    dst += n/4*3;
+                    i   += n;
+                }
+
                 if (i >= size)
                     break;
 
-                int x = data[i];
-                if ((buf[num] = x < _countof(lookup) ? lookup[x] : 255) != 255)
+                if (!data[i]) {
+                    // Terminator reached.
+                    break;
+                }
+                if ((buf[num] = lookup(data[i++])) != 255)
                     num++;
             }
+
+            consumed = i;
+            return dst - out;
         }
 
 
         ///
-        /// Resets decoding session
+        /// Decodes one block of information strictly, and _appends_ it to the output
         ///
-        inline void clear()
+        /// Unlike `decode()`, which skips anything but the Base64 alphabet, decoding stops at the first character that is
+        /// neither in the alphabet nor white-space (space, tab, CR or LF), and at padding in a wrong place. Decoding also
+        /// stops after the padding.
+        ///
+        /// \param[inout] out      Output
+        /// \param[out  ] is_last  Was the padding reached?
+        /// \param[in   ] data     Data to decode
+        /// \param[in   ] size     Length of `data` in characters
+        ///
+        /// \returns Position of the first invalid character, or of the character following the padding; `size` if there is none
+        ///
+        template<class _Ty, class _Ax, class _Tchr>
+        inline size_t decode_strict(_Inout_ std::vector<_Ty, _Ax> &out, _Out_ bool &is_last, _In_count_(size) const _Tchr *data, _In_ size_t size)
         {
-            num = 0;
+            // Preallocate output and decode directly into it.
+            size_t offset = out.size(), written;
+            out.resize(offset + dec_size(size));
+            size_t result = decode_strict(out.data() + offset, written, is_last, data, size);
+            out.resize(offset + written);
+            return result;
         }
 
 
         ///
-        /// Returns maximum decoded size
+        /// Decodes one block of information strictly into a buffer
         ///
-        /// \param size  Number of bytes to decode
+        /// \copydetails decode_strict(std::vector<_Ty, _Ax> &, bool &, const _Tchr *, size_t)
         ///
-        /// \returns Maximum number of bytes for the decoded data of `size` length
+        /// \param[out] out      Output. Must have room for `dec_size(size)` elements.
+        /// \param[out] written  Number of elements written to `out`
         ///
-        inline size_t dec_size(size_t size) const
+        template<class _Ty, class _Tchr>
+        inline size_t decode_strict(_Out_writes_to_(dec_size(size), written) _Ty *out, _Out_ size_t &written, _Out_ bool &is_last, _In_count_(size) const _Tchr *data, _In_ size_t size)
         {
-            return ((num + size + 3)/4)*3;
-        }
+            is_last = false;
 
+            _Ty *dst = out;
+            size_t i = 0;
+            for (;;) {
+                if (!num && sizeof(_Ty) == 1) {
+                    // Decode as many complete groups as possible directly from the input.
+                    size_t n = decode_bulk(reinterpret_cast<unsigned char*>(dst), data + i, size - i);
+                    dst += n/4*3;
+                    i   += n;
+                }
 
-    protected:
-        ///
-        /// Decodes one complete internal buffer of data
-        ///
-        template<class _Ty, class _Ax>
-        inline size_t decode(_Inout_ std::vector<_Ty, _Ax> &out)
+                if (i >= size)
+                    break;
+
+                unsigned char x = lookup(data[i]);
+                if (x < 64) {
+                    if (num && buf[num - 1] == 64) {
+                        // Only padding may follow padding.
+                        break;
+                    }
+                } else if (x == 64) {
+                    if (num < 2) {
+                        // Padding can replace the last two characters of a group at most.
+                        break;
+                    }
+                } else if (is_space(data[i])) {
+                    i++;
+                    continue;
+                } else
+                    break;
+
+                buf[num++] = x;
+                i++;
+                if (num >= 4) {
+                    // Buffer full; decode it.
+                    dst += decode(dst);
+                    num = 0;
+                    if (x == 64) {
+                        is_last = true;
+                        break;
+                    }
+                }
+            }
+
+            written = dst - out;
+            return i;
+        }
+
+
+        ///
+        /// Decodes one block of information, and writes it to the output iterator
+        ///
+        /// \param[out] out      Output iterator
+        /// \param[out] is_last  Was this the last block of data?
+        /// \param[in ] data     Data to decode
+        /// \param[in ] size     Length of `data` in characters
+        ///
+        /// \returns Output iterator past the last element written
+        ///
+        template<class _OutIt, class _Tchr>
+        inline _OutIt decode(_In_ _OutIt out, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            // Decode in stack buffer sized chunks, then copy.
+            unsigned char chunk[WINSTD_STACK_BUFFER_BYTES];
+            do {
+                size_t consumed, n = decode(chunk, _countof(chunk), consumed, is_last, data, size);
+                for (size_t i = 0; i < n; i++)
+                    *out++ = chunk[i];
+                data += consumed;
+                size -= consumed;
+            } while (!is_last && size && *data);
+            return out;
+        }
+
+
+        ///
+        /// Decodes one block of information using multiple threads, and _appends_ it to the output
+        ///
+        /// The data is split into chunks. The threads first count the Base64 characters in each chunk to determine where
+        /// the groups start. Then, each thread decodes groups starting in its chunk into its own precomputed part of the
+        /// output. Data following the padding or terminator is decoded sequentially. The output is identical to `decode()`.
+        ///
+        /// \param[out] out      Output
+        /// \param[out] is_last  Was this the last block of data?
+        /// \param[in ] data     Data to decode
+        /// \param[in ] size     Length of `data` in characters
+        /// \param[in ] threads  Maximum number of threads to use (0 = number of logical processors)
+        ///
+        template<class _Ty, class _Ax, class _Tchr>
+        inline void decode_parallel(_Inout_ std::vector<_Ty, _Ax> &out, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size, _In_opt_ size_t threads = 0)
+        {
+            threads = parallel_threads(size*sizeof(_Tchr), threads);
+            if (threads <= 1) {
+                decode(out, is_last, data, size);
+                return;
+            }
+
+            is_last = false;
+
+            // Preallocate output
+            size_t offset = out.size(), consumed;
+            out.resize(offset + dec_size(size));
+            _Ty *dst = out.data() + offset, *dst_end = out.data() + out.size();
+            size_t i = 0;
+
+            // Complete the group left over from the previous block first.
+            while (num && i < size && data[i]) {
+                dst += decode(dst, dst_end - dst, consumed, is_last, data + i, 1);
+                i += consumed;
+                if (is_last) {
+                    out.resize(dst - out.data());
+                    return;
+                }
+            }
+            if (num) {
+                // The block ended before completing the group. Keep it for the next block.
+                out.resize(dst - out.data());
+                return;
+            }
+
+            // Count Base64 characters in chunks up to the first padding or terminator.
+            struct chunk_info {
+                size_t start, end, count;
+                bool stop;
+            };
+            std::vector<chunk_info> chunks(threads);
+            parallel_for(threads, [&](size_t k) {
+                chunk_info &c = chunks[k];
+                c.start = i + (size - i)*k/threads;
+                c.end   = i + (size - i)*(k + 1)/threads;
+                c.count = 0;
+                c.stop  = false;
+                for (size_t j = c.start; j < c.end; j++) {
+                    unsigned char x = lookup(data[j]);
+                    if (x < 64)
+                        c.count++;
+                    else if (x == 64 || !data[j]) {
+                        c.end  = j;
+                        c.stop = true;
+                        break;
+                    }
+                }
+            });
+            size_t count = 0, end = i;
+            for (size_t k = 0; k < threads; k++) {
+                // From now on, count is the number of Base64 characters preceding the chunk.
+                size_t n = chunks[k].count;
+                chunks[k].count = count;
+                count += n;
+                end = chunks[k].end;
+                if (chunks[k].stop) {
+                    chunks.resize(k + 1);
+                    break;
+                }
+            }
+
+            // Decode groups starting in each chunk.
+            parallel_for(chunks.size(), [&](size_t k) {
+                const chunk_info &c = chunks[k];
+                size_t j = c.start;
+
+                // Skip characters of the group started in the previous chunk.
+                for (size_t skip = (4 - c.count % 4) % 4; skip && j < c.end; j++)
+                    if (lookup(data[j]) < 64)
+                        skip--;
+
+                basic_base64_dec<_Alphabet> worker;
+                size_t worker_consumed;
+                bool worker_is_last;
+                _Ty *dst_worker = dst + (c.count + 3)/4*3;
+                dst_worker += worker.decode(dst_worker, worker.dec_size(c.end - j), worker_consumed, worker_is_last, data + j, c.end - j);
+
+                // Complete the last group with characters from the following chunks.
+                for (j = c.end; worker.num && j < end; j++) {
+                    if ((worker.buf[worker.num] = lookup(data[j])) < 64 && ++worker.num >= 4) {
+                        worker.decode(dst_worker);
+                        worker.num = 0;
+                    }
+                }
+            });
+            dst += count/4*3;
+
+            // Keep the characters of the last incomplete group.
+            num = count % 4;
+            for (size_t j = end, n = num; n; )
+                if ((buf[n - 1] = lookup(data[--j])) < 64)
+                    n--;
+
+            // Decode the rest sequentially.
+            dst += decode(dst, dst_end - dst, consumed, is_last, data + end, size - end);
+            out.resize(dst - out.data());
+        }
+
+
+        ///
+        /// Decodes the incomplete last group of unpadded data, and _appends_ it to the output
+        ///
+        /// \param[out] out  Output
+        ///
+        template<class _Ty, class _Ax>
+        inline void flush(_Inout_ std::vector<_Ty, _Ax> &out)
+        {
+            _Ty tail[2];
+            out.insert(out.end(), tail, tail + flush(tail));
+        }
+
+
+        ///
+        /// Decodes the incomplete last group of unpadded data into a buffer
+        ///
+        /// \param[out] out  Output. Must have room for 2 elements.
+        ///
+        /// \returns Number of elements written to `out`
+        ///
+        template<class _Ty>
+        inline size_t flush(_Out_writes_to_(2, return) _Ty *out)
+        {
+            size_t n = 0;
+            if (num >= 2) {
+                // Pad the group, then decode it.
+                for (size_t i = num; i < 4; i++)
+                    buf[i] = 64;
+                n = decode(out);
+            }
+            num = 0;
+            return n;
+        }
+
+
+        ///
+        /// Resets decoding session
+        ///
+        inline void clear()
         {
-            out.push_back((_Ty)(((buf[0] << 2) | (buf[1] >> 4)) & 0xff));
+            num = 0;
+        }
+
+
+        ///
+        /// Returns maximum decoded size
+        ///
+        /// \param size  Number of bytes to decode
+        ///
+        /// \returns Maximum number of bytes for the decoded data of `size` length
+        ///
+        inline size_t dec_size(size_t size) const
+        {
+            return ((num + size + 3)/4)*3;
+        }
+
+
+    protected:
+        ///
+        /// Returns 6-bit value of a character: 64 for padding, 255 for characters to skip
+        ///
+        template<class _Tchr>
+        static inline unsigned char lookup(_In_ _Tchr chr)
+        {
+            auto x = static_cast<typename std::make_unsigned<_Tchr>::type>(chr);
+            return x < _countof(_Alphabet::lookup_dec) ? _Alphabet::lookup_dec[x] : 255;
+        }
+
+
+        ///
+        /// Returns `true` for white-space allowed between Base64 characters: space, tab, CR and LF
+        ///
+        template<class _Tchr>
+        static inline bool is_space(_In_ _Tchr chr)
+        {
+            return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+        }
+
+
+        ///
+        /// Decodes one complete internal buffer of data
+        ///
+        /// \param[out] out  Output. Must have room for 3 elements.
+        ///
+        /// \returns Number of elements written to `out`
+        ///
+        template<class _Ty>
+        inline size_t decode(_Out_writes_to_(3, return) _Ty *out) const
+        {
+            out[0] = (_Ty)(((buf[0] << 2) | (buf[1] >> 4)) & 0xff);
             if (buf[2] < 64) {
-                out.push_back((_Ty)(((buf[1] << 4) | (buf[2] >> 2)) & 0xff));
+                out[1] = (_Ty)(((buf[1] << 4) | (buf[2] >> 2)) & 0xff);
                 if (buf[3] < 64) {
-                    out.push_back((_Ty)(((buf[2] << 6) | buf[3]) & 0xff));
+                    out[2] = (_Ty)(((buf[2] << 6) | buf[3]) & 0xff);
                     return 3;
                 } else
                     return 2;
@@ -274,13 +1142,552 @@ namespace winstd
         }
 
 
+        ///
+        /// Decodes complete groups of data
+        ///
+        /// Generic character types are decoded character by character.
+        ///
+        /// \returns Always 0
+        ///
+        template<class _Tchr>
+        static inline size_t decode_bulk(_Out_ unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            UNREFERENCED_PARAMETER(out);
+            UNREFERENCED_PARAMETER(data);
+            UNREFERENCED_PARAMETER(size);
+            return 0;
+        }
+
+
+        ///
+        /// Decodes complete groups of data
+        ///
+        /// Uses the fastest implementation the CPU supports: AVX2, SSSE3 or none. Decoding stops at the first block of
+        /// characters containing anything but the Base64 alphabet (white-space, padding, terminator, or invalid
+        /// characters), leaving it to the character by character decoder.
+        ///
+        /// \param[out] out   Output. Must have room for `size/4*3` bytes.
+        /// \param[in ] data  Data to decode
+        /// \param[in ] size  Length of `data` in characters
+        ///
+        /// \returns Number of characters decoded. Always a multiple of 4.
+        ///
+        static inline size_t decode_bulk(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const char *data, _In_ size_t size)
+        {
+            return base64_decode_groups(out, data, size, _Alphabet::lookup_enc[62], _Alphabet::lookup_enc[63]);
+        }
+
+
+        ///
+        /// Decodes complete groups of data
+        ///
+        /// \copydetails decode_bulk(unsigned char *, const char *, size_t)
+        ///
+        static inline size_t decode_bulk(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size)
+        {
+            return base64_decode_groups(out, data, size, _Alphabet::lookup_enc[62], _Alphabet::lookup_enc[63]);
+        }
+
+
     protected:
         unsigned char buf[4];                   ///< Internal buffer
         size_t num;                             ///< Number of bytes used in `buf`
+    };
+
+
+    /// \cond internal
+
+    ///
+    /// Returns 6-bit value of a Base64 character. Throws when the character is not in the alphabet.
+    ///
+    template<class _Alphabet>
+    constexpr unsigned char base64_value(_In_ char chr)
+    {
+        return
+            _Alphabet::lookup_dec[(unsigned char)chr] < 64 ? _Alphabet::lookup_dec[(unsigned char)chr] :
+            throw std::invalid_argument("Not a Base64 character");
+    }
+
+
+    ///
+    /// Returns length of Base64 encoded data of `size` bytes, without line breaks
+    ///
+    template<class _Alphabet>
+    constexpr size_t base64_enc_length(_In_ size_t size)
+    {
+        return _Alphabet::padding ? (size + 2)/3*4 : (size*4 + 2)/3;
+    }
+
+
+    ///
+    /// Checks Base64 string for data of `size` bytes. Throws when malformed.
+    ///
+    template<class _Alphabet>
+    constexpr bool base64_dec_check(_In_z_count_(length) const char *str, _In_ size_t length, _In_ size_t size)
+    {
+        for (size_t i = 0, n = (size*4 + 2)/3; i < length; i++) {
+            if (i < n)
+                base64_value<_Alphabet>(str[i]);
+            else if (str[i] != '=')
+                throw std::invalid_argument("Invalid Base64 padding");
+        }
+        return true;
+    }
+
+
+    ///
+    /// Decodes byte at `idx` of Base64 string
+    ///
+    template<class _Alphabet>
+    constexpr unsigned char base64_dec_byte(_In_z_ const char *str, _In_ size_t idx)
+    {
+        return
+            idx % 3 == 0 ? (unsigned char)((base64_value<_Alphabet>(str[idx/3*4    ]) << 2) | (base64_value<_Alphabet>(str[idx/3*4 + 1]) >> 4)) :
+            idx % 3 == 1 ? (unsigned char)((base64_value<_Alphabet>(str[idx/3*4 + 1]) << 4) | (base64_value<_Alphabet>(str[idx/3*4 + 2]) >> 2)) :
+                           (unsigned char)((base64_value<_Alphabet>(str[idx/3*4 + 2]) << 6) | (base64_value<_Alphabet>(str[idx/3*4 + 3])     ));
+    }
+
+
+    template<class _Alphabet, size_t... _Idx>
+    constexpr std::array<unsigned char, sizeof...(_Idx)> base64_dec_array(_In_z_ const char *str, _In_ std::index_sequence<_Idx...>)
+    {
+        return {{ base64_dec_byte<_Alphabet>(str, _Idx)... }};
+    }
+
+
+    ///
+    /// Encodes character at `idx` of Base64 encoded data
+    ///
+    template<class _Alphabet, size_t _Size>
+    constexpr char base64_enc_char(_In_ const std::array<unsigned char, _Size> &data, _In_ size_t idx)
+    {
+        return
+            idx >= base64_enc_length<_Alphabet>(_Size) ? '\0' :
+            idx >= (_Size*4 + 2)/3 ? '=' :
+            _Alphabet::lookup_enc[
+                idx % 4 == 0 ?                                               (data[idx/4*3    ] >> 2) :
+                idx % 4 == 1 ? (((data[idx/4*3    ] & 0x03) << 4) | (idx/4*3 + 1 < _Size ? data[idx/4*3 + 1] >> 4 : 0)) :
+                idx % 4 == 2 ? (((data[idx/4*3 + 1] & 0x0f) << 2) | (idx/4*3 + 2 < _Size ? data[idx/4*3 + 2] >> 6 : 0)) :
+                                 (data[idx/4*3 + 2] & 0x3f)];
+    }
 
-        /// \cond internal
-        static const unsigned char lookup[256];
-        /// \endcond
+
+    template<class _Alphabet, size_t _Size, size_t... _Idx>
+    constexpr std::array<char, sizeof...(_Idx)> base64_enc_array(_In_ const std::array<unsigned char, _Size> &data, _In_ std::index_sequence<_Idx...>)
+    {
+        return {{ base64_enc_char<_Alphabet>(data, _Idx)... }};
+    }
+
+    /// \endcond
+
+
+    ///
+    /// Returns size of data Base64 string literal decodes to
+    ///
+    /// \param[in] str  Base64 string literal
+    ///
+    /// \returns Number of bytes
+    ///
+    template<size_t _Len>
+    constexpr size_t base64_dec_size(_In_z_ const char (&str)[_Len])
+    {
+        return
+            _Len >= 3 && str[_Len - 3] == '=' ? (_Len - 1)*3/4 - 2 :
+            _Len >= 2 && str[_Len - 2] == '=' ? (_Len - 1)*3/4 - 1 :
+                                                (_Len - 1)*3/4;
+    }
+
+
+    ///
+    /// Decodes Base64 string literal at compile time
+    ///
+    /// Use in constant expressions to embed binary data without runtime decoding:
+    /// \code
+    /// constexpr std::array<unsigned char, winstd::base64_dec_size("SGVsbG8=")> hello = winstd::base64_dec_array<winstd::base64_dec_size("SGVsbG8=")>("SGVsbG8=");
+    /// \endcode
+    /// Literals containing characters outside the alphabet, white-space, line breaks, or padding not matching the data
+    /// size, fail to compile.
+    ///
+    /// \tparam _Size      Size of decoded data in bytes
+    /// \tparam _Alphabet  Alphabet and padding policy
+    ///
+    /// \param[in] str  Base64 string literal
+    ///
+    /// \returns Decoded data
+    ///
+    template<size_t _Size, class _Alphabet = base64_std, size_t _Len>
+    constexpr std::array<unsigned char, _Size> base64_dec_array(_In_z_ const char (&str)[_Len])
+    {
+        static_assert(_Len - 1 == base64_enc_length<_Alphabet>(_Size), "Base64 string length does not match data size");
+        base64_dec_check<_Alphabet>(str, _Len - 1, _Size);
+        return base64_dec_array<_Alphabet>(str, std::make_index_sequence<_Size>());
+    }
+
+
+    ///
+    /// Encodes data as Base64 at compile time
+    ///
+    /// Line breaks are never inserted.
+    ///
+    /// \tparam _Alphabet  Alphabet and padding policy
+    ///
+    /// \param[in] data  Data to encode
+    ///
+    /// \returns Zero-terminated Base64 string
+    ///
+    template<class _Alphabet = base64_std, size_t _Size>
+    constexpr std::array<char, base64_enc_length<_Alphabet>(_Size) + 1> base64_enc_array(_In_ const std::array<unsigned char, _Size> &data)
+    {
+        return base64_enc_array<_Alphabet>(data, std::make_index_sequence<base64_enc_length<_Alphabet>(_Size) + 1>());
+    }
+
+
+    ///
+    /// Base64 encoding output stream buffer
+    ///
+    /// Data written is encoded in blocks and passed to the target stream buffer, so memory use is constant regardless of
+    /// the size of data. Call `finish()` (or destroy the stream buffer) after the last byte is written to emit the last
+    /// group.
+    ///
+    template<class _Alphabet, class _Elem, class _Traits>
+    class basic_base64_enc_ostreambuf : public std::streambuf
+    {
+        WINSTD_NONCOPYABLE(basic_base64_enc_ostreambuf)
+
+    public:
+        ///
+        /// Constructs encoding stream buffer
+        ///
+        /// \param[in] target  Stream buffer to write encoded data to
+        ///
+        inline basic_base64_enc_ostreambuf(_In_ std::basic_streambuf<_Elem, _Traits> *target) :
+            m_target(target),
+            m_finished(false)
+        {
+            setp(m_in, m_in + _countof(m_in));
+        }
+
+
+        ///
+        /// Finishes encoding and destroys the stream buffer
+        ///
+        virtual ~basic_base64_enc_ostreambuf()
+        {
+            finish();
+        }
+
+
+        ///
+        /// Encodes pending data, emits the last group and flushes the target stream buffer
+        ///
+        /// No data can be written after this call.
+        ///
+        /// \returns
+        /// - `true` on success;
+        /// - `false` when the target stream buffer failed to accept the data.
+        ///
+        inline bool finish()
+        {
+            if (m_finished)
+                return true;
+            m_finished = true;
+            bool result = encode(true) && m_target->pubsync() == 0;
+            setp(m_in, m_in);
+            return result;
+        }
+
+
+    protected:
+        virtual int_type overflow(_In_ int_type ch = traits_type::eof())
+        {
+            if (m_finished || !encode(false))
+                return traits_type::eof();
+            if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+
+        virtual int sync()
+        {
+            return (m_finished || encode(false)) && m_target->pubsync() == 0 ? 0 : -1;
+        }
+
+
+        ///
+        /// Encodes data in the put area and writes it to the target stream buffer
+        ///
+        inline bool encode(_In_ bool is_last)
+        {
+            const char *data = pbase();
+            size_t size = pptr() - pbase();
+            do {
+                size_t consumed, n = m_enc.encode(m_out, _countof(m_out), consumed, data, size, is_last);
+                if (m_target->sputn(m_out, n) != (std::streamsize)n)
+                    return false;
+                data += consumed;
+                size -= consumed;
+            } while (size);
+            setp(m_in, m_in + _countof(m_in));
+            return true;
+        }
+
+
+    protected:
+        std::basic_streambuf<_Elem, _Traits> *m_target;            ///< Target stream buffer
+        basic_base64_enc<_Alphabet> m_enc;                          ///< Encoding session
+        bool m_finished;                                            ///< Was the last group emitted?
+        char m_in[WINSTD_STACK_BUFFER_BYTES/4*3];                   ///< Data pending encoding
+        _Elem m_out[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];       ///< Encoded data
+    };
+
+
+    ///
+    /// Base64 encoding input stream buffer
+    ///
+    /// Reads data from the source stream buffer in blocks and provides it encoded, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Alphabet, class _Elem, class _Traits>
+    class basic_base64_enc_istreambuf : public std::basic_streambuf<_Elem, _Traits>
+    {
+        WINSTD_NONCOPYABLE(basic_base64_enc_istreambuf)
+
+    public:
+        typedef typename std::basic_streambuf<_Elem, _Traits>::int_type int_type;
+
+        ///
+        /// Constructs encoding stream buffer
+        ///
+        /// \param[in] source  Stream buffer to read data to encode from
+        ///
+        inline basic_base64_enc_istreambuf(_In_ std::streambuf *source) :
+            m_source(source),
+            m_head(0),
+            m_tail(0),
+            m_is_last(false),
+            m_finished(false)
+        {
+        }
+
+
+    protected:
+        virtual int_type underflow()
+        {
+            while (!m_finished) {
+                if (m_head >= m_tail && !m_is_last) {
+                    m_head = 0;
+                    m_tail = (size_t)m_source->sgetn(m_in, _countof(m_in));
+                    m_is_last = !m_tail;
+                }
+                size_t consumed, n = m_enc.encode(m_out, _countof(m_out), consumed, m_in + m_head, m_tail - m_head, m_is_last);
+                m_head += consumed;
+                m_finished = m_is_last && m_head >= m_tail;
+                if (n) {
+                    this->setg(m_out, m_out, m_out + n);
+                    return _Traits::to_int_type(m_out[0]);
+                }
+            }
+            return _Traits::eof();
+        }
+
+
+    protected:
+        std::streambuf *m_source;                                   ///< Source stream buffer
+        basic_base64_enc<_Alphabet> m_enc;                          ///< Encoding session
+        size_t m_head;                                              ///< Start of data pending encoding in `m_in`
+        size_t m_tail;                                              ///< End of data pending encoding in `m_in`
+        bool m_is_last;                                             ///< Was the end of source reached?
+        bool m_finished;                                            ///< Was the last group emitted?
+        char m_in[WINSTD_STACK_BUFFER_BYTES/4*3];                   ///< Data read from source
+        _Elem m_out[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];       ///< Encoded data
+    };
+
+
+    ///
+    /// Base64 decoding output stream buffer
+    ///
+    /// Text written is decoded in blocks and passed to the target stream buffer, so memory use is constant regardless of
+    /// the size of data. Call `finish()` (or destroy the stream buffer) after the last character is written to decode the
+    /// incomplete last group of unpadded data.
+    ///
+    template<class _Alphabet, class _Elem, class _Traits>
+    class basic_base64_dec_ostreambuf : public std::basic_streambuf<_Elem, _Traits>
+    {
+        WINSTD_NONCOPYABLE(basic_base64_dec_ostreambuf)
+
+    public:
+        typedef typename std::basic_streambuf<_Elem, _Traits>::int_type int_type;
+
+        ///
+        /// Constructs decoding stream buffer
+        ///
+        /// \param[in] target  Stream buffer to write decoded data to
+        ///
+        inline basic_base64_dec_ostreambuf(_In_ std::streambuf *target) :
+            m_target(target),
+            m_finished(false)
+        {
+            this->setp(m_in, m_in + _countof(m_in));
+        }
+
+
+        ///
+        /// Finishes decoding and destroys the stream buffer
+        ///
+        virtual ~basic_base64_dec_ostreambuf()
+        {
+            finish();
+        }
+
+
+        ///
+        /// Decodes pending text, including the incomplete last group, and flushes the target stream buffer
+        ///
+        /// No text can be written after this call.
+        ///
+        /// \returns
+        /// - `true` on success;
+        /// - `false` when the target stream buffer failed to accept the data.
+        ///
+        inline bool finish()
+        {
+            if (m_finished)
+                return true;
+            m_finished = true;
+            char tail[3];
+            bool result = decode();
+            if (result) {
+                size_t n = m_dec.flush(tail);
+                result = m_target->sputn(tail, n) == (std::streamsize)n && m_target->pubsync() == 0;
+            }
+            this->setp(m_in, m_in);
+            return result;
+        }
+
+
+    protected:
+        virtual int_type overflow(_In_ int_type ch = _Traits::eof())
+        {
+            if (m_finished || !decode())
+                return _Traits::eof();
+            if (!_Traits::eq_int_type(ch, _Traits::eof())) {
+                *this->pptr() = _Traits::to_char_type(ch);
+                this->pbump(1);
+            }
+            return _Traits::not_eof(ch);
+        }
+
+
+        virtual int sync()
+        {
+            return (m_finished || decode()) && m_target->pubsync() == 0 ? 0 : -1;
+        }
+
+
+        ///
+        /// Decodes text in the put area and writes it to the target stream buffer
+        ///
+        inline bool decode()
+        {
+            const _Elem *data = this->pbase();
+            size_t size = this->pptr() - this->pbase();
+            while (size) {
+                bool is_last;
+                size_t consumed, n = m_dec.decode(m_out, _countof(m_out), consumed, is_last, data, size);
+                if (m_target->sputn(m_out, n) != (std::streamsize)n)
+                    return false;
+                if (consumed < size && !data[consumed]) {
+                    // Skip the terminator.
+                    consumed++;
+                }
+                data += consumed;
+                size -= consumed;
+            }
+            this->setp(m_in, m_in + _countof(m_in));
+            return true;
+        }
+
+
+    protected:
+        std::streambuf *m_target;                                   ///< Target stream buffer
+        basic_base64_dec<_Alphabet> m_dec;                          ///< Decoding session
+        bool m_finished;                                            ///< Was the last group decoded?
+        _Elem m_in[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];        ///< Text pending decoding
+        char m_out[WINSTD_STACK_BUFFER_BYTES/4*3];                  ///< Decoded data
+    };
+
+
+    ///
+    /// Base64 decoding input stream buffer
+    ///
+    /// Reads text from the source stream buffer in blocks and provides it decoded, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Alphabet, class _Elem, class _Traits>
+    class basic_base64_dec_istreambuf : public std::streambuf
+    {
+        WINSTD_NONCOPYABLE(basic_base64_dec_istreambuf)
+
+    public:
+        ///
+        /// Constructs decoding stream buffer
+        ///
+        /// \param[in] source  Stream buffer to read text to decode from
+        ///
+        inline basic_base64_dec_istreambuf(_In_ std::basic_streambuf<_Elem, _Traits> *source) :
+            m_source(source),
+            m_head(0),
+            m_tail(0),
+            m_finished(false)
+        {
+        }
+
+
+    protected:
+        virtual int_type underflow()
+        {
+            while (!m_finished) {
+                size_t n;
+                if (m_head >= m_tail) {
+                    m_head = 0;
+                    m_tail = (size_t)m_source->sgetn(m_in, _countof(m_in));
+                    if (!m_tail) {
+                        // End of source reached. Decode the incomplete last group.
+                        m_finished = true;
+                        n = m_dec.flush(m_out);
+                    } else
+                        n = 0;
+                }
+                if (m_head < m_tail) {
+                    bool is_last;
+                    size_t consumed;
+                    n = m_dec.decode(m_out, _countof(m_out), consumed, is_last, m_in + m_head, m_tail - m_head);
+                    m_head += consumed;
+                    if (m_head < m_tail && !m_in[m_head]) {
+                        // Skip the terminator.
+                        m_head++;
+                    }
+                }
+                if (n) {
+                    setg(m_out, m_out, m_out + n);
+                    return traits_type::to_int_type(m_out[0]);
+                }
+            }
+            return traits_type::eof();
+        }
+
+
+    protected:
+        std::basic_streambuf<_Elem, _Traits> *m_source;            ///< Source stream buffer
+        basic_base64_dec<_Alphabet> m_dec;                          ///< Decoding session
+        size_t m_head;                                              ///< Start of text pending decoding in `m_in`
+        size_t m_tail;                                              ///< End of text pending decoding in `m_in`
+        bool m_finished;                                            ///< Was the end of source reached?
+        _Elem m_in[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];        ///< Text read from source
+        char m_out[WINSTD_STACK_BUFFER_BYTES/4*3];                  ///< Decoded data
     };
 
     /// @}
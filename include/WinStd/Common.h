@@ -214,7 +214,10 @@ namespace winstd
     template<class _Ty, class _Dx> class ref_unique_ptr<_Ty[], _Dx>;
     template <class T, T INVAL> class handle;
     template <class T, T INVAL> class dplhandle;
-    template <class T> class vector_queue;
+    template <class T, bool POW2 = false, bool GROW = false, class _Ax = std::allocator<T> > class vector_queue;
+    template <class T, bool OVERWRITE = false> class spsc_queue;
+    template <class T> class mpmc_queue;
+    class guid;
     template <typename _Tn> class num_runtime_error;
     class WINSTD_API win_runtime_error;
 
@@ -307,8 +310,12 @@ namespace winstd
     /// \addtogroup WinStdMemSanitize
     /// @{
 
+    struct secure_pool_stats;
+    class secure_pool;
     template<class _Ty> class sanitizing_allocator;
     template<size_t N> class __declspec(novtable) sanitizing_blob;
+    class sanitizing_arena;
+    template<class _Ty> class sanitizing_arena_allocator;
 
 
     ///
@@ -338,6 +345,25 @@ namespace winstd
     typedef sanitizing_string sanitizing_tstring;
 #endif
 
+    ///
+    /// A variant of std::string allocated in `sanitizing_arena`
+    ///
+    typedef std::basic_string<char, std::char_traits<char>, sanitizing_arena_allocator<char> > sanitizing_arena_string;
+
+    ///
+    /// A variant of std::wstring allocated in `sanitizing_arena`
+    ///
+    typedef std::basic_string<wchar_t, std::char_traits<wchar_t>, sanitizing_arena_allocator<wchar_t> > sanitizing_arena_wstring;
+
+    ///
+    /// Multi-byte / Wide-character string allocated in `sanitizing_arena` (according to _UNICODE)
+    ///
+#ifdef _UNICODE
+    typedef sanitizing_arena_wstring sanitizing_arena_tstring;
+#else
+    typedef sanitizing_arena_string sanitizing_arena_tstring;
+#endif
+
     /// @}
 }
 
@@ -354,7 +380,7 @@ namespace winstd
 ///
 /// \returns Number of characters in result.
 ///
-#if _MSC_VER <= 1600
+#if defined(_MSC_VER) && _MSC_VER <= 1600
 inline int vsnprintf(_Out_z_cap_(capacity) char *str, _In_ size_t capacity, _In_z_ _Printf_format_string_ const char *format, _In_ va_list arg);
 #endif
 
@@ -370,14 +396,39 @@ inline int vsnprintf(_Out_z_cap_(capacity) char *str, _In_ size_t capacity, _In_
 ///
 inline int vsnprintf(_Out_z_cap_(capacity) wchar_t *str, _In_ size_t capacity, _In_z_ _Printf_format_string_ const wchar_t *format, _In_ va_list arg);
 
+///
+/// Counts characters `printf()` would produce.
+///
+/// \param[in] format  String template using `printf()` style
+/// \param[in] arg     Arguments to `format`
+///
+/// \returns Number of characters in result, not including zero terminator; or -1 on error.
+///
+inline int vscprintf(_In_z_ _Printf_format_string_ const char *format, _In_ va_list arg);
+
+///
+/// Counts characters `printf()` would produce.
+///
+/// \param[in] format  String template using `printf()` style
+/// \param[in] arg     Arguments to `format`
+///
+/// \returns Number of characters in result, not including zero terminator; or -1 on error.
+///
+inline int vscprintf(_In_z_ _Printf_format_string_ const wchar_t *format, _In_ va_list arg);
+
 ///
 /// Formats string using `printf()`.
 ///
+/// The result is formatted directly into the storage of `str` whenever possible. Reusing the same string for results of
+/// similar length does not allocate memory. When `format` has string conversions (`%s`, `%ls`, `%S`...), the arguments
+/// may point into `str` itself, e.g. `sprintf(str, "%s: %u", str.c_str(), n)`. `str` is then not written to until the
+/// result is complete.
+///
 /// \param[out] str     Formatted string
 /// \param[in ] format  String template using `printf()` style
 /// \param[in ] arg     Arguments to `format`
 ///
-/// \returns Number of characters in result.
+/// \returns Number of characters in result; or -1 on error, leaving `str` empty.
 ///
 template<class _Elem, class _Traits, class _Ax> inline int vsprintf(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ _Printf_format_string_ const _Elem *format, _In_ va_list arg);
 
@@ -410,9 +461,21 @@ template<class _Traits, class _Ax> inline DWORD FormatMessage(_In_ DWORD dwFlags
 #pragma once
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include <tchar.h>
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN10
+#include <werapi.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 
@@ -436,6 +499,75 @@ template<class _Traits, class _Ax> inline DWORD FormatMessage(_In_ DWORD dwFlags
 #define WINSTD_STACK_BUFFER_BYTES  1024
 #endif
 
+#ifndef WINSTD_CACHE_LINE_BYTES
+///
+/// Size of the CPU cache line in bytes
+///
+/// Data written by different threads is kept at least this far apart to
+/// avoid false sharing.
+///
+#define WINSTD_CACHE_LINE_BYTES  64
+#endif
+
+#ifndef WINSTD_FORMAT_TLS_BUFFERS
+///
+/// Set to 1 to format long results in thread-local scratch buffers
+///
+/// `vsprintf()` results exceeding the stack buffer and `FormatMessage()`
+/// results are formatted in a buffer kept per thread, and copied to the
+/// destination string. Reusing the destination string then formats without
+/// any heap allocation. See `winstd::get_format_buffer_stats()`.
+///
+#define WINSTD_FORMAT_TLS_BUFFERS  0
+#endif
+
+#ifndef WINSTD_FORMAT_TLS_BUFFER_MAX_BYTES
+///
+/// Maximum size of the thread-local scratch buffer in bytes
+///
+/// Longer results are formatted on heap and do not grow the buffer.
+///
+#define WINSTD_FORMAT_TLS_BUFFER_MAX_BYTES  0x10000
+#endif
+
+/// @}
+
+/// \addtogroup WinStdMemSanitize
+/// @{
+
+#ifndef WINSTD_SANITIZING_ARENA_CHUNK_BYTES
+///
+/// Default size of `winstd::sanitizing_arena` chunks in bytes
+///
+/// Chunks are locked in physical memory. The total size of locked chunks
+/// is limited by the minimum working set size of the process.
+///
+#define WINSTD_SANITIZING_ARENA_CHUNK_BYTES  0x10000
+#endif
+
+#ifndef WINSTD_SECURE_POOL
+///
+/// Set to 1 to allocate `winstd::sanitizing_allocator` and
+/// `winstd::sanitizing_blob` memory from `winstd::secure_pool`
+///
+/// Secrets are then kept in memory locked in physical memory. The setting
+/// changes layout of `winstd::sanitizing_blob` and must be the same in all
+/// modules sharing it.
+///
+#define WINSTD_SECURE_POOL  0
+#endif
+
+#ifndef WINSTD_SECURE_POOL_MAX_BYTES
+///
+/// Maximum size of memory locked by `winstd::secure_pool` in bytes
+///
+/// Allocations exceeding it are served from heap. Locking more memory than
+/// the minimum working set size of the process fails, which is handled the
+/// same way. See `SetProcessWorkingSetSize()`.
+///
+#define WINSTD_SECURE_POOL_MAX_BYTES  0x100000
+#endif
+
 /// @}
 
 
@@ -501,7 +633,7 @@ namespace winstd
         /// \sa [LocalFree function](https://msdn.microsoft.com/en-us/library/windows/desktop/aa366730.aspx)
         ///
         template<class _Other>
-        void operator()(_Other *) const
+        void operator()(_Other *_Ptr) const
         {
             LocalFree(_Ptr);
         }
@@ -551,7 +683,7 @@ namespace winstd
         ///
         /// \return Pointer to the pointer
         ///
-        inline operator typename _Ty**()
+        inline operator _Ty**()
         {
             return &m_ptr;
         }
@@ -561,7 +693,7 @@ namespace winstd
         ///
         /// \return Reference to the pointer
         ///
-        inline operator typename _Ty*&()
+        inline operator _Ty*&()
         {
             return m_ptr;
         }
@@ -616,7 +748,7 @@ namespace winstd
         ///
         /// \return Pointer to the pointer
         ///
-        inline operator typename _Ty**()
+        inline operator _Ty**()
         {
             return &m_ptr;
         }
@@ -626,7 +758,7 @@ namespace winstd
         ///
         /// \return Reference to the pointer
         ///
-        inline operator typename _Ty*&()
+        inline operator _Ty*&()
         {
             return m_ptr;
         }
@@ -927,6 +1059,14 @@ namespace winstd
     template <class T, T INVAL>
     class dplhandle : public handle<T, INVAL>
     {
+    public:
+        typedef typename handle<T, INVAL>::handle_type handle_type; ///< Datatype of the object handle this template class handles
+        using handle<T, INVAL>::invalid;
+
+    protected:
+        using handle<T, INVAL>::m_h;
+        using handle<T, INVAL>::free_internal;
+
     public:
         ///
         /// Initializes a new class instance with the object handle set to INVAL.
@@ -949,7 +1089,7 @@ namespace winstd
         ///
         /// \param[inout] h  A reference of another object
         ///
-        inline dplhandle<handle_type, INVAL>(_In_ const dplhandle<handle_type, INVAL> &h) : handle<handle_type, INVAL>(internal_duplicate(h.m_h))
+        inline dplhandle(_In_ const dplhandle<handle_type, INVAL> &h) : handle<handle_type, INVAL>(internal_duplicate(h.m_h))
         {
         }
 
@@ -958,7 +1098,7 @@ namespace winstd
         ///
         /// \param[inout] h  A rvalue reference of another object
         ///
-        inline dplhandle<handle_type, INVAL>(_Inout_ dplhandle<handle_type, INVAL> &&h) noexcept : handle<handle_type, INVAL>(std::move(h))
+        inline dplhandle(_Inout_ dplhandle<handle_type, INVAL> &&h) noexcept : handle<handle_type, INVAL>(std::move(h))
         {
         }
 
@@ -1057,15 +1197,31 @@ namespace winstd
     ///
     /// Helper class to allow limited size FIFO queues implemented as vector of elements
     ///
-    template <class T>
+    /// The storage is allocated uninitialized. Elements are constructed when pushed and destroyed when popped or
+    /// overwritten.
+    ///
+    /// \tparam T     Element type
+    /// \tparam POW2  When `true`, the capacity is rounded up to a power of two and positions wrap around by masking.
+    /// \tparam GROW  When `true`, pushing to a full queue doubles its capacity instead of overwriting an element.
+    /// \tparam _Ax   Allocator type
+    ///
+    template <class T, bool POW2, bool GROW, class _Ax>
     class vector_queue
     {
+    protected:
+        typedef std::allocator_traits<_Ax> _Altraits; ///< Allocator traits
+
     public:
         ///
         /// Type to measure element count and indices in
         ///
         typedef size_t size_type;
 
+        ///
+        /// Allocator type
+        ///
+        typedef _Ax allocator_type;
+
         ///
         /// Element type
         ///
@@ -1091,17 +1247,114 @@ namespace winstd
         ///
         typedef const T* const_pointer;
 
+        ///
+        /// Contiguous range of elements: pointer to the first element and number of elements
+        ///
+        typedef std::pair<pointer, size_type> array_range;
+
+        ///
+        /// Contiguous range of constant elements: pointer to the first element and number of elements
+        ///
+        typedef std::pair<const_pointer, size_type> const_array_range;
+
+    protected:
+        ///
+        /// Random-access iterator over queue elements
+        ///
+        /// \tparam _Ty     Element type as seen by the iterator: `T` or `const T`
+        /// \tparam _Queue  Queue type as seen by the iterator: `vector_queue` or `const vector_queue`
+        ///
+        template <class _Ty, class _Queue>
+        class basic_iterator
+        {
+            template <class, class> friend class basic_iterator;
+
+        public:
+            typedef std::random_access_iterator_tag iterator_category;  ///< Iterator category
+            typedef T value_type;                                       ///< Element type
+            typedef ptrdiff_t difference_type;                          ///< Type to measure distance between iterators in
+            typedef _Ty* pointer;                                       ///< Pointer to element
+            typedef _Ty& reference;                                     ///< Reference to element
+
+        public:
+            ///
+            /// Constructs an iterator not pointing anywhere
+            ///
+            inline basic_iterator() :
+                m_queue(NULL),
+                m_pos(0)
+            {
+            }
+
+            ///
+            /// Constructs an iterator
+            ///
+            /// \param[in] queue  Queue to iterate
+            /// \param[in] pos    The subscript or position number of the element in the queue
+            ///
+            inline basic_iterator(_In_ _Queue *queue, _In_ size_type pos) :
+                m_queue(queue),
+                m_pos(pos)
+            {
+            }
+
+            ///
+            /// Copies an iterator, or converts an iterator to a constant one
+            ///
+            /// \param[in] other  Iterator to copy from
+            ///
+            inline basic_iterator(_In_ const basic_iterator<T, vector_queue> &other) :
+                m_queue(other.m_queue),
+                m_pos(other.m_pos)
+            {
+            }
+
+            inline reference operator*() const { return m_queue->m_data[m_queue->abs(m_pos)]; }                        ///< Returns element
+            inline pointer operator->() const { return m_queue->m_data + m_queue->abs(m_pos); }                        ///< Returns pointer to element
+            inline reference operator[](_In_ difference_type n) const { return m_queue->m_data[m_queue->abs(m_pos + n)]; } ///< Returns element `n` places away
+
+            inline basic_iterator& operator++() { m_pos++; return *this; }                                             ///< Advances to the next element
+            inline basic_iterator& operator--() { m_pos--; return *this; }                                             ///< Moves back to the previous element
+            inline basic_iterator operator++(int) { basic_iterator it(*this); m_pos++; return it; }                    ///< Advances to the next element
+            inline basic_iterator operator--(int) { basic_iterator it(*this); m_pos--; return it; }                    ///< Moves back to the previous element
+            inline basic_iterator& operator+=(_In_ difference_type n) { m_pos += n; return *this; }                    ///< Advances by `n` elements
+            inline basic_iterator& operator-=(_In_ difference_type n) { m_pos -= n; return *this; }                    ///< Moves back by `n` elements
+            inline basic_iterator operator+(_In_ difference_type n) const { return basic_iterator(m_queue, m_pos + n); } ///< Returns iterator `n` elements ahead
+            inline basic_iterator operator-(_In_ difference_type n) const { return basic_iterator(m_queue, m_pos - n); } ///< Returns iterator `n` elements back
+            friend inline basic_iterator operator+(_In_ difference_type n, _In_ const basic_iterator &it) { return it + n; } ///< Returns iterator `n` elements ahead
+
+            template <class _Ty2, class _Queue2> inline difference_type operator-(_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return (difference_type)(m_pos - other.m_pos); } ///< Returns distance between iterators
+            template <class _Ty2, class _Queue2> inline bool operator==(_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos == other.m_pos; } ///< Tests if iterators point to the same element
+            template <class _Ty2, class _Queue2> inline bool operator!=(_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos != other.m_pos; } ///< Tests if iterators point to different elements
+            template <class _Ty2, class _Queue2> inline bool operator< (_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos <  other.m_pos; } ///< Tests if iterator points before the other
+            template <class _Ty2, class _Queue2> inline bool operator> (_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos >  other.m_pos; } ///< Tests if iterator points after the other
+            template <class _Ty2, class _Queue2> inline bool operator<=(_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos <= other.m_pos; } ///< Tests if iterator does not point after the other
+            template <class _Ty2, class _Queue2> inline bool operator>=(_In_ const basic_iterator<_Ty2, _Queue2> &other) const { return m_pos >= other.m_pos; } ///< Tests if iterator does not point before the other
+
+        protected:
+            _Queue *m_queue;    ///< Queue iterated
+            size_type m_pos;    ///< The subscript or position number of the element in the queue
+        };
+
+    public:
+        typedef basic_iterator<T, vector_queue> iterator;                               ///< Random-access iterator
+        typedef basic_iterator<const T, const vector_queue> const_iterator;             ///< Random-access constant iterator
+        typedef std::reverse_iterator<iterator> reverse_iterator;                       ///< Reverse random-access iterator
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;           ///< Reverse random-access constant iterator
+
     public:
         ///
         /// Construct queue of fixed size.
         ///
-        /// \param[in] size_max  Maximum number of elements. Please note this cannot be changed later.
+        /// \param[in] size_max  Maximum number of elements. It is rounded up to a power of two when `POW2` is `true`. Please note this changes only when `GROW` is `true`, or by `reserve()` and `shrink_to_fit()`.
+        /// \param[in] alloc     Allocator to allocate storage with
         ///
-        inline vector_queue(_In_ size_type size_max) :
-            m_data(new value_type[size_max]),
+        inline vector_queue(_In_ size_type size_max, _In_ const allocator_type &alloc = allocator_type()) :
+            m_alloc(alloc),
+            m_data(_Altraits::allocate(m_alloc, storage_size(size_max))),
             m_head(0),
             m_count(0),
-            m_size_max(size_max)
+            m_size_max(storage_size(size_max))
         {
         }
 
@@ -1110,16 +1363,19 @@ namespace winstd
         ///
         /// \param[in] other  Queue to copy from
         ///
-        inline vector_queue(_In_ const vector_queue<value_type> &other) :
-            m_data(new value_type[other.m_size_max]),
+        inline vector_queue(_In_ const vector_queue &other) :
+            m_alloc(_Altraits::select_on_container_copy_construction(other.m_alloc)),
+            m_data(_Altraits::allocate(m_alloc, other.m_size_max)),
             m_head(other.m_head),
-            m_count(other.m_count),
+            m_count(0),
             m_size_max(other.m_size_max)
         {
-            // Copy elements.
-            for (size_type i = 0; i < m_count; i++) {
-                size_type i_l = abs(i);
-                m_data[i_l] =  other.m_data[i_l];
+            try {
+                copy_elements(other);
+            } catch (...) {
+                clear();
+                _Altraits::deallocate(m_alloc, m_data, m_size_max);
+                throw;
             }
         }
 
@@ -1128,7 +1384,10 @@ namespace winstd
         ///
         virtual ~vector_queue()
         {
-            if (m_data) delete [] m_data;
+            if (m_data) {
+                clear();
+                _Altraits::deallocate(m_alloc, m_data, m_size_max);
+            }
         }
 
         ///
@@ -1136,7 +1395,8 @@ namespace winstd
         ///
         /// \param[inout] other  Queue to move
         ///
-        inline vector_queue(_Inout_ vector_queue<value_type> &&other) :
+        inline vector_queue(_Inout_ vector_queue &&other) :
+            m_alloc   (std::move(other.m_alloc   )),
             m_data    (std::move(other.m_data    )),
             m_head    (std::move(other.m_head    )),
             m_count   (std::move(other.m_count   )),
@@ -1154,20 +1414,20 @@ namespace winstd
         ///
         /// \param[in] other  Queue to copy from
         ///
-        inline vector_queue<value_type>& operator=(_In_ const vector_queue<value_type> &other)
+        inline vector_queue& operator=(_In_ const vector_queue &other)
         {
             if (this != std::addressof(other)) {
-                m_head     = other.m_head;
-                m_count    = other.m_count;
-                m_size_max = other.m_size_max;
-
-                // Copy elements.
-                if (m_data) delete [] m_data;
-                m_data = new value_type[other.m_size_max];
-                for (size_type i = 0; i < m_count; i++) {
-                    size_type i_l = abs(i);
-                    m_data[i_l] =  other.m_data[i_l];
+                clear();
+                if (m_size_max != other.m_size_max) {
+                    // Reallocate storage.
+                    if (m_data) _Altraits::deallocate(m_alloc, m_data, m_size_max);
+                    m_data     = NULL;
+                    m_size_max = 0;
+                    m_data     = _Altraits::allocate(m_alloc, other.m_size_max);
+                    m_size_max = other.m_size_max;
                 }
+                m_head = other.m_head;
+                copy_elements(other);
             }
 
             return *this;
@@ -1178,9 +1438,14 @@ namespace winstd
         ///
         /// \param[inout] other  Queue to move
         ///
-        inline vector_queue<value_type>& operator=(_Inout_ vector_queue<value_type> &&other)
+        inline vector_queue& operator=(_Inout_ vector_queue &&other)
         {
             if (this != std::addressof(other)) {
+                if (m_data) {
+                    clear();
+                    _Altraits::deallocate(m_alloc, m_data, m_size_max);
+                }
+                m_alloc    = std::move(other.m_alloc   );
                 m_data     = std::move(other.m_data    );
                 m_head     = std::move(other.m_head    );
                 m_count    = std::move(other.m_count   );
@@ -1205,18 +1470,46 @@ namespace winstd
         }
 
         ///
-        /// Returns the number of elements that the queue can contain before overwriting head ones.
+        /// Returns the number of elements that the queue can contain before overwriting head ones or growing.
         ///
         inline size_type capacity() const
         {
             return m_size_max;
         }
 
+        ///
+        /// Increases the capacity of the queue.
+        ///
+        /// \note Elements are moved to the beginning of the new storage. Iterators, references and absolute positions are invalidated.
+        ///
+        /// \param[in] size_max  Minimum number of elements the queue should contain. Smaller than the current capacity has no effect.
+        ///
+        inline void reserve(_In_ size_type size_max)
+        {
+            if (size_max > m_size_max)
+                reallocate(storage_size(size_max));
+        }
+
+        ///
+        /// Reduces the capacity of the queue to the number of elements, but not below one element.
+        ///
+        /// \note Elements are moved to the beginning of the new storage. Iterators, references and absolute positions are invalidated.
+        ///
+        inline void shrink_to_fit()
+        {
+            // An empty queue keeps room for one element, as a queue of no capacity could never take any.
+            size_type size = storage_size(std::max<size_type>(m_count, 1));
+            if (size != m_size_max)
+                reallocate(size);
+        }
+
         ///
         /// Erases the elements of the queue.
         ///
         inline void clear()
         {
+            for (size_type i = 0; i < m_count; i++)
+                _Altraits::destroy(m_alloc, m_data + abs(i));
             m_count = 0;
         }
 
@@ -1272,16 +1565,38 @@ namespace winstd
             return m_data[abs(pos)];
         }
 
+        ///
+        /// Returns a reference to the element at a specified location in the queue without checking bounds.
+        ///
+        /// \param[in] pos  The subscript or position number of the element to reference in the queue. Must be less than `size()`.
+        ///
+        inline reference at_unchecked(_In_ size_type pos)
+        {
+            assert(pos < m_count);
+            return m_data[abs(pos)];
+        }
+
+        ///
+        /// Returns a constant reference to the element at a specified location in the queue without checking bounds.
+        ///
+        /// \param[in] pos  The subscript or position number of the element to reference in the queue. Must be less than `size()`.
+        ///
+        inline const_reference at_unchecked(_In_ size_type pos) const
+        {
+            assert(pos < m_count);
+            return m_data[abs(pos)];
+        }
+
         ///
         /// Returns a reference to the element at the absolute location in the queue.
         ///
         /// \note Absolute means "measured from the beginning of the storage".
         ///
-        /// \param[in] pos  The absolute subscript or position number of the element to reference in the queue.
+        /// \param[in] pos  The absolute subscript or position number of the element to reference in the queue. The element must exist.
         ///
         inline reference at_abs(_In_ size_type pos)
         {
-            if (pos >= m_size_max) throw std::invalid_argument("Invalid subscript");
+            if (!is_abs_valid(pos)) throw std::invalid_argument("Invalid subscript");
             return m_data[pos];
         }
 
@@ -1290,16 +1605,16 @@ namespace winstd
         ///
         /// \note Absolute means "measured from the beginning of the storage".
         ///
-        /// \param[in] pos  The absolute subscript or position number of the element to reference in the queue.
+        /// \param[in] pos  The absolute subscript or position number of the element to reference in the queue. The element must exist.
         ///
         inline const_reference at_abs(_In_ size_type pos) const
         {
-            if (pos >= m_size_max) throw std::invalid_argument("Invalid subscript");
+            if (!is_abs_valid(pos)) throw std::invalid_argument("Invalid subscript");
             return m_data[pos];
         }
 
         ///
-        /// Copies an existing element to the end of the queue, overriding the first one when queue is out of space.
+        /// Copies an existing element to the end of the queue, overriding the first one or growing the queue when queue is out of space.
         ///
         /// \param[in] v  Element to copy to the end of the queue.
         ///
@@ -1307,37 +1622,45 @@ namespace winstd
         ///
         inline size_type push_back(_In_ const value_type &v)
         {
-            if (m_count < m_size_max) {
-                size_type pos = abs(m_count);
-                m_data[pos] = v;
-                m_count++;
-                return pos;
-            } else {
-                size_type pos = m_head;
-                m_data[pos] = v;
-                m_head = abs(1);
-                return pos;
-            }
+            return emplace_back(v);
         }
 
         ///
-        /// Moves the element to the end of the queue, overriding the first one when queue is out of space.
+        /// Moves the element to the end of the queue, overriding the first one or growing the queue when queue is out of space.
         ///
         /// \param[in] v  Element to move to the end of the queue.
         ///
         /// \returns The absolute subscript or position number the element was moved to.
         ///
         inline size_type push_back(_Inout_ value_type&&v)
+        {
+            return emplace_back(std::move(v));
+        }
+
+        ///
+        /// Constructs an element in place at the end of the queue, overriding the first one or growing the queue when queue is out of space.
+        ///
+        /// \param[in] args  Arguments to construct the element with
+        ///
+        /// \returns The absolute subscript or position number the element was constructed at.
+        ///
+        template <class... _Args>
+        inline size_type emplace_back(_Args&&... args)
         {
             if (m_count < m_size_max) {
                 size_type pos = abs(m_count);
-                m_data[pos] = std::move(v);
+                _Altraits::construct(m_alloc, m_data + pos, std::forward<_Args>(args)...);
                 m_count++;
                 return pos;
+            } else if (GROW) {
+                return grow_emplace(false, std::forward<_Args>(args)...);
             } else {
-                size_type pos = m_head;
-                m_data[pos] = std::move(v);
-                m_head = abs(1);
+                // Arguments may refer to the element being discarded.
+                value_type v(std::forward<_Args>(args)...);
+                pop_front();
+                size_type pos = abs(m_count);
+                _Altraits::construct(m_alloc, m_data + pos, std::move(v));
+                m_count++;
                 return pos;
             }
         }
@@ -1348,11 +1671,12 @@ namespace winstd
         inline void pop_back()
         {
             if (!m_count) throw std::invalid_argument("Empty storage");
+            _Altraits::destroy(m_alloc, m_data + abs(m_count - 1));
             m_count--;
         }
 
         ///
-        /// Copies an existing element to the head of the queue, overriding the last one when queue is out of space and moving all others one place right.
+        /// Copies an existing element to the head of the queue, overriding the last one or growing the queue when queue is out of space and moving all others one place right.
         ///
         /// \param[in] v  Element to copy to the head of the queue.
         ///
@@ -1360,15 +1684,11 @@ namespace winstd
         ///
         inline size_type push_front(_In_ const value_type &v)
         {
-            m_head = abs(-1);
-            if (m_count < m_size_max)
-                m_count++;
-            m_data[m_head] = v;
-            return m_head;
+            return emplace_front(v);
         }
 
         ///
-        /// Moves the element to the head of the queue, overriding the last one when queue is out of space and moving all others one place right.
+        /// Moves the element to the head of the queue, overriding the last one or growing the queue when queue is out of space and moving all others one place right.
         ///
         /// \param[in] v  Element to move to the head of the queue.
         ///
@@ -1376,11 +1696,37 @@ namespace winstd
         ///
         inline size_type push_front(_Inout_ value_type&&v)
         {
-            m_head = abs(-1);
-            if (m_count < m_size_max)
+            return emplace_front(std::move(v));
+        }
+
+        ///
+        /// Constructs an element in place at the head of the queue, overriding the last one or growing the queue when queue is out of space and moving all others one place right.
+        ///
+        /// \param[in] args  Arguments to construct the element with
+        ///
+        /// \returns The absolute subscript or position number the element was constructed at.
+        ///
+        template <class... _Args>
+        inline size_type emplace_front(_Args&&... args)
+        {
+            if (m_count < m_size_max) {
+                size_type pos = (m_head ? m_head : m_size_max) - 1;
+                _Altraits::construct(m_alloc, m_data + pos, std::forward<_Args>(args)...);
+                m_head = pos;
                 m_count++;
-            m_data[m_head] = std::move(v);
-            return m_head;
+                return pos;
+            } else if (GROW) {
+                return grow_emplace(true, std::forward<_Args>(args)...);
+            } else {
+                // Arguments may refer to the element being discarded.
+                value_type v(std::forward<_Args>(args)...);
+                pop_back();
+                size_type pos = (m_head ? m_head : m_size_max) - 1;
+                _Altraits::construct(m_alloc, m_data + pos, std::move(v));
+                m_head = pos;
+                m_count++;
+                return pos;
+            }
         }
 
         ///
@@ -1389,6 +1735,7 @@ namespace winstd
         inline void pop_front()
         {
             if (!m_count) throw std::invalid_argument("Empty storage");
+            _Altraits::destroy(m_alloc, m_data + m_head);
             m_head = abs(1);
             m_count--;
         }
@@ -1446,528 +1793,2800 @@ namespace winstd
 
         ///
         /// Returns absolute subscript or position number of the given element in the queue.
+        ///
+        /// \param[in] pos  The subscript or position number of the element in the queue. Positions beyond `capacity()` wrap around.
+        ///
         inline size_type abs(_In_ size_type pos) const
         {
-            return (m_head + pos) % m_size_max;
+            size_type i = m_head + pos;
+            if (POW2)
+                return i & (m_size_max - 1);
+            if (i < m_size_max)
+                return i;
+
+            // Positions up to capacity() need a single wrap. Divide only beyond.
+            i -= m_size_max;
+            return i < m_size_max ? i : i % m_size_max;
         }
 
-    protected:
-        value_type *m_data;     ///< Underlying data container
-        size_type m_head;       ///< Index of the first element
-        size_type m_count;      ///< Number of elements
-        size_type m_size_max;   ///< Maximum size
-    };
-
-    /// @}
-
-    /// \addtogroup WinStdExceptions
-    /// @{
-
-    ///
-    /// Numerical runtime error
-    ///
-    template <typename _Tn>
-    class num_runtime_error : public std::runtime_error
-    {
-    public:
-        typedef _Tn error_type; ///< Error number type
-
-    public:
-        ///
-        /// Constructs an exception
         ///
-        /// \param[in] num  Numeric error code
-        /// \param[in] msg  Error message
+        /// Returns an iterator to the head element of the queue.
         ///
-        inline num_runtime_error(_In_ error_type num, _In_ const std::string& msg) :
-            m_num(num),
-            runtime_error(msg)
+        inline iterator begin()
         {
+            return iterator(this, 0);
         }
 
-
-        ///
-        /// Constructs an exception
         ///
-        /// \param[in] num  Numeric error code
-        /// \param[in] msg  Error message
+        /// Returns a constant iterator to the head element of the queue.
         ///
-        inline num_runtime_error(_In_ error_type num, _In_z_ const char *msg) :
-            m_num(num),
-            runtime_error(msg)
+        inline const_iterator begin() const
         {
+            return const_iterator(this, 0);
         }
 
-
-        ///
-        /// Copies an exception
         ///
-        /// \param[in] other  Exception to copy from
+        /// Returns a constant iterator to the head element of the queue.
         ///
-        inline num_runtime_error(const num_runtime_error<_Tn> &other) :
-            m_num(other.m_num),
-            runtime_error(other)
+        inline const_iterator cbegin() const
         {
+            return const_iterator(this, 0);
         }
 
-
-        ///
-        /// Copies an exception
         ///
-        /// \param[in] other  Exception to copy from
+        /// Returns an iterator past the last element of the queue.
         ///
-        inline num_runtime_error& operator=(const num_runtime_error<_Tn> &other)
+        inline iterator end()
         {
-            if (this != addressof(other)) {
-                *(runtime_error*)this = other;
-                m_num                 = other.m_num;
-            }
-
-            return *this;
+            return iterator(this, m_count);
         }
 
-
         ///
-        /// Returns the Windows error number
+        /// Returns a constant iterator past the last element of the queue.
         ///
-        inline error_type number() const
+        inline const_iterator end() const
         {
-            return m_num;
+            return const_iterator(this, m_count);
         }
 
-    protected:
-        error_type m_num;  ///< Numeric error code
-    };
-
-
-    ///
-    /// Windows runtime error
-    ///
-    class WINSTD_API win_runtime_error : public num_runtime_error<DWORD>
-    {
-    public:
-        ///
-        /// Constructs an exception
         ///
-        /// \param[in] num Windows error code
-        /// \param[in] msg Error message
+        /// Returns a constant iterator past the last element of the queue.
         ///
-        inline win_runtime_error(_In_ error_type num, _In_ const std::string& msg) : num_runtime_error<DWORD>(num, msg)
+        inline const_iterator cend() const
         {
+            return const_iterator(this, m_count);
         }
 
-
-        ///
-        /// Constructs an exception
         ///
-        /// \param[in] num  Windows error code
-        /// \param[in] msg  Error message
+        /// Returns a reverse iterator to the last element of the queue.
         ///
-        inline win_runtime_error(_In_ error_type num, _In_z_ const char *msg) : num_runtime_error<DWORD>(num, msg)
+        inline reverse_iterator rbegin()
         {
+            return reverse_iterator(end());
         }
 
-
-        ///
-        /// Constructs an exception using `GetLastError()`
         ///
-        /// \param[in] msg  Error message
+        /// Returns a constant reverse iterator to the last element of the queue.
         ///
-        inline win_runtime_error(_In_ const std::string& msg) : num_runtime_error<DWORD>(GetLastError(), msg)
+        inline const_reverse_iterator rbegin() const
         {
+            return const_reverse_iterator(end());
         }
 
-
         ///
-        /// Constructs an exception using `GetLastError()`
-        ///
-        /// \param[in] msg  Error message
+        /// Returns a reverse iterator before the head element of the queue.
         ///
-        inline win_runtime_error(_In_z_ const char *msg) : num_runtime_error<DWORD>(GetLastError(), msg)
+        inline reverse_iterator rend()
         {
+            return reverse_iterator(begin());
         }
 
-
-        ///
-        /// Copies an exception
         ///
-        /// \param[in] other  Exception to copy from
+        /// Returns a constant reverse iterator before the head element of the queue.
         ///
-        inline win_runtime_error(const win_runtime_error &other) : num_runtime_error<DWORD>(other)
+        inline const_reverse_iterator rend() const
         {
+            return const_reverse_iterator(begin());
         }
 
-
         ///
-        /// Returns a user-readable Windows error message
+        /// Returns the first contiguous range of elements: from the head element till the end of the storage or the last element.
         ///
-        /// \sa [FormatMessage function](https://docs.microsoft.com/en-us/windows/desktop/api/winbase/nf-winbase-formatmessage)
+        /// \note Elements of `array_one()` followed by elements of `array_two()` are all the elements of the queue in order.
+        ///
+        inline array_range array_one()
+        {
+            return array_range(m_data + m_head, std::min<size_type>(m_count, m_size_max - m_head));
+        }
+
+        ///
+        /// Returns the first contiguous range of constant elements: from the head element till the end of the storage or the last element.
+        ///
+        /// \note Elements of `array_one()` followed by elements of `array_two()` are all the elements of the queue in order.
+        ///
+        inline const_array_range array_one() const
+        {
+            return const_array_range(m_data + m_head, std::min<size_type>(m_count, m_size_max - m_head));
+        }
+
+        ///
+        /// Returns the second contiguous range of elements: the wrapped-around elements from the beginning of the storage.
+        ///
+        /// \note The range is empty when elements do not wrap around the end of the storage.
+        ///
+        inline array_range array_two()
+        {
+            return array_range(m_data, m_count - std::min<size_type>(m_count, m_size_max - m_head));
+        }
+
+        ///
+        /// Returns the second contiguous range of constant elements: the wrapped-around elements from the beginning of the storage.
+        ///
+        /// \note The range is empty when elements do not wrap around the end of the storage.
+        ///
+        inline const_array_range array_two() const
+        {
+            return const_array_range(m_data, m_count - std::min<size_type>(m_count, m_size_max - m_head));
+        }
+
+        ///
+        /// Returns a copy of the allocator.
+        ///
+        inline allocator_type get_allocator() const
+        {
+            return m_alloc;
+        }
+
+    protected:
+        ///
+        /// Tests if the absolute subscript or position number refers to an existing element
+        ///
+        inline bool is_abs_valid(_In_ size_type pos) const
+        {
+            return pos < m_size_max && (pos >= m_head ? pos - m_head : pos + m_size_max - m_head) < m_count;
+        }
+
+        ///
+        /// Copy-constructs elements of another queue of the same capacity at the same places
+        ///
+        /// \note `m_head` must be set to match `other` and the queue must be empty.
+        ///
+        inline void copy_elements(_In_ const vector_queue &other)
+        {
+            for (; m_count < other.m_count; m_count++) {
+                size_type i_l = abs(m_count);
+                _Altraits::construct(m_alloc, m_data + i_l, other.m_data[i_l]);
+            }
+        }
+
+        ///
+        /// Moves elements to the beginning of a new storage and releases the old one
+        ///
+        /// \note On exception, the queue is left intact.
+        ///
+        /// \param[in] size  New storage size. Must not be less than the number of elements.
+        ///
+        inline void reallocate(_In_ size_type size)
+        {
+            pointer data = _Altraits::allocate(m_alloc, size);
+            try {
+                relocate(data, size);
+            } catch (...) {
+                _Altraits::deallocate(m_alloc, data, size);
+                throw;
+            }
+        }
+
+        ///
+        /// Doubles the capacity of a full queue and constructs an element in place at its end or head
+        ///
+        /// \note The element is constructed before the existing ones are moved, as arguments may refer to them. On exception, the queue is left intact.
+        ///
+        /// \param[in] front  `true` to construct the element at the head; `false` to construct it at the end
+        /// \param[in] args   Arguments to construct the element with
+        ///
+        /// \returns The absolute subscript or position number the element was constructed at.
+        ///
+        template <class... _Args>
+        inline size_type grow_emplace(_In_ bool front, _Args&&... args)
+        {
+            size_type size = storage_size(m_size_max ? m_size_max * 2 : 1);
+            pointer data = _Altraits::allocate(m_alloc, size);
+            size_type pos = front ? size - 1 : m_count;
+            try {
+                _Altraits::construct(m_alloc, data + pos, std::forward<_Args>(args)...);
+            } catch (...) {
+                _Altraits::deallocate(m_alloc, data, size);
+                throw;
+            }
+            try {
+                relocate(data, size);
+            } catch (...) {
+                _Altraits::destroy(m_alloc, data + pos);
+                _Altraits::deallocate(m_alloc, data, size);
+                throw;
+            }
+            if (front)
+                m_head = pos;
+            m_count++;
+            return pos;
+        }
+
+        ///
+        /// Moves elements to the beginning of the given storage, and makes it the queue storage
+        ///
+        /// \note On exception, the queue is left intact and the elements moved so far are destroyed.
+        ///
+        /// \param[in] data  New storage
+        /// \param[in] size  Size of `data`. Must not be less than the number of elements.
+        ///
+        inline void relocate(_In_ pointer data, _In_ size_type size)
+        {
+            // Move in up to two spans: from the head till the end of the storage, and from the beginning of it.
+            size_type i = 0, n_first = std::min<size_type>(m_count, m_size_max - m_head);
+            try {
+                for (pointer src = m_data + m_head; i < n_first; i++, src++)
+                    _Altraits::construct(m_alloc, data + i, std::move_if_noexcept(*src));
+                for (pointer src = m_data; i < m_count; i++, src++)
+                    _Altraits::construct(m_alloc, data + i, std::move_if_noexcept(*src));
+            } catch (...) {
+                while (i)
+                    _Altraits::destroy(m_alloc, data + --i);
+                throw;
+            }
+            for (i = 0; i < m_count; i++)
+                _Altraits::destroy(m_alloc, m_data + abs(i));
+            if (m_data) _Altraits::deallocate(m_alloc, m_data, m_size_max);
+            m_data     = data;
+            m_size_max = size;
+            m_head     = 0;
+        }
+
+        ///
+        /// Returns storage size for the given maximum number of elements
+        ///
+        static inline size_type storage_size(_In_ size_type size_max)
+        {
+            if (!POW2)
+                return size_max;
+            size_type size = 1;
+            while (size < size_max)
+                size <<= 1;
+            return size;
+        }
+
+    protected:
+        allocator_type m_alloc; ///< Allocator
+        value_type *m_data;     ///< Underlying data container
+        size_type m_head;       ///< Index of the first element
+        size_type m_count;      ///< Number of elements
+        size_type m_size_max;   ///< Maximum size
+    };
+
+
+    ///
+    /// Lock-free single-producer/single-consumer FIFO queue of limited size
+    ///
+    /// One thread may push elements while another thread pops them without any locking. The head and tail indices are
+    /// kept on separate cache lines and published with acquire/release semantics.
+    ///
+    /// \tparam T          Element type
+    /// \tparam OVERWRITE  When `true`, pushing to a full queue discards the head element like `vector_queue` does.
+    ///                    Otherwise, pushing to a full queue fails. Overwriting requires `T` to be trivially copyable,
+    ///                    as the consumer may copy an element being overwritten; such copy is detected and discarded.
+    ///                    To keep this free of data races, places of overwriting queues are accessed word by word using
+    ///                    relaxed atomic operations.
+    ///
+    template <class T, bool OVERWRITE>
+    class spsc_queue
+    {
+        WINSTD_NONCOPYABLE(spsc_queue)
+        WINSTD_NONMOVABLE(spsc_queue)
+
+        static_assert(!OVERWRITE || std::is_trivially_copyable<T>::value, "Overwriting queue requires trivially copyable elements");
+
+    public:
+        ///
+        /// Type to measure element count and indices in
+        ///
+        typedef size_t size_type;
+
+        ///
+        /// Element type
+        ///
+        typedef T value_type;
+
+        ///
+        /// Reference to element type
+        ///
+        typedef T& reference;
+
+        ///
+        /// Constant reference to element type
+        ///
+        typedef const T& const_reference;
+
+        ///
+        /// Pointer to element
+        ///
+        typedef T* pointer;
+
+        ///
+        /// Constant pointer to element
+        ///
+        typedef const T* const_pointer;
+
+    public:
+        ///
+        /// Construct queue of fixed size.
+        ///
+        /// \param[in] size_max  Maximum number of elements. Please note this cannot be changed later.
+        ///
+        inline spsc_queue(_In_ size_type size_max) :
+            m_size_max(size_max),
+            m_head(0),
+            m_tail_cached(0),
+            m_tail(0),
+            m_head_cached(0)
+        {
+            // Round storage size up to a power of two to map indices to places by masking.
+            size_type size = 1;
+            while (size < size_max)
+                size <<= 1;
+            m_data  = OVERWRITE ? NULL : new value_type[size];
+            m_words = OVERWRITE ? new std::atomic<size_t>[size * words]() : NULL;
+            m_mask = size - 1;
+        }
+
+        ///
+        /// Destroys the queue
+        ///
+        virtual ~spsc_queue()
+        {
+            delete [] m_data;
+            delete [] m_words;
+        }
+
+        ///
+        /// Returns the number of elements in the queue.
+        ///
+        /// \note The value is only a snapshot when the other thread is pushing or popping concurrently.
+        ///
+        inline size_type size() const
+        {
+            size_type head = m_head.load(std::memory_order_acquire);
+            return std::min<size_type>(m_tail.load(std::memory_order_acquire) - head, m_size_max);
+        }
+
+        ///
+        /// Returns the number of elements that the queue can contain.
+        ///
+        inline size_type capacity() const
+        {
+            return m_size_max;
+        }
+
+        ///
+        /// Tests if the queue is empty.
+        ///
+        /// \note The value is only a snapshot when the other thread is pushing or popping concurrently.
+        ///
+        inline bool empty() const
+        {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+        }
+
+        ///
+        /// Copies an existing element to the end of the queue. Call from the producer thread only.
+        ///
+        /// \param[in] v  Element to copy to the end of the queue.
+        ///
+        /// \returns
+        /// - `true` when the element was queued;
+        /// - `false` when the queue is full. Overwriting queues are never full.
+        ///
+        inline bool push(_In_ const value_type &v)
+        {
+            size_type tail = m_tail.load(std::memory_order_relaxed);
+            if (!reserve(tail))
+                return false;
+            put(tail & m_mask, v, overwrite_t());
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        ///
+        /// Moves the element to the end of the queue. Call from the producer thread only.
+        ///
+        /// \param[in] v  Element to move to the end of the queue.
+        ///
+        /// \returns
+        /// - `true` when the element was queued;
+        /// - `false` when the queue is full. Overwriting queues are never full.
+        ///
+        inline bool push(_Inout_ value_type &&v)
+        {
+            size_type tail = m_tail.load(std::memory_order_relaxed);
+            if (!reserve(tail))
+                return false;
+            put(tail & m_mask, std::move(v), overwrite_t());
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        ///
+        /// Copies existing elements to the end of the queue. Call from the producer thread only.
+        ///
+        /// The elements are published to the consumer at once.
+        ///
+        /// \param[in] data   Elements to copy to the end of the queue
+        /// \param[in] count  Number of elements in `data`
+        ///
+        /// \returns Number of elements queued. Less than `count` when the queue is full. Overwriting queues always queue
+        /// all elements, discarding as many head elements as needed at once. Of more than `capacity()` elements, only the
+        /// last `capacity()` ones are kept.
+        ///
+        inline size_type push_n(_In_count_(count) const value_type *data, _In_ size_type count)
+        {
+            size_type tail = m_tail.load(std::memory_order_relaxed), free = m_size_max - (tail - m_head_cached);
+            if (free < count)
+                free = m_size_max - (tail - (m_head_cached = m_head.load(std::memory_order_acquire)));
+            size_type n = std::min<size_type>(count, free);
+
+            if (OVERWRITE && n < count) {
+                // Elements beyond the capacity would be discarded by the following ones right away.
+                n = std::min<size_type>(count, m_size_max);
+                data += count - n;
+
+                // Discard head elements to make room for all. Should the consumer pop some first, less need discarding.
+                for (size_type head = m_head_cached; tail + n - head > m_size_max;) {
+                    if (m_head.compare_exchange_weak(head, tail + n - m_size_max, std::memory_order_acq_rel))
+                        break;
+                }
+                m_head_cached = m_head.load(std::memory_order_acquire);
+            }
+
+            if (OVERWRITE) {
+                for (size_type i = 0; i < n; i++)
+                    put((tail + i) & m_mask, data[i], overwrite_t());
+            } else {
+                // Copy in up to two spans: till the end of the storage, and from the beginning of it.
+                size_type pos = tail & m_mask, n_first = std::min<size_type>(n, m_mask + 1 - pos);
+                std::copy(data, data + n_first, m_data + pos);
+                std::copy(data + n_first, data + n, m_data);
+            }
+            m_tail.store(tail + n, std::memory_order_release);
+            return OVERWRITE ? count : n;
+        }
+
+        ///
+        /// Moves the head element of the queue out. Call from the consumer thread only.
+        ///
+        /// \param[out] v  Element popped
+        ///
+        /// \returns
+        /// - `true` when an element was popped;
+        /// - `false` when the queue is empty.
+        ///
+        inline bool pop(_Out_ value_type &v)
+        {
+            return pop_n(&v, 1) != 0;
+        }
+
+        ///
+        /// Moves head elements of the queue out. Call from the consumer thread only.
+        ///
+        /// The elements are released to the producer at once.
+        ///
+        /// \param[out] data   Elements popped
+        /// \param[in ] count  Maximum number of elements to pop
+        ///
+        /// \returns Number of elements popped
+        ///
+        inline size_type pop_n(_Out_writes_to_(count, return) value_type *data, _In_ size_type count)
+        {
+            for (;;) {
+                size_type head = m_head.load(OVERWRITE ? std::memory_order_acquire : std::memory_order_relaxed), available = m_tail_cached - head;
+                if (available < count || available > m_size_max) {
+                    available = (m_tail_cached = m_tail.load(std::memory_order_acquire)) - head;
+                    if (available > m_size_max) {
+                        // The producer discarded elements since we read the head.
+                        continue;
+                    }
+                }
+                size_type n = std::min<size_type>(count, available);
+                if (!n)
+                    return 0;
+
+                if (!OVERWRITE) {
+                    // Move in up to two spans: till the end of the storage, and from the beginning of it.
+                    size_type pos = head & m_mask, n_first = std::min<size_type>(n, m_mask + 1 - pos);
+                    std::move(m_data + pos, m_data + pos + n_first, data);
+                    std::move(m_data, m_data + n - n_first, data + n_first);
+                    m_head.store(head + n, std::memory_order_release);
+                    return n;
+                }
+
+                // The producer might be discarding the elements meanwhile. Copy them, but keep only when the head did not
+                // move. The producer overwrites a place only after moving the head past it.
+                for (size_type i = 0; i < n; i++)
+                    get((head + i) & m_mask, data[i], overwrite_t());
+                if (m_head.compare_exchange_strong(head, head + n, std::memory_order_acq_rel))
+                    return n;
+            }
+        }
+
+    protected:
+        /// \cond internal
+        typedef std::integral_constant<bool, OVERWRITE> overwrite_t;
+        static const size_t words = (sizeof(value_type) + sizeof(size_t) - 1) / sizeof(size_t); ///< Number of words per place of overwriting queue
+
+        ///
+        /// Writes element to place `pos`
+        ///
+        inline void put(_In_ size_type pos, _In_ const value_type &v, _In_ std::false_type) { m_data[pos] = v; }
+        inline void put(_In_ size_type pos, _Inout_ value_type &&v, _In_ std::false_type)  { m_data[pos] = std::move(v); }
+
+        ///
+        /// Reads element from place `pos`
+        ///
+        inline void get(_In_ size_type pos, _Out_ value_type &v, _In_ std::false_type) const { v = m_data[pos]; }
+
+        ///
+        /// Writes element to place `pos` of overwriting queue, while the consumer might be reading it
+        ///
+        inline void put(_In_ size_type pos, _In_ const value_type &v, _In_ std::true_type)
+        {
+            size_t w[words] = {};
+            memcpy(w, &v, sizeof(value_type));
+            for (size_t i = 0; i < words; i++)
+                m_words[pos * words + i].store(w[i], std::memory_order_relaxed);
+        }
+
+        ///
+        /// Reads element from place `pos` of overwriting queue, while the producer might be overwriting it
+        ///
+        /// The result is torn then. Check the head did not move past `pos` before using it.
+        ///
+        inline void get(_In_ size_type pos, _Out_ value_type &v, _In_ std::true_type) const
+        {
+            size_t w[words];
+            for (size_t i = 0; i < words; i++)
+                w[i] = m_words[pos * words + i].load(std::memory_order_relaxed);
+            memcpy(&v, w, sizeof(value_type));
+        }
+        /// \endcond
+
+        ///
+        /// Ensures there is room for an element at `tail`, discarding the head element of overwriting queues when full
+        ///
+        /// \returns `true` when there is room
+        ///
+        inline bool reserve(_In_ size_type tail)
+        {
+            if (tail - m_head_cached < m_size_max)
+                return true;
+            size_type head = m_head_cached = m_head.load(std::memory_order_acquire);
+            if (tail - head < m_size_max)
+                return true;
+            if (!OVERWRITE || !m_size_max)
+                return false;
+
+            // Discard the head element. Should the consumer pop it first, there is room now anyway.
+            m_head.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel);
+            m_head_cached = m_head.load(std::memory_order_acquire);
+            return true;
+        }
+
+    protected:
+        value_type *m_data;                                             ///< Underlying data container. Non-overwriting queues only.
+        std::atomic<size_t> *m_words;                                   ///< Underlying data container, `words` per place. Overwriting queues only.
+        size_type m_mask;                                               ///< Index mask: number of places minus one
+        size_type m_size_max;                                           ///< Maximum size
+        char m_padding0[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+
+        std::atomic<size_type> m_head;                                  ///< Number of elements ever popped or discarded
+        size_type m_tail_cached;                                        ///< Last known `m_tail`. Consumer only.
+        char m_padding1[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+
+        std::atomic<size_type> m_tail;                                  ///< Number of elements ever pushed. Written by producer only.
+        size_type m_head_cached;                                        ///< Last known `m_head`. Producer only.
+        char m_padding2[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+    };
+
+
+    ///
+    /// Lock-free multi-producer/multi-consumer FIFO queue of limited size
+    ///
+    /// Any number of threads may push and pop elements concurrently. Each place in the storage carries a sequence number
+    /// telling whether it is ready to be written or read in the current round, so producers and consumers only contend
+    /// on their own index (D. Vyukov's bounded queue).
+    ///
+    /// A claimed place must be published, or the queue stalls. Elements are therefore copied before a place is claimed,
+    /// and must be move-assignable without throwing.
+    ///
+    /// \tparam T  Element type
+    ///
+    template <class T>
+    class mpmc_queue
+    {
+        WINSTD_NONCOPYABLE(mpmc_queue)
+        WINSTD_NONMOVABLE(mpmc_queue)
+        static_assert(std::is_nothrow_move_assignable<T>::value, "Elements must be nothrow move-assignable");
+
+    public:
+        ///
+        /// Type to measure element count and indices in
+        ///
+        typedef size_t size_type;
+
+        ///
+        /// Element type
+        ///
+        typedef T value_type;
+
+        ///
+        /// Reference to element type
+        ///
+        typedef T& reference;
+
+        ///
+        /// Constant reference to element type
+        ///
+        typedef const T& const_reference;
+
+        ///
+        /// Pointer to element
+        ///
+        typedef T* pointer;
+
+        ///
+        /// Constant pointer to element
+        ///
+        typedef const T* const_pointer;
+
+    public:
+        ///
+        /// Construct queue of fixed size.
+        ///
+        /// \param[in] size_max  Minimum number of elements. It is rounded up to a power of two. Please note this cannot be changed later.
+        ///
+        inline mpmc_queue(_In_ size_type size_max) :
+            m_head(0),
+            m_tail(0)
+        {
+            size_type size = 1;
+            while (size < size_max)
+                size <<= 1;
+            m_data = new cell[size];
+            m_mask = size - 1;
+
+            // Mark all places ready to be written in the first round.
+            for (size_type i = 0; i < size; i++)
+                m_data[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ///
+        /// Destroys the queue
+        ///
+        virtual ~mpmc_queue()
+        {
+            delete [] m_data;
+        }
+
+        ///
+        /// Returns the number of elements in the queue.
+        ///
+        /// \note The value is only a snapshot when other threads are pushing or popping concurrently.
+        ///
+        inline size_type size() const
+        {
+            size_type head = m_head.load(std::memory_order_acquire), tail = m_tail.load(std::memory_order_acquire);
+            return tail > head ? std::min<size_type>(tail - head, m_mask + 1) : 0;
+        }
+
+        ///
+        /// Returns the number of elements that the queue can contain.
+        ///
+        inline size_type capacity() const
+        {
+            return m_mask + 1;
+        }
+
+        ///
+        /// Tests if the queue is empty.
+        ///
+        /// \note The value is only a snapshot when other threads are pushing or popping concurrently.
+        ///
+        inline bool empty() const
+        {
+            return size() == 0;
+        }
+
+        ///
+        /// Copies an existing element to the end of the queue.
+        ///
+        /// \param[in] v  Element to copy to the end of the queue.
+        ///
+        /// \returns
+        /// - `true` when the element was queued;
+        /// - `false` when the queue is full.
+        ///
+        inline bool try_push(_In_ const value_type &v)
+        {
+            // Copy may throw. Make it before claiming a place.
+            value_type copy(v);
+            return try_push(std::move(copy));
+        }
+
+        ///
+        /// Moves the element to the end of the queue.
+        ///
+        /// \param[in] v  Element to move to the end of the queue.
+        ///
+        /// \returns
+        /// - `true` when the element was queued;
+        /// - `false` when the queue is full.
+        ///
+        inline bool try_push(_Inout_ value_type &&v)
+        {
+            cell *c = reserve_push();
+            if (!c)
+                return false;
+            c->data = std::move(v);
+            c->sequence.store(c->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            return true;
+        }
+
+        ///
+        /// Copies an existing element to the end of the queue, waiting for room when the queue is full.
+        ///
+        /// \param[in] v  Element to copy to the end of the queue.
+        ///
+        inline void push(_In_ const value_type &v)
+        {
+            value_type copy(v);
+            for (size_type i = 0; !try_push(std::move(copy)); i++)
+                backoff(i);
+        }
+
+        ///
+        /// Moves the element to the end of the queue, waiting for room when the queue is full.
+        ///
+        /// \param[in] v  Element to move to the end of the queue.
+        ///
+        inline void push(_Inout_ value_type &&v)
+        {
+            for (size_type i = 0; !try_push(std::move(v)); i++)
+                backoff(i);
+        }
+
+        ///
+        /// Moves the head element of the queue out.
+        ///
+        /// \param[out] v  Element popped
+        ///
+        /// \returns
+        /// - `true` when an element was popped;
+        /// - `false` when the queue is empty.
+        ///
+        inline bool try_pop(_Out_ value_type &v)
+        {
+            size_type head = m_head.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = m_data + (head & m_mask);
+                size_type seq = c->sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = (ptrdiff_t)(seq - (head + 1));
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                        v = std::move(c->data);
+
+                        // Mark the place ready to be written in the next round.
+                        c->sequence.store(head + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0)
+                    return false;
+                else
+                    head = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        ///
+        /// Moves the head element of the queue out, waiting for one when the queue is empty.
+        ///
+        /// \param[out] v  Element popped
+        ///
+        inline void pop(_Out_ value_type &v)
+        {
+            for (size_type i = 0; !try_pop(v); i++)
+                backoff(i);
+        }
+
+        ///
+        /// Returns a copy of the head element in the queue.
+        ///
+        /// \note The element may be popped by another thread by the time this function returns.
+        ///
+        inline value_type front() const
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Peeking requires trivially copyable elements");
+            value_type v;
+            for (size_type i = 0;; i++) {
+                size_type head = m_head.load(std::memory_order_acquire);
+                if (m_tail.load(std::memory_order_acquire) == head)
+                    throw std::invalid_argument("Empty storage");
+                if (peek(head, v))
+                    return v;
+
+                // The head element was popped meanwhile, or its producer has not finished writing it yet.
+                backoff(i);
+            }
+        }
+
+        ///
+        /// Returns a copy of the last element in the queue.
+        ///
+        /// \note The element may be popped by another thread by the time this function returns.
+        ///
+        inline value_type back() const
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Peeking requires trivially copyable elements");
+            value_type v;
+            for (size_type i = 0;; i++) {
+                size_type head = m_head.load(std::memory_order_acquire), tail = m_tail.load(std::memory_order_acquire);
+                if (tail == head)
+                    throw std::invalid_argument("Empty storage");
+                if (peek(tail - 1, v))
+                    return v;
+
+                // The producer of the last element might not have finished writing it yet.
+                backoff(i);
+            }
+        }
+
+    protected:
+        ///
+        /// Storage place
+        ///
+        struct cell
+        {
+            std::atomic<size_type> sequence;    ///< Round number: equals the index while ready to be written, and the index + 1 while ready to be read
+            value_type data;                    ///< Element
+        };
+
+        ///
+        /// Claims a place at the end of the queue
+        ///
+        /// \returns Place to write the element to and publish by incrementing its sequence, or `NULL` when the queue is full
+        ///
+        inline cell* reserve_push()
+        {
+            size_type tail = m_tail.load(std::memory_order_relaxed);
+            for (;;) {
+                cell *c = m_data + (tail & m_mask);
+                size_type seq = c->sequence.load(std::memory_order_acquire);
+                ptrdiff_t diff = (ptrdiff_t)(seq - tail);
+                if (diff == 0) {
+                    if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                        return c;
+                } else if (diff < 0)
+                    return NULL;
+                else
+                    tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        ///
+        /// Copies the element at the given index when it is ready to be read
+        ///
+        /// \param[in ] pos  Index of the element
+        /// \param[out] v    Element copied
+        ///
+        /// \returns `true` when the element was ready and was not modified while being copied
+        ///
+        inline bool peek(_In_ size_type pos, _Out_ value_type &v) const
+        {
+            const cell *c = m_data + (pos & m_mask);
+            if (c->sequence.load(std::memory_order_acquire) != pos + 1)
+                return false;
+            v = c->data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return c->sequence.load(std::memory_order_relaxed) == pos + 1;
+        }
+
+        ///
+        /// Waits before retrying a blocking operation
+        ///
+        /// \param[in] attempt  Number of failed attempts so far
+        ///
+        static inline void backoff(_In_ size_type attempt)
+        {
+            if (attempt >= 16)
+                std::this_thread::yield();
+        }
+
+    protected:
+        cell *m_data;                                                   ///< Underlying data container
+        size_type m_mask;                                               ///< Index mask: size of `m_data` minus one
+        char m_padding0[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+
+        std::atomic<size_type> m_head;                                  ///< Number of elements ever popped
+        char m_padding1[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+
+        std::atomic<size_type> m_tail;                                  ///< Number of elements ever pushed
+        char m_padding2[WINSTD_CACHE_LINE_BYTES];                       ///< Padding to keep indices on separate cache lines
+    };
+
+
+    ///
+    /// GUID value type
+    ///
+    /// Compares all 128 bits at once, and orders GUIDs the same as their `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}`
+    /// representation. `std::hash` is specialized to allow use as a key in unordered containers.
+    ///
+    class guid : public GUID
+    {
+    public:
+        ///
+        /// Initializes null GUID
+        ///
+        constexpr guid() : GUID{}
+        {
+        }
+
+        ///
+        /// Initializes GUID
+        ///
+        /// \param[in] g  GUID
+        ///
+        constexpr guid(_In_ const GUID &g) : GUID(g)
+        {
+        }
+
+        ///
+        /// Initializes GUID from its fields
+        ///
+        constexpr guid(_In_ unsigned long data1, _In_ unsigned short data2, _In_ unsigned short data3,
+            _In_ unsigned char data4_0, _In_ unsigned char data4_1, _In_ unsigned char data4_2, _In_ unsigned char data4_3,
+            _In_ unsigned char data4_4, _In_ unsigned char data4_5, _In_ unsigned char data4_6, _In_ unsigned char data4_7) :
+            GUID{ data1, data2, data3, { data4_0, data4_1, data4_2, data4_3, data4_4, data4_5, data4_6, data4_7 } }
+        {
+        }
+
+        ///
+        /// Initializes GUID from string literal
+        ///
+        /// When evaluated at compile time, an invalid literal fails to compile.
+        ///
+        /// \param[in] str  String literal in `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` or `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX` form
+        ///
+        /// \throw std::invalid_argument  Invalid GUID
+        ///
+        template<class _Elem, size_t N>
+        constexpr guid(_In_ const _Elem (&str)[N]) : guid(from_digits(check_layout(str)))
+        {
+        }
+
+        ///
+        /// Are GUIDs equal?
+        ///
+        inline bool operator==(_In_ const GUID &g) const
+        {
+            unsigned long long a[2], b[2];
+            memcpy(a, static_cast<const GUID*>(this), sizeof(a));
+            memcpy(b, &g, sizeof(b));
+            return ((a[0] ^ b[0]) | (a[1] ^ b[1])) == 0;
+        }
+
+        ///
+        /// Are GUIDs different?
+        ///
+        inline bool operator!=(_In_ const GUID &g) const
+        {
+            return !operator==(g);
+        }
+
+        ///
+        /// Is GUID less than?
+        ///
+        inline bool operator<(_In_ const GUID &g) const
+        {
+            unsigned long long a_hi, a_lo, b_hi, b_lo;
+            key(*this, a_hi, a_lo);
+            key(g, b_hi, b_lo);
+            return a_hi < b_hi || (a_hi == b_hi && a_lo < b_lo);
+        }
+
+        ///
+        /// Is GUID less than or equal?
+        ///
+        inline bool operator<=(_In_ const GUID &g) const
+        {
+            return !guid(g).operator<(*this);
+        }
+
+        ///
+        /// Is GUID greater than?
+        ///
+        inline bool operator>(_In_ const GUID &g) const
+        {
+            return guid(g).operator<(*this);
+        }
+
+        ///
+        /// Is GUID greater than or equal?
+        ///
+        inline bool operator>=(_In_ const GUID &g) const
+        {
+            return !operator<(g);
+        }
+
+        ///
+        /// Returns hash value
+        ///
+        /// Both 64-bit halves are mixed, so GUIDs differing in a few bits only (i.e. sequential GUIDs) spread evenly.
+        ///
+        inline size_t hash() const
+        {
+            unsigned long long h[2];
+            memcpy(h, static_cast<const GUID*>(this), sizeof(h));
+            unsigned long long x = h[0] ^ (h[1] * 0x9e3779b97f4a7c15ull);
+            x ^= x >> 32;
+            x *= 0xd6e8feb86659fd93ull;
+            x ^= x >> 32;
+            return (size_t)x;
+        }
+
+    protected:
+        /// \cond internal
+
+        ///
+        /// Returns GUID as two integers ordered the same as its string representation
+        ///
+        static inline void key(_In_ const GUID &g, _Out_ unsigned long long &hi, _Out_ unsigned long long &lo)
+        {
+            hi = ((unsigned long long)g.Data1 << 32) | ((unsigned long long)g.Data2 << 16) | g.Data3;
+            memcpy(&lo, g.Data4, sizeof(lo));
+            lo = _byteswap_uint64(lo);
+        }
+
+        ///
+        /// Validates GUID literal
+        ///
+        /// \returns Pointer to the first digit
+        ///
+        template<class _Elem, size_t N>
+        static constexpr const _Elem* check_layout(_In_ const _Elem (&str)[N])
+        {
+            static_assert(N == 37 || N == 39, "GUID literal must be 36 characters long, or 38 with braces");
+            const size_t offset = N == 39 ? 1 : 0;
+            if ((offset && (str[0] != '{' || str[37] != '}')) || str[N - 1] ||
+                str[offset + 8] != '-' || str[offset + 13] != '-' || str[offset + 18] != '-' || str[offset + 23] != '-')
+                throw std::invalid_argument("Invalid GUID");
+            return str + offset;
+        }
+
+        ///
+        /// Parses hexadecimal digits of GUID literal
+        ///
+        template<class _Elem>
+        static constexpr unsigned long long parse_hex(_In_count_(count) const _Elem *str, _In_ size_t count)
+        {
+            unsigned long long value = 0;
+            for (size_t i = 0; i < count; i++) {
+                value = (value << 4) | (unsigned)(
+                    '0' <= str[i] && str[i] <= '9' ? str[i] - '0' :
+                    'A' <= str[i] && str[i] <= 'F' ? str[i] - 'A' + 10 :
+                    'a' <= str[i] && str[i] <= 'f' ? str[i] - 'a' + 10 :
+                    throw std::invalid_argument("Invalid GUID"));
+            }
+            return value;
+        }
+
+        ///
+        /// Parses `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX`
+        ///
+        template<class _Elem>
+        static constexpr guid from_digits(_In_count_c_(36) const _Elem *str)
+        {
+            return guid(
+                (unsigned long)parse_hex(str, 8), (unsigned short)parse_hex(str + 9, 4), (unsigned short)parse_hex(str + 14, 4),
+                (unsigned char)parse_hex(str + 19, 2), (unsigned char)parse_hex(str + 21, 2),
+                (unsigned char)parse_hex(str + 24, 2), (unsigned char)parse_hex(str + 26, 2), (unsigned char)parse_hex(str + 28, 2),
+                (unsigned char)parse_hex(str + 30, 2), (unsigned char)parse_hex(str + 32, 2), (unsigned char)parse_hex(str + 34, 2));
+        }
+
+        /// \endcond
+    };
+
+    /// @}
+
+    /// \addtogroup WinStdExceptions
+    /// @{
+
+    ///
+    /// Numerical runtime error
+    ///
+    template <typename _Tn>
+    class num_runtime_error : public std::runtime_error
+    {
+    public:
+        typedef _Tn error_type; ///< Error number type
+
+    public:
+        ///
+        /// Constructs an exception
+        ///
+        /// \param[in] num  Numeric error code
+        /// \param[in] msg  Error message
+        ///
+        inline num_runtime_error(_In_ error_type num, _In_ const std::string& msg) :
+            m_num(num),
+            runtime_error(msg)
+        {
+        }
+
+
+        ///
+        /// Constructs an exception
+        ///
+        /// \param[in] num  Numeric error code
+        /// \param[in] msg  Error message
+        ///
+        inline num_runtime_error(_In_ error_type num, _In_z_ const char *msg) :
+            m_num(num),
+            runtime_error(msg)
+        {
+        }
+
+
+        ///
+        /// Copies an exception
+        ///
+        /// \param[in] other  Exception to copy from
+        ///
+        inline num_runtime_error(const num_runtime_error<_Tn> &other) :
+            m_num(other.m_num),
+            runtime_error(other)
+        {
+        }
+
+
+        ///
+        /// Copies an exception
+        ///
+        /// \param[in] other  Exception to copy from
+        ///
+        inline num_runtime_error& operator=(const num_runtime_error<_Tn> &other)
+        {
+            if (this != addressof(other)) {
+                *(runtime_error*)this = other;
+                m_num                 = other.m_num;
+            }
+
+            return *this;
+        }
+
+
+        ///
+        /// Returns the Windows error number
+        ///
+        inline error_type number() const
+        {
+            return m_num;
+        }
+
+    protected:
+        error_type m_num;  ///< Numeric error code
+    };
+
+
+    ///
+    /// Windows runtime error
+    ///
+    class WINSTD_API win_runtime_error : public num_runtime_error<DWORD>
+    {
+    public:
+        ///
+        /// Constructs an exception
+        ///
+        /// \param[in] num Windows error code
+        /// \param[in] msg Error message
+        ///
+        inline win_runtime_error(_In_ error_type num, _In_ const std::string& msg) : num_runtime_error<DWORD>(num, msg)
+        {
+        }
+
+
+        ///
+        /// Constructs an exception
+        ///
+        /// \param[in] num  Windows error code
+        /// \param[in] msg  Error message
+        ///
+        inline win_runtime_error(_In_ error_type num, _In_z_ const char *msg) : num_runtime_error<DWORD>(num, msg)
+        {
+        }
+
+
+        ///
+        /// Constructs an exception using `GetLastError()`
+        ///
+        /// \param[in] msg  Error message
+        ///
+        inline win_runtime_error(_In_ const std::string& msg) : num_runtime_error<DWORD>(GetLastError(), msg)
+        {
+        }
+
+
+        ///
+        /// Constructs an exception using `GetLastError()`
+        ///
+        /// \param[in] msg  Error message
+        ///
+        inline win_runtime_error(_In_z_ const char *msg) : num_runtime_error<DWORD>(GetLastError(), msg)
+        {
+        }
+
+
+        ///
+        /// Copies an exception
+        ///
+        /// \param[in] other  Exception to copy from
+        ///
+        inline win_runtime_error(const win_runtime_error &other) : num_runtime_error<DWORD>(other)
+        {
+        }
+
+
+        ///
+        /// Returns a user-readable Windows error message
+        ///
+        /// \sa [FormatMessage function](https://docs.microsoft.com/en-us/windows/desktop/api/winbase/nf-winbase-formatmessage)
         ///
         inline tstring msg(_In_opt_ DWORD dwLanguageId = 0) const
         {
-            tstring str;
-            if (FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, 0, m_num, dwLanguageId, str, NULL)) {
-                // Stock Windows error messages contain CRLF. Well... Trim all the trailing white space.
-                str.erase(str.find_last_not_of(_T(" \t\n\r\f\v")) + 1);
-            } else
-                sprintf(str, m_num >= 0x10000 ? _T("Error 0x%X") : _T("Error %u"), m_num);
-            return str;
+            tstring str;
+            if (FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS, 0, m_num, dwLanguageId, str, NULL)) {
+                // Stock Windows error messages contain CRLF. Well... Trim all the trailing white space.
+                str.erase(str.find_last_not_of(_T(" \t\n\r\f\v")) + 1);
+            } else
+                sprintf(str, m_num >= 0x10000 ? _T("Error 0x%X") : _T("Error %u"), m_num);
+            return str;
+        }
+    };
+
+    /// @}
+
+    /// \addtogroup WinStdStrFormat
+    /// @{
+
+    /// \cond internal
+
+    ///
+    /// Writes decimal digits of an unsigned integer backwards, two digits at a time
+    ///
+    /// \param[in] end    Pointer past the place for the last digit
+    /// \param[in] value  Integer value
+    ///
+    /// \returns Pointer to the first digit written
+    ///
+    template<class _Elem>
+    inline _Elem* dec_digits(_In_ _Elem *end, _In_ unsigned long long value)
+    {
+        static const char pairs[201] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        // Divide in 64-bit only while necessary: it is expensive on 32-bit platforms.
+        while (value > 0xffffffff) {
+            unsigned long long q = value / 100;
+            unsigned i = (unsigned)(value - q * 100) * 2;
+            *--end = pairs[i + 1];
+            *--end = pairs[i];
+            value = q;
+        }
+        unsigned v = (unsigned)value;
+        while (v >= 100) {
+            unsigned i = (v % 100) * 2;
+            v /= 100;
+            *--end = pairs[i + 1];
+            *--end = pairs[i];
+        }
+        if (v >= 10) {
+            *--end = pairs[v * 2 + 1];
+            *--end = pairs[v * 2];
+        } else
+            *--end = (_Elem)('0' + v);
+        return end;
+    }
+
+
+    ///
+    /// Returns two hexadecimal digits for each byte value
+    ///
+    /// \param[in] lowercase  `true` for `a`-`f` digits; `false` for `A`-`F`
+    ///
+    inline const char* hex_digit_pairs(_In_ bool lowercase)
+    {
+        static const char upper[513] =
+            "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+            "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+            "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+            "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+            "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+            "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+            "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+            "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+        static const char lower[513] =
+            "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+            "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+            "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+            "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+            "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+            "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+            "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+            "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+        return lowercase ? lower : upper;
+    }
+
+
+    ///
+    /// Writes hexadecimal digits of an unsigned integer backwards, one byte at a time
+    ///
+    /// \param[in] end        Pointer past the place for the last digit
+    /// \param[in] value      Integer value
+    /// \param[in] lowercase  `true` for `a`-`f` digits; `false` for `A`-`F`
+    ///
+    /// \returns Pointer to the first digit written
+    ///
+    template<class _Elem>
+    inline _Elem* hex_digits(_In_ _Elem *end, _In_ unsigned long long value, _In_ bool lowercase = false)
+    {
+        const char *pairs = hex_digit_pairs(lowercase);
+
+        while (value > 0xff) {
+            unsigned i = (unsigned)(value & 0xff) * 2;
+            *--end = pairs[i + 1];
+            *--end = pairs[i];
+            value >>= 8;
+        }
+        unsigned v = (unsigned)value;
+        *--end = pairs[v * 2 + 1];
+        if (v > 0xf)
+            *--end = pairs[v * 2];
+        return end;
+    }
+
+
+    ///
+    /// Appends digits to a string, padding them to the field width
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    inline void append_digits(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_ bool negative, _In_reads_(count) const _Elem *digits, _In_ size_t count, _In_ size_t width, _In_ _Elem fill)
+    {
+        size_t len = count + (negative ? 1 : 0);
+        size_t pad = width > len ? width - len : 0;
+        if (pad && fill != '0')
+            str.append(pad, fill);
+        if (negative)
+            str += '-';
+        if (pad && fill == '0')
+            str.append(pad, fill);
+        str.append(digits, count);
+    }
+
+    /// \endcond
+
+
+    ///
+    /// Appends decimal representation of an integer to a string
+    ///
+    /// Equivalent of `printf()` `%d` or `%u` conversion, without the overhead of parsing the template.
+    ///
+    /// \param[inout] str    String to append to
+    /// \param[in   ] value  Integer value
+    /// \param[in   ] width  Minimum field width
+    /// \param[in   ] fill   Padding character. When `'0'`, zeros are inserted after the sign.
+    ///
+    template<class _Elem, class _Traits, class _Ax, class _Ty>
+    inline void append_dec(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_ _Ty value, _In_ size_t width = 0, _In_ _Elem fill = ' ')
+    {
+        static_assert(std::is_integral<_Ty>::value, "Integer type required");
+        bool negative = value < 0;
+        unsigned long long u = negative ? 0 - (unsigned long long)value : (unsigned long long)value;
+        _Elem buf[20], *end = buf + _countof(buf), *p = dec_digits(end, u);
+        append_digits(str, negative, p, end - p, width, fill);
+    }
+
+
+    ///
+    /// Appends hexadecimal representation of an integer to a string
+    ///
+    /// Equivalent of `printf()` `%X` or `%x` conversion, without the overhead of parsing the template. Signed values
+    /// are represented in two's complement of their size.
+    ///
+    /// \param[inout] str        String to append to
+    /// \param[in   ] value      Integer value
+    /// \param[in   ] width      Minimum field width
+    /// \param[in   ] fill       Padding character
+    /// \param[in   ] lowercase  `true` for `a`-`f` digits; `false` for `A`-`F`
+    ///
+    template<class _Elem, class _Traits, class _Ax, class _Ty>
+    inline void append_hex(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_ _Ty value, _In_ size_t width = 0, _In_ _Elem fill = '0', _In_ bool lowercase = false)
+    {
+        static_assert(std::is_integral<_Ty>::value, "Integer type required");
+        _Elem buf[16], *end = buf + _countof(buf), *p = hex_digits(end, (unsigned long long)(typename std::make_unsigned<_Ty>::type)value, lowercase);
+        append_digits(str, false, p, end - p, width, fill);
+    }
+
+
+    ///
+    /// Appends hexadecimal representation of a pointer to a string
+    ///
+    /// Equivalent of `printf()` `%p` or `%#p` conversion: the address is zero-padded to the full pointer width.
+    ///
+    /// \param[inout] str     String to append to
+    /// \param[in   ] ptr     Pointer
+    /// \param[in   ] prefix  `true` to prepend `0X`
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    inline void append_ptr(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_opt_ const void *ptr, _In_ bool prefix = false)
+    {
+        if (prefix) {
+            str += '0';
+            str += 'X';
+        }
+        append_hex(str, (size_t)ptr, 2 * sizeof(void*));
+    }
+
+
+    ///
+    /// Statistics of thread-local formatting buffers
+    ///
+    /// The counters are updated only when `WINSTD_FORMAT_TLS_BUFFERS` is set to 1. They may be sampled at any time.
+    ///
+    struct format_buffer_stats
+    {
+        std::atomic<unsigned long long> hits;   ///< Number of results formatted in a thread-local buffer
+        std::atomic<unsigned long long> misses; ///< Number of results that did not fit in a thread-local buffer
+        std::atomic<unsigned long long> bytes;  ///< Total size of results formatted in thread-local buffers (in bytes)
+    };
+
+
+    ///
+    /// Returns process-wide statistics of thread-local formatting buffers
+    ///
+    inline format_buffer_stats& get_format_buffer_stats()
+    {
+        static format_buffer_stats stats;
+        return stats;
+    }
+
+
+    /// \cond internal
+
+    ///
+    /// Returns calling thread's formatting scratch buffer
+    ///
+    template<class _Elem>
+    inline std::vector<_Elem>& get_format_buffer()
+    {
+        static thread_local std::vector<_Elem> buf;
+        return buf;
+    }
+
+    ///
+    /// Grows calling thread's formatting scratch buffer to fit `count` characters and a terminator
+    ///
+    template<class _Elem>
+    inline void grow_format_buffer(_Inout_ std::vector<_Elem> &buf, _In_ size_t count)
+    {
+        if (buf.size() <= count && count < WINSTD_FORMAT_TLS_BUFFER_MAX_BYTES/sizeof(_Elem))
+            buf.resize(std::max<size_t>(count + 1, std::min<size_t>(buf.size() * 2, WINSTD_FORMAT_TLS_BUFFER_MAX_BYTES/sizeof(_Elem))));
+    }
+
+    ///
+    /// Counts a result formatted in a thread-local buffer
+    ///
+    template<class _Elem>
+    inline void count_format_buffer_hit(_In_ size_t count)
+    {
+        format_buffer_stats &stats = get_format_buffer_stats();
+        stats.hits.fetch_add(1, std::memory_order_relaxed);
+        stats.bytes.fetch_add(count * sizeof(_Elem), std::memory_order_relaxed);
+    }
+
+    ///
+    /// Formats a message in calling thread's scratch buffer
+    ///
+    /// \returns
+    /// - Number of characters in result on success;
+    /// - 0 on error other than insufficient buffer;
+    /// - -1 when the result does not fit in the scratch buffer. `Arguments` remain unused then.
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    inline int FormatMessage_tls(_In_ DWORD (WINAPI *pfn)(DWORD, LPCVOID, DWORD, DWORD, _Elem*, DWORD, va_list*), _In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_opt_ va_list *Arguments)
+    {
+        std::vector<_Elem> &buf = get_format_buffer<_Elem>();
+        if (buf.empty())
+            buf.resize(WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem));
+
+        // FormatMessage() consumes the va_list. Work on a copy to keep the original for retry.
+        DWORD dwResult;
+        if (Arguments && !(dwFlags & FORMAT_MESSAGE_ARGUMENT_ARRAY)) {
+            va_list arg;
+            va_copy(arg, *Arguments);
+            dwResult = pfn(dwFlags & ~FORMAT_MESSAGE_ALLOCATE_BUFFER, lpSource, dwMessageId, dwLanguageId, buf.data(), (DWORD)buf.size(), &arg);
+            va_end(arg);
+        } else
+            dwResult = pfn(dwFlags & ~FORMAT_MESSAGE_ALLOCATE_BUFFER, lpSource, dwMessageId, dwLanguageId, buf.data(), (DWORD)buf.size(), Arguments);
+        if (dwResult) {
+            str.assign(buf.data(), dwResult);
+            count_format_buffer_hit<_Elem>(dwResult);
+            return (int)dwResult;
+        }
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+            return 0;
+        get_format_buffer_stats().misses.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    ///
+    /// Formats string using dedicated integer kernels when `format` is a single simple conversion
+    ///
+    /// Accepted templates are `%[#][0][width][l|ll|I|I32|I64|z](d|i|u|x|X)` and `%[#]p` with at most two width digits,
+    /// and no text around the conversion. `#` is accepted for `p` only.
+    ///
+    /// \param[out] str     Formatted string
+    /// \param[in ] format  String template using `printf()` style
+    /// \param[in ] arg     Arguments to `format`
+    ///
+    /// \returns Number of characters in result; or -1 when `format` is not a single simple conversion, leaving `str` and `arg` untouched.
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    inline int vsprintf_int(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ const _Elem *format, _In_ va_list arg)
+    {
+        if (format[0] != '%')
+            return -1;
+        const _Elem *f = format + 1;
+        bool alt = false;
+        _Elem fill = ' ';
+        if (*f == '#') { alt = true; f++; }
+        if (*f == '0') { fill = '0'; f++; }
+        size_t width = 0;
+        for (int i = 0; i < 2 && '0' <= *f && *f <= '9'; i++, f++)
+            width = width * 10 + (*f - '0');
+        size_t size = sizeof(int);
+        if (f[0] == 'l' && f[1] == 'l') { size = sizeof(long long); f += 2; }
+        else if (f[0] == 'l') { size = sizeof(long); f++; }
+        else if (f[0] == 'I' && f[1] == '6' && f[2] == '4') { size = sizeof(long long); f += 3; }
+        else if (f[0] == 'I' && f[1] == '3' && f[2] == '2') { size = sizeof(int); f += 3; }
+        else if (f[0] == 'I' || f[0] == 'z') { size = sizeof(size_t); f++; }
+        if (!f[0] || f[1])
+            return -1;
+
+        // format may point into str. Done reading it before str is cleared.
+        const _Elem conv = f[0];
+        switch (conv) {
+        case 'd': case 'i': case 'u': case 'x': case 'X':
+            if (alt) return -1;
+            break;
+        case 'p':
+            if (f - format != (alt ? 2 : 1)) return -1;
+            break;
+        default:
+            return -1;
+        }
+
+        str.clear();
+        switch (conv) {
+        case 'd': case 'i':
+            if (size == sizeof(long long)) append_dec(str, va_arg(arg, long long), width, fill);
+            else                           append_dec(str, va_arg(arg, int), width, fill);
+            break;
+        case 'u':
+            if (size == sizeof(long long)) append_dec(str, va_arg(arg, unsigned long long), width, fill);
+            else                           append_dec(str, va_arg(arg, unsigned int), width, fill);
+            break;
+        case 'x': case 'X':
+            if (size == sizeof(long long)) append_hex(str, va_arg(arg, unsigned long long), width, fill, conv == 'x');
+            else                           append_hex(str, va_arg(arg, unsigned int), width, fill, conv == 'x');
+            break;
+        default:
+            append_ptr(str, va_arg(arg, void*), alt);
+        }
+        return (int)str.size();
+    }
+
+    ///
+    /// Checks if a `printf()` style template has string conversions
+    ///
+    /// String arguments may point into the string being formatted.
+    ///
+    /// \param[in] format  String template using `printf()` style
+    ///
+    /// \returns `true` if `format` has `%s`, `%S` or `%Z` conversions; `false` otherwise
+    ///
+    template<class _Elem>
+    inline bool vsprintf_has_strings(_In_z_ const _Elem *format)
+    {
+        for (const _Elem *f = format; *f; ) {
+            if (*f++ != '%')
+                continue;
+
+            // Skip flags, width, precision and size prefix.
+            while (*f && (size_t)*f < 0x80 && strchr("-+ #0123456789.*hlwjztIL", (char)*f))
+                f++;
+            switch (*f) {
+            case 's': case 'S': case 'Z':
+                return true;
+            case 0:
+                return false;
+            }
+            f++;
+        }
+        return false;
+    }
+
+    ///
+    /// Formats string using `printf()` on a copy of the argument list
+    ///
+    /// Unlike `arg`, which the C99 `vsnprintf()` consumes, the copy can be passed more than once.
+    ///
+    template<class _Elem>
+    inline int vsnprintf_copy(_Out_z_cap_(capacity) _Elem *str, _In_ size_t capacity, _In_z_ const _Elem *format, _In_ va_list arg)
+    {
+        va_list arg_copy;
+        va_copy(arg_copy, arg);
+        int count = str ? ::vsnprintf(str, capacity, format, arg_copy) : ::vscprintf(format, arg_copy);
+        va_end(arg_copy);
+        return count;
+    }
+
+    /// \endcond
+
+    /// @}
+
+    /// \addtogroup WinStdStrFormat
+    /// @{
+
+    ///
+    /// Base template class to support string formatting using `printf()` style templates
+    ///
+    /// Each instance is a new string. To reuse the storage when formatting repeatedly, call `sprintf()` on an existing string instead.
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    class basic_string_printf : public std::basic_string<_Elem, _Traits, _Ax>
+    {
+    public:
+        /// \name Initializing string using template in memory
+        /// @{
+
+        ///
+        /// Initializes a new string and formats its contents using `printf()` style template.
+        ///
+        /// \param[in] format  String template using `printf()` style
+        ///
+        inline basic_string_printf(_In_z_ _Printf_format_string_ const _Elem *format, ...)
+        {
+            va_list arg;
+            va_start(arg, format);
+            vsprintf(*this, format, arg);
+            va_end(arg);
+        }
+
+        /// @}
+
+        /// \name Initializing string using template in resources
+        /// @{
+
+        ///
+        /// Initializes a new string and formats its contents using `printf()` style template in resources.
+        ///
+        /// \param[in] hInstance  Resource module handle
+        /// \param[in] nFormatID  Resource ID of the string template using `printf()` style
+        ///
+        inline basic_string_printf(_In_ HINSTANCE hInstance, _In_ UINT nFormatID, ...)
+        {
+            std::basic_string<_Elem, _Traits, _Ax> format;
+            ATLENSURE(format.LoadString(hInstance, nFormatID));
+
+            va_list arg;
+            va_start(arg, nFormatID);
+            vsprintf(*this, format, arg);
+            va_end(arg);
+        }
+
+        ///
+        /// Initializes a new string and formats its contents using `printf()` style template in resources.
+        ///
+        /// \param[in] hInstance    Resource module handle
+        /// \param[in] wLanguageID  Resource language
+        /// \param[in] nFormatID    Resource ID of the string template using `printf()` style
+        ///
+        inline basic_string_printf(_In_ HINSTANCE hInstance, _In_ WORD wLanguageID, _In_ UINT nFormatID, ...)
+        {
+            std::basic_string<_Elem, _Traits, _Ax> format;
+            ATLENSURE(format.LoadString(hInstance, nFormatID, wLanguageID));
+
+            va_list arg;
+            va_start(arg, nFormatID);
+            vsprintf(*this, format, arg);
+            va_end(arg);
+        }
+
+        /// }@
+    };
+
+
+    ///
+    /// Base template class to support string formatting using `FormatMessage()` style templates
+    ///
+    /// Each instance is a new string. To reuse the storage when formatting repeatedly, call `FormatMessage()` on an existing string instead.
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    class basic_string_msg : public std::basic_string<_Elem, _Traits, _Ax>
+    {
+    public:
+        /// \name Initializing string using template in memory
+        /// @{
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style template.
+        ///
+        /// \param[in] format  String template using `FormatMessage()` style
+        ///
+        inline basic_string_msg(_In_z_ _FormatMessage_format_string_ const _Elem *format, ...)
+        {
+            va_list arg;
+            va_start(arg, format);
+            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
+            va_end(arg);
+        }
+
+        /// @}
+
+        /// \name Initializing string using template in resources
+        /// @{
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style template in resources.
+        ///
+        /// \param[in] hInstance  Resource module handle
+        /// \param[in] nFormatID  Resource ID of the string template using `FormatMessage()` style
+        ///
+        inline basic_string_msg(_In_ HINSTANCE hInstance, _In_ UINT nFormatID, ...)
+        {
+            std::basic_string<_Elem, _Traits, _Ax> format(this->GetManager());
+            ATLENSURE(format.LoadString(hInstance, nFormatID));
+
+            va_list arg;
+            va_start(arg, nFormatID);
+            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
+            va_end(arg);
+        }
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style template in resources.
+        ///
+        /// \param[in] hInstance    Resource module handle
+        /// \param[in] wLanguageID  Resource language
+        /// \param[in] nFormatID    Resource ID of the string template using `FormatMessage()` style
+        ///
+        inline basic_string_msg(_In_ HINSTANCE hInstance, _In_ WORD wLanguageID, _In_ UINT nFormatID, ...)
+        {
+            std::basic_string<_Elem, _Traits, _Ax> format(this->GetManager());
+            ATLENSURE(format.LoadString(hInstance, nFormatID, wLanguageID));
+
+            va_list arg;
+            va_start(arg, nFormatID);
+            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
+            va_end(arg);
+        }
+
+        /// @}
+
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style.
+        ///
+        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        ///
+        inline basic_string_msg(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _In_opt_ va_list *Arguments)
+        {
+            FormatMessage(dwFlags & ~FORMAT_MESSAGE_ARGUMENT_ARRAY, lpSource, dwMessageId, dwLanguageId, *this, Arguments);
+        }
+
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style.
+        ///
+        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        ///
+        inline basic_string_msg(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _In_opt_ DWORD_PTR *Arguments)
+        {
+            FormatMessage(dwFlags | FORMAT_MESSAGE_ARGUMENT_ARRAY, lpSource, dwMessageId, dwLanguageId, *this, (va_list*)Arguments);
+        }
+
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style.
+        ///
+        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        ///
+        inline basic_string_msg(_In_ DWORD dwFlags, _In_z_ LPCTSTR pszFormat, _In_opt_ va_list *Arguments)
+        {
+            FormatMessage(dwFlags & ~FORMAT_MESSAGE_ARGUMENT_ARRAY | FORMAT_MESSAGE_FROM_STRING, pszFormat, 0, 0, *this, Arguments);
+        }
+
+
+        ///
+        /// Initializes a new string and formats its contents using `FormatMessage()` style.
+        ///
+        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        ///
+        inline basic_string_msg(_In_ DWORD dwFlags, _In_z_ LPCTSTR pszFormat, _In_opt_ DWORD_PTR *Arguments)
+        {
+            FormatMessage(dwFlags | FORMAT_MESSAGE_ARGUMENT_ARRAY | FORMAT_MESSAGE_FROM_STRING, pszFormat, 0, 0, *this, (va_list*)Arguments);
         }
     };
 
-    /// @}
 
-    /// \addtogroup WinStdStrFormat
-    /// @{
+    ///
+    /// Writes GUID in `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` form
+    ///
+    /// \param[out] str        Buffer to receive 38 characters; 36 without braces. The result is not zero-terminated.
+    /// \param[in ] guid       GUID to convert
+    /// \param[in ] lowercase  `true` for `a`-`f` digits; `false` for `A`-`F`
+    /// \param[in ] braces     `true` to enclose GUID in braces
+    ///
+    /// \returns Pointer past the last character written
+    ///
+    template<class _Elem>
+    inline _Elem* guid_format(_Out_writes_(38) _Elem *str, _In_ const GUID &guid, _In_ bool lowercase = false, _In_ bool braces = true)
+    {
+        // Position of each byte's digits relative to the first digit
+        static const unsigned char offsets[16] = { 0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34 };
+        const unsigned char bytes[16] = {
+            (unsigned char)(guid.Data1 >> 24), (unsigned char)(guid.Data1 >> 16), (unsigned char)(guid.Data1 >> 8), (unsigned char)guid.Data1,
+            (unsigned char)(guid.Data2 >> 8), (unsigned char)guid.Data2,
+            (unsigned char)(guid.Data3 >> 8), (unsigned char)guid.Data3,
+            guid.Data4[0], guid.Data4[1], guid.Data4[2], guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7] };
+        const char *pairs = hex_digit_pairs(lowercase);
+
+        _Elem *p = str + (braces ? 1 : 0);
+        for (size_t i = 0; i < 16; i++) {
+            p[offsets[i]    ] = pairs[bytes[i] * 2    ];
+            p[offsets[i] + 1] = pairs[bytes[i] * 2 + 1];
+        }
+        p[8] = p[13] = p[18] = p[23] = '-';
+        if (!braces)
+            return p + 36;
+        str[ 0] = '{';
+        str[37] = '}';
+        return str + 38;
+    }
+
+
+    ///
+    /// Formats GUID in `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` form
+    ///
+    /// \param[out] str        String to store the result to
+    /// \param[in ] guid       GUID to convert
+    /// \param[in ] lowercase  `true` for `a`-`f` digits; `false` for `A`-`F`
+    /// \param[in ] braces     `true` to enclose GUID in braces
+    ///
+    template<class _Elem, class _Traits, class _Ax>
+    inline void guid_format(_Out_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_ const GUID &guid, _In_ bool lowercase = false, _In_ bool braces = true)
+    {
+        _Elem buf[38];
+        str.assign(buf, guid_format(buf, guid, lowercase, braces));
+    }
+
+
+    /// \cond internal
+
+    ///
+    /// Parses fixed number of hexadecimal digits
+    ///
+    /// \returns `true` if all `count` characters are hexadecimal digits. Parsing stops at the first one that is not.
+    ///
+    template<class _Elem>
+    inline bool guid_parse_hex(_In_count_(count) const _Elem *str, _In_ size_t count, _Out_ unsigned long long &value)
+    {
+        static const unsigned char digits[128] = {
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        };
+
+        value = 0;
+        for (size_t i = 0; i < count; i++) {
+            typename std::make_unsigned<_Elem>::type c = str[i];
+            unsigned char d = c < _countof(digits) ? digits[c] : 0xff;
+            if (d > 0xf)
+                return false;
+            value = (value << 4) | d;
+        }
+        return true;
+    }
+
+    /// \endcond
+
+
+    ///
+    /// Parses GUID
+    ///
+    /// Accepts exactly `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` or `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX` form. This
+    /// is the portable implementation for any character type. Single-byte and wide strings use vectorized overloads.
+    ///
+    /// \param[in ] str   String with GUID
+    /// \param[out] guid  GUID to store the result to
+    ///
+    /// \returns Pointer to the end of parsed GUID within `str`; `NULL` if `str` does not start with a GUID.
+    ///
+    template<class _Elem>
+    inline _Success_(return != NULL) const _Elem* guid_parse(_In_z_ const _Elem *str, _Out_ GUID &guid)
+    {
+        const _Elem *p = *str == '{' ? str + 1 : str;
+        unsigned long long d1, d2, d3, d4, d5;
+        if (!guid_parse_hex(p     ,  8, d1) || p[ 8] != '-' ||
+            !guid_parse_hex(p +  9,  4, d2) || p[13] != '-' ||
+            !guid_parse_hex(p + 14,  4, d3) || p[18] != '-' ||
+            !guid_parse_hex(p + 19,  4, d4) || p[23] != '-' ||
+            !guid_parse_hex(p + 24, 12, d5))
+            return NULL;
+        p += 36;
+        if (p - str == 37 && *p++ != '}')
+            return NULL;
+
+        guid.Data1    = (unsigned long)d1;
+        guid.Data2    = (unsigned short)d2;
+        guid.Data3    = (unsigned short)d3;
+        guid.Data4[0] = (unsigned char)(d4 >>  8);
+        guid.Data4[1] = (unsigned char)(d4      );
+        for (int i = 0; i < 6; i++)
+            guid.Data4[2 + i] = (unsigned char)(d5 >> (40 - 8*i));
+        return p;
+    }
+
 
     ///
-    /// Base template class to support string formatting using `printf()` style templates
+    /// Parses GUID
+    ///
+    /// Accepts exactly `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` or `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX` form. All
+    /// characters are validated at once using SSSE3 when available.
+    ///
+    /// \param[in ] str   String with GUID
+    /// \param[out] guid  GUID to store the result to
+    ///
+    /// \returns Pointer to the end of parsed GUID within `str`; `NULL` if `str` does not start with a GUID.
+    ///
+    WINSTD_API _Success_(return != NULL) const char *guid_parse(_In_z_ const char *str, _Out_ GUID &guid);
+
+    ///
+    /// Parses GUID
+    ///
+    /// Accepts exactly `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` or `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX` form. All
+    /// characters are validated at once using SSSE3 when available.
+    ///
+    /// \param[in ] str   String with GUID
+    /// \param[out] guid  GUID to store the result to
+    ///
+    /// \returns Pointer to the end of parsed GUID within `str`; `NULL` if `str` does not start with a GUID.
+    ///
+    WINSTD_API _Success_(return != NULL) const wchar_t *guid_parse(_In_z_ const wchar_t *str, _Out_ GUID &guid);
+
+
+    ///
+    /// Base template class to support converting GUID to string
     ///
     template<class _Elem, class _Traits, class _Ax>
-    class basic_string_printf : public std::basic_string<_Elem, _Traits, _Ax>
+    class basic_string_guid : public std::basic_string<_Elem, _Traits, _Ax>
     {
     public:
         /// \name Initializing string using template in memory
         /// @{
 
         ///
-        /// Initializes a new string and formats its contents using `printf()` style template.
+        /// Initializes a new string and formats its contents to `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` representation of given GUID.
         ///
-        /// \param[in] format  String template using `printf()` style
+        /// \param[in] guid  GUID to convert
         ///
-        inline basic_string_printf(_In_z_ _Printf_format_string_ const _Elem *format, ...)
+        inline basic_string_guid(_In_ const GUID &guid)
         {
-            va_list arg;
-            va_start(arg, format);
-            vsprintf(*this, format, arg);
-            va_end(arg);
+            guid_format(*this, guid);
+        }
+
+        ///
+        /// Initializes a new string and formats its contents to string representation of given GUID.
+        ///
+        /// \param[in] guid    GUID to convert
+        /// \param[in] format  A `printf()` syntax template to convert GUID to string (i.e. `"{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}"`)
+        ///
+        inline basic_string_guid(_In_ const GUID &guid, _In_z_ _Printf_format_string_ const _Elem *format)
+        {
+            sprintf<_Elem, _Traits, _Ax>(*this, format,
+                guid.Data1,
+                guid.Data2,
+                guid.Data3,
+                guid.Data4[0], guid.Data4[1],
+                guid.Data4[2], guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
         }
 
         /// @}
+    };
 
-        /// \name Initializing string using template in resources
+
+    ///
+    /// Single-byte character implementation of a class to support converting GUID to string
+    ///
+    class WINSTD_API string_guid : public basic_string_guid<char, std::char_traits<char>, std::allocator<char> >
+    {
+    public:
+        /// \name Initializing string using template in memory
         /// @{
 
         ///
-        /// Initializes a new string and formats its contents using `printf()` style template in resources.
+        /// Initializes a new string and formats its contents to string representation of given GUID.
         ///
-        /// \param[in] hInstance  Resource module handle
-        /// \param[in] nFormatID  Resource ID of the string template using `printf()` style
+        /// \param[in] guid  GUID to convert
         ///
-        inline basic_string_printf(_In_ HINSTANCE hInstance, _In_ UINT nFormatID, ...)
+        inline string_guid(_In_ const GUID &guid) :
+            basic_string_guid<char, std::char_traits<char>, std::allocator<char> >(guid)
         {
-            _Myt format;
-            ATLENSURE(format.LoadString(hInstance, nFormatID));
-
-            va_list arg;
-            va_start(arg, nFormatID);
-            vsprintf(*this, format, arg);
-            va_end(arg);
         }
 
+        /// @}
+    };
+
+
+    ///
+    /// Wide character implementation of a class to support converting GUID to string
+    ///
+    class WINSTD_API wstring_guid : public basic_string_guid<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> >
+    {
+    public:
+        /// \name Initializing string using template in memory
+        /// @{
+
         ///
-        /// Initializes a new string and formats its contents using `printf()` style template in resources.
+        /// Initializes a new string and formats its contents to string representation of given GUID.
         ///
-        /// \param[in] hInstance    Resource module handle
-        /// \param[in] wLanguageID  Resource language
-        /// \param[in] nFormatID    Resource ID of the string template using `printf()` style
+        /// \param[in] guid  GUID to convert
         ///
-        inline basic_string_printf(_In_ HINSTANCE hInstance, _In_ WORD wLanguageID, _In_ UINT nFormatID, ...)
+        inline wstring_guid(_In_ const GUID &guid) :
+            basic_string_guid<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> >(guid)
         {
-            _Myt format;
-            ATLENSURE(format.LoadString(hInstance, nFormatID, wLanguageID));
-
-            va_list arg;
-            va_start(arg, nFormatID);
-            vsprintf(*this, format, arg);
-            va_end(arg);
         }
 
-        /// }@
+        /// @}
     };
 
+    /// @}
+
+    /// \addtogroup WinStdMemSanitize
+    /// @{
 
     ///
-    /// Base template class to support string formatting using `FormatMessage()` style templates
+    /// Statistics of secure memory pool
     ///
-    template<class _Elem, class _Traits, class _Ax>
-    class basic_string_msg : public std::basic_string<_Elem, _Traits, _Ax>
+    /// The counters may be sampled at any time.
+    ///
+    struct secure_pool_stats
+    {
+        std::atomic<unsigned long long> live_bytes;     ///< Size of memory currently allocated (in bytes)
+        std::atomic<unsigned long long> peak_bytes;     ///< Maximum `live_bytes` ever reached (in bytes)
+        std::atomic<unsigned long long> locked_bytes;   ///< Size of memory locked (in bytes)
+        std::atomic<unsigned long long> wipes;          ///< Number of memory blocks sanitized
+        std::atomic<unsigned long long> heap_fallbacks; ///< Number of allocations served from heap
+    };
+
+
+    ///
+    /// Pool of locked memory for security sensitive data
+    ///
+    /// Blocks of up to `max_block_size` bytes are served from per-size-class free lists of slabs locked in physical
+    /// memory, so they never get written to the page file. Larger blocks are locked individually. Each free list has
+    /// its own lock; the list of regions is locked exclusively only when regions are added or removed. When the memory
+    /// cannot be locked or `WINSTD_SECURE_POOL_MAX_BYTES` would be exceeded, blocks are served from heap. All blocks
+    /// are zero-initialized, and sanitized on deallocation.
+    ///
+    /// On Windows 10 and later, locked memory is also excluded from Windows Error Reporting dumps. Dumps written by
+    /// other means (e.g. `MiniDumpWriteDump()` or a debugger), and blocks served from heap are not covered.
+    ///
+    /// \note
+    /// Memory must be deallocated in the same module it was allocated in.
+    ///
+    class secure_pool
     {
+        WINSTD_NONCOPYABLE(secure_pool)
+        WINSTD_NONMOVABLE(secure_pool)
+
     public:
-        /// \name Initializing string using template in memory
-        /// @{
+        static const size_t min_block_size = 16;        ///< Size of the smallest size class in bytes
+        static const size_t max_block_size = 4096;      ///< Size of the largest size class in bytes
+        static const size_t size_classes   = 9;         ///< Number of size classes
+        static const size_t slab_size      = 0x10000;   ///< Size of the memory locked at once for a size class in bytes
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style template.
+        /// Constructs an empty pool
         ///
-        /// \param[in] format  String template using `FormatMessage()` style
+        /// \param[in] max_locked  Maximum size of memory locked in bytes
         ///
-        inline basic_string_msg(_In_z_ _FormatMessage_format_string_ const _Elem *format, ...)
+        inline secure_pool(_In_ size_t max_locked = WINSTD_SECURE_POOL_MAX_BYTES) : m_max_locked(max_locked)
         {
-            va_list arg;
-            va_start(arg, format);
-            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
-            va_end(arg);
+            InitializeSRWLock(&m_regions_lock);
+            for (size_t i = 0; i < _countof(m_free); i++) {
+                InitializeSRWLock(&m_free[i].lock);
+                m_free[i].head = NULL;
+            }
+            m_stats.live_bytes     = 0;
+            m_stats.peak_bytes     = 0;
+            m_stats.locked_bytes   = 0;
+            m_stats.wipes          = 0;
+            m_stats.heap_fallbacks = 0;
         }
 
-        /// @}
+        ///
+        /// Sanitizes and releases all locked memory
+        ///
+        inline ~secure_pool()
+        {
+            for (auto r = m_regions.cbegin(), r_end = m_regions.cend(); r != r_end; ++r) {
+                SecureZeroMemory(r->data, r->size);
+                free_region(*r);
+            }
+        }
 
-        /// \name Initializing string using template in resources
-        /// @{
+        ///
+        /// Returns process-wide pool
+        ///
+        /// The pool is never destroyed, so blocks may be deallocated by static destructors safely.
+        ///
+        static inline secure_pool& instance()
+        {
+            static secure_pool *pool = new secure_pool;
+            return *pool;
+        }
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style template in resources.
+        /// Allocates zero-initialized memory block
         ///
-        /// \param[in] hInstance  Resource module handle
-        /// \param[in] nFormatID  Resource ID of the string template using `FormatMessage()` style
+        /// \param[in] size  Size of the block in bytes
         ///
-        inline basic_string_msg(_In_ HINSTANCE hInstance, _In_ UINT nFormatID, ...)
+        /// \returns Pointer to the memory block suitably aligned for any fundamental type
+        ///
+        /// \throw std::bad_alloc  Out of memory
+        ///
+        inline void* allocate(_In_ size_t size)
         {
-            _Myt format(GetManager());
-            ATLENSURE(format.LoadString(hInstance, nFormatID));
+            void *ptr;
+            if (size <= max_block_size) {
+                free_list &f = m_free[size_class(size)];
+                lock l(f.lock);
+                if (f.head || refill(f, size_class(size))) {
+                    ptr = f.head;
+                    f.head = *reinterpret_cast<void**>(ptr);
+                    *reinterpret_cast<void**>(ptr) = NULL;
+                } else
+                    ptr = NULL;
+            } else
+                ptr = add_region(size, 0);
+            if (!ptr) {
+                ptr = ::operator new(size);
+                memset(ptr, 0, size);
+                m_stats.heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            unsigned long long live = m_stats.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+            unsigned long long peak = m_stats.peak_bytes.load(std::memory_order_relaxed);
+            while (live > peak && !m_stats.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+            return ptr;
+        }
+
+        ///
+        /// Sanitizes and deallocates memory block
+        ///
+        /// \param[in] ptr   Pointer to the memory block returned by `allocate()`
+        /// \param[in] size  Size of the block in bytes as passed to `allocate()`
+        ///
+        inline void deallocate(_In_ void *ptr, _In_ size_t size)
+        {
+            SecureZeroMemory(ptr, size);
+            m_stats.wipes.fetch_add(1, std::memory_order_relaxed);
+            m_stats.live_bytes.fetch_sub(size, std::memory_order_relaxed);
+
+            // Slabs are kept until the pool is destroyed. Their block size may be used after the lookup is unlocked.
+            size_t block_size;
+            {
+                shared_lock l(m_regions_lock);
+                auto r = find_region(ptr);
+                block_size = r != m_regions.end() ? r->block_size : (size_t)-1;
+            }
+            if (block_size == (size_t)-1)
+                ::operator delete(ptr);
+            else if (block_size) {
+                free_list &f = m_free[size_class(block_size)];
+                lock l(f.lock);
+                *reinterpret_cast<void**>(ptr) = f.head;
+                f.head = ptr;
+            } else {
+                lock l(m_regions_lock);
+                auto r = find_region(ptr);
+                free_region(*r);
+                m_stats.locked_bytes.fetch_sub(r->size, std::memory_order_relaxed);
+                m_regions.erase(r);
+            }
+        }
+
+        ///
+        /// Returns pool statistics
+        ///
+        inline const secure_pool_stats& stats() const
+        {
+            return m_stats;
+        }
+
+    protected:
+        /// \cond internal
+
+        ///
+        /// Locked memory region: a slab of a size class, or a single large block
+        ///
+        struct region
+        {
+            unsigned char *data;    ///< Region memory
+            size_t size;            ///< Size of the region in bytes
+            size_t block_size;      ///< Size of blocks in the slab in bytes, or 0 for a large block
+        };
+
+        ///
+        /// Free blocks of a size class
+        ///
+        struct free_list
+        {
+            SRWLOCK lock;                               ///< Lock guarding the list
+            void *head;                                 ///< First free block
+            char padding[WINSTD_CACHE_LINE_BYTES];      ///< Padding to keep locks of size classes on separate cache lines
+        };
+
+        ///
+        /// Exclusively locks SRW lock for the lifetime of the object
+        ///
+        class lock
+        {
+        public:
+            inline lock(_Inout_ SRWLOCK &l) : m_l(l) { AcquireSRWLockExclusive(&m_l); }
+            inline ~lock() { ReleaseSRWLockExclusive(&m_l); }
+        private:
+            SRWLOCK &m_l;
+        };
+
+        ///
+        /// Locks SRW lock in shared mode for the lifetime of the object
+        ///
+        class shared_lock
+        {
+        public:
+            inline shared_lock(_Inout_ SRWLOCK &l) : m_l(l) { AcquireSRWLockShared(&m_l); }
+            inline ~shared_lock() { ReleaseSRWLockShared(&m_l); }
+        private:
+            SRWLOCK &m_l;
+        };
+
+        ///
+        /// Returns index of the smallest size class fitting `size` bytes
+        ///
+        static inline size_t size_class(_In_ size_t size)
+        {
+            size_t c = 0;
+            for (size_t s = min_block_size; s < size; s <<= 1)
+                c++;
+            return c;
+        }
+
+        ///
+        /// Returns region containing `ptr`, or `m_regions.end()`
+        ///
+        /// \note Call with `m_regions_lock` locked.
+        ///
+        inline std::vector<region>::iterator find_region(_In_ const void *ptr)
+        {
+            auto r = std::upper_bound(m_regions.begin(), m_regions.end(), static_cast<const unsigned char*>(ptr),
+                [](_In_ const unsigned char *p, _In_ const region &r) { return p < r.data; });
+            if (r != m_regions.begin() && static_cast<const unsigned char*>(ptr) < (--r)->data + r->size)
+                return r;
+            return m_regions.end();
+        }
+
+        ///
+        /// Locks a region of at least `size` bytes
+        ///
+        /// \returns Pointer to the region, or NULL when memory cannot be locked
+        ///
+        inline unsigned char* add_region(_In_ size_t size, _In_ size_t block_size)
+        {
+            size = (size + 0xfff) & ~(size_t)0xfff;
+            lock l(m_regions_lock);
+            if (size > m_max_locked || m_stats.locked_bytes.load(std::memory_order_relaxed) > m_max_locked - size)
+                return NULL;
+            region r = { (unsigned char*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE), size, block_size };
+            if (!r.data)
+                return NULL;
+            if (!VirtualLock(r.data, r.size)) {
+                VirtualFree(r.data, 0, MEM_RELEASE);
+                return NULL;
+            }
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN10
+            // Best effort: WER accepts a limited number of excluded blocks per process.
+            WerRegisterExcludedMemoryBlock(r.data, (DWORD)std::min<size_t>(r.size, 0xffffffff));
+#endif
+            try {
+                m_regions.insert(std::upper_bound(m_regions.begin(), m_regions.end(), r.data,
+                    [](_In_ const unsigned char *p, _In_ const region &r) { return p < r.data; }), r);
+            } catch (...) {
+                free_region(r);
+                throw;
+            }
+            m_stats.locked_bytes.fetch_add(r.size, std::memory_order_relaxed);
+            return r.data;
+        }
+
+        ///
+        /// Releases memory of a region locked by `add_region()`
+        ///
+        static inline void free_region(_In_ const region &r)
+        {
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN10
+            WerUnregisterExcludedMemoryBlock(r.data);
+#endif
+            VirtualUnlock(r.data, r.size);
+            VirtualFree(r.data, 0, MEM_RELEASE);
+        }
+
+        ///
+        /// Adds a slab to the free list `f` of size class `c`
+        ///
+        /// \returns `true` on success
+        ///
+        /// \note Call with `f.lock` locked.
+        ///
+        inline bool refill(_Inout_ free_list &f, _In_ size_t c)
+        {
+            size_t block_size = min_block_size << c;
+            unsigned char *data = add_region(slab_size, block_size);
+            if (!data)
+                return false;
+            for (size_t offset = slab_size; offset; ) {
+                offset -= block_size;
+                *reinterpret_cast<void**>(data + offset) = f.head;
+                f.head = data + offset;
+            }
+            return true;
+        }
+
+        /// \endcond
+
+    protected:
+        size_t m_max_locked;            ///< Maximum size of memory locked in bytes
+        free_list m_free[size_classes]; ///< Free lists per size class (`min_block_size` to `max_block_size`)
+        SRWLOCK m_regions_lock;         ///< Lock guarding regions. Locked after a free list lock, never before.
+        std::vector<region> m_regions;  ///< Locked regions sorted by address
+        secure_pool_stats m_stats;      ///< Statistics
+    };
+
+
+    // winstd::sanitizing_allocator::destroy() member generates _Ptr parameter not used warning for primitive datatypes _Ty.
+    #pragma warning(push)
+    #pragma warning(disable: 4100)
+
+    ///
+    /// An allocator template that sanitizes each memory block before it is destroyed or reallocated
+    ///
+    /// When `WINSTD_SECURE_POOL` is set to 1, memory is allocated from `secure_pool`.
+    ///
+    /// \note
+    /// `sanitizing_allocator` introduces a performance penalty. However, it provides an additional level of security.
+    /// Use for security sensitive data memory storage only.
+    ///
+    template<class _Ty>
+    class sanitizing_allocator : public std::allocator<_Ty>
+    {
+    public:
+        typedef std::allocator<_Ty> _Mybase; ///< Base type
+
+        ///
+        /// Convert this type to sanitizing_allocator<_Other>
+        ///
+        template<class _Other>
+        struct rebind
+        {
+            typedef sanitizing_allocator<_Other> other; ///< Other type
+        };
 
-            va_list arg;
-            va_start(arg, nFormatID);
-            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
-            va_end(arg);
-        }
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style template in resources.
-        ///
-        /// \param[in] hInstance    Resource module handle
-        /// \param[in] wLanguageID  Resource language
-        /// \param[in] nFormatID    Resource ID of the string template using `FormatMessage()` style
+        /// Construct default allocator
         ///
-        inline basic_string_msg(_In_ HINSTANCE hInstance, _In_ WORD wLanguageID, _In_ UINT nFormatID, ...)
+        inline sanitizing_allocator() : _Mybase()
         {
-            _Myt format(GetManager());
-            ATLENSURE(format.LoadString(hInstance, nFormatID, wLanguageID));
-
-            va_list arg;
-            va_start(arg, nFormatID);
-            FormatMessage(FORMAT_MESSAGE_FROM_STRING, format, 0, 0, *this, &arg);
-            va_end(arg);
         }
 
-        /// @}
-
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style.
-        ///
-        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        /// Construct by copying
         ///
-        inline basic_string_msg(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _In_opt_ va_list *Arguments)
+        inline sanitizing_allocator(_In_ const sanitizing_allocator<_Ty> &_Othr) : _Mybase(_Othr)
         {
-            FormatMessage(dwFlags & ~FORMAT_MESSAGE_ARGUMENT_ARRAY, lpSource, dwMessageId, dwLanguageId, *this, Arguments);
         }
 
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style.
-        ///
-        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        /// Construct from a related allocator
         ///
-        inline basic_string_msg(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _In_opt_ DWORD_PTR *Arguments)
+        template<class _Other>
+        inline sanitizing_allocator(_In_ const sanitizing_allocator<_Other> &_Othr) : _Mybase(_Othr)
         {
-            FormatMessage(dwFlags | FORMAT_MESSAGE_ARGUMENT_ARRAY, lpSource, dwMessageId, dwLanguageId, *this, (va_list*)Arguments);
         }
 
 
+#if WINSTD_SECURE_POOL
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style.
-        ///
-        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        /// Allocate array of _Count elements from `secure_pool`
         ///
-        inline basic_string_msg(_In_ DWORD dwFlags, _In_z_ LPCTSTR pszFormat, _In_opt_ va_list *Arguments)
+        inline typename _Mybase::pointer allocate(_In_ typename _Mybase::size_type _Count)
         {
-            FormatMessage(dwFlags & ~FORMAT_MESSAGE_ARGUMENT_ARRAY | FORMAT_MESSAGE_FROM_STRING, pszFormat, 0, 0, *this, Arguments);
+            if (_Count > (size_t)-1 / sizeof(_Ty))
+                throw std::bad_alloc();
+            return static_cast<typename _Mybase::pointer>(secure_pool::instance().allocate(_Count * sizeof(_Ty)));
         }
+#endif
 
 
         ///
-        /// Initializes a new string and formats its contents using `FormatMessage()` style.
-        ///
-        /// \sa [FormatMessage function](https://msdn.microsoft.com/en-us/library/windows/desktop/ms679351.aspx)
+        /// Deallocate object at _Ptr sanitizing its content first
         ///
-        inline basic_string_msg(_In_ DWORD dwFlags, _In_z_ LPCTSTR pszFormat, _In_opt_ DWORD_PTR *Arguments)
+        inline void deallocate(_In_ typename _Mybase::pointer _Ptr, _In_ typename _Mybase::size_type _Size)
         {
-            FormatMessage(dwFlags | FORMAT_MESSAGE_ARGUMENT_ARRAY | FORMAT_MESSAGE_FROM_STRING, pszFormat, 0, 0, *this, (va_list*)Arguments);
+#if WINSTD_SECURE_POOL
+            secure_pool::instance().deallocate(_Ptr, _Size * sizeof(_Ty));
+#else
+            // Sanitize then free.
+            SecureZeroMemory(_Ptr, _Size * sizeof(_Ty));
+            _Mybase::deallocate(_Ptr, _Size);
+#endif
         }
     };
 
+    #pragma warning(pop)
 
     ///
-    /// Base template class to support converting GUID to string
+    /// Sanitizing BLOB
     ///
-    template<class _Elem, class _Traits, class _Ax>
-    class basic_string_guid : public std::basic_string<_Elem, _Traits, _Ax>
+    /// When `WINSTD_SECURE_POOL` is set to 1, data is allocated from `secure_pool`.
+    ///
+    template<size_t N>
+    class __declspec(novtable) sanitizing_blob
     {
     public:
-        /// \name Initializing string using template in memory
-        /// @{
-
+#if WINSTD_SECURE_POOL
         ///
-        /// Initializes a new string and formats its contents to string representation of given GUID.
+        /// Constructs zero-initialized BLOB
         ///
-        /// \param[in] guid    GUID to convert
-        /// \param[in] format  A `printf()` syntax template to convert GUID to string (i.e. `"{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}"`)
+        inline sanitizing_blob() : m_data(*static_cast<unsigned char(*)[N]>(secure_pool::instance().allocate(N)))
+        {
+        }
+
         ///
-        inline basic_string_guid(_In_ const GUID &guid, _In_z_ _Printf_format_string_ const _Elem *format)
+        /// Copies BLOB
+        ///
+        inline sanitizing_blob(_In_ const sanitizing_blob<N> &other) : m_data(*static_cast<unsigned char(*)[N]>(secure_pool::instance().allocate(N)))
         {
-            sprintf<_Elem, _Traits, _Ax>(*this, format,
-                guid.Data1,
-                guid.Data2,
-                guid.Data3,
-                guid.Data4[0], guid.Data4[1],
-                guid.Data4[2], guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+            memcpy(m_data, other.m_data, N);
         }
 
-        /// @}
-    };
+        ///
+        /// Copies BLOB
+        ///
+        inline sanitizing_blob<N>& operator=(_In_ const sanitizing_blob<N> &other)
+        {
+            if (this != std::addressof(other))
+                memcpy(m_data, other.m_data, N);
+            return *this;
+        }
 
+        ///
+        /// Sanitizes BLOB
+        ///
+        inline ~sanitizing_blob()
+        {
+            secure_pool::instance().deallocate(m_data, N);
+        }
 
-    ///
-    /// Single-byte character implementation of a class to support converting GUID to string
-    ///
-    class WINSTD_API string_guid : public basic_string_guid<char, std::char_traits<char>, std::allocator<char> >
-    {
     public:
-        /// \name Initializing string using template in memory
-        /// @{
-
+        unsigned char (&m_data)[N]; ///< BLOB data
+#else
         ///
-        /// Initializes a new string and formats its contents to string representation of given GUID.
+        /// Constructs uninitialized BLOB
         ///
-        /// \param[in] guid  GUID to convert
+        inline sanitizing_blob()
+        {
+            ZeroMemory(m_data, N);
+        }
+
         ///
-        inline string_guid(_In_ const GUID &guid) :
-            basic_string_guid<char, std::char_traits<char>, std::allocator<char> >(guid, "{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}")
+        /// Sanitizes BLOB
+        ///
+        inline ~sanitizing_blob()
         {
+            SecureZeroMemory(m_data, N);
         }
 
-        /// @}
+    public:
+        unsigned char m_data[N];    ///< BLOB data
+#endif
     };
 
 
     ///
-    /// Wide character implementation of a class to support converting GUID to string
+    /// Arena of locked memory for security sensitive data
     ///
-    class WINSTD_API wstring_guid : public basic_string_guid<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> >
+    /// Memory is allocated sequentially from chunks locked in physical memory, so it never gets written to the
+    /// page file. Deallocating individual blocks is a no-op: all memory allocated is sanitized at once on `reset()`
+    /// or destruction. Optional guard pages following each chunk turn buffer overruns into access violations.
+    ///
+    /// \note
+    /// `sanitizing_arena` is not thread-safe. Use one arena per thread or operation.
+    ///
+    class sanitizing_arena
     {
+        WINSTD_NONCOPYABLE(sanitizing_arena)
+        WINSTD_NONMOVABLE(sanitizing_arena)
+
     public:
-        /// \name Initializing string using template in memory
-        /// @{
+        ///
+        /// Constructs an empty arena
+        ///
+        /// \param[in] chunk_size   Minimum size of the memory chunk in bytes
+        /// \param[in] guard_pages  Follow each chunk with an inaccessible page
+        ///
+        inline sanitizing_arena(_In_ size_t chunk_size = WINSTD_SANITIZING_ARENA_CHUNK_BYTES, _In_ bool guard_pages = false) :
+            m_chunk_size(chunk_size),
+            m_guard_pages(guard_pages),
+            m_current(0)
+        {
+            SYSTEM_INFO si;
+            GetSystemInfo(&si);
+            m_page_size = si.dwPageSize;
+        }
 
         ///
-        /// Initializes a new string and formats its contents to string representation of given GUID.
+        /// Sanitizes and releases all memory
         ///
-        /// \param[in] guid  GUID to convert
+        inline ~sanitizing_arena()
+        {
+            reset();
+            for (auto c = m_chunks.cbegin(), c_end = m_chunks.cend(); c != c_end; ++c) {
+                VirtualUnlock(c->data, c->size);
+                VirtualFree(c->data, 0, MEM_RELEASE);
+            }
+        }
+
         ///
-        inline wstring_guid(_In_ const GUID &guid) :
-            basic_string_guid<wchar_t, std::char_traits<wchar_t>, std::allocator<wchar_t> >(guid, L"{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}")
+        /// Allocates memory block
+        ///
+        /// \param[in] size       Size of the block in bytes
+        /// \param[in] alignment  Alignment of the block in bytes. Must be a power of two.
+        ///
+        /// \returns Pointer to the memory block
+        ///
+        /// \throw std::bad_alloc     Out of memory
+        /// \throw win_runtime_error  Locking or protecting memory failed. Consider increasing process minimum working set size using `SetProcessWorkingSetSize()`.
+        ///
+        inline void* allocate(_In_ size_t size, _In_ size_t alignment = MEMORY_ALLOCATION_ALIGNMENT)
         {
+            assert(alignment && (alignment & (alignment - 1)) == 0);
+
+            for (; m_current < m_chunks.size(); m_current++) {
+                chunk &c = m_chunks[m_current];
+                size_t offset = c.used + (size_t)((0 - (uintptr_t)(c.data + c.used)) & (alignment - 1));
+                if (offset <= c.size && size <= c.size - offset) {
+                    c.used = offset + size;
+                    return c.data + offset;
+                }
+            }
+
+            // No room left. Add a chunk. Chunks are page-aligned. Alignment above the page size needs room to align the
+            // block within the chunk.
+            size_t slack = alignment > m_page_size ? alignment - m_page_size : 0;
+            if (size > (size_t)-1 - m_page_size * 2 - slack)
+                throw std::bad_alloc();
+            chunk c;
+            c.size = (std::max<size_t>(m_chunk_size, size + slack) + m_page_size - 1) & ~(m_page_size - 1);
+            c.data = (unsigned char*)VirtualAlloc(NULL, c.size + (m_guard_pages ? m_page_size : 0), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            if (!c.data)
+                throw std::bad_alloc();
+            size_t offset = (size_t)((0 - (uintptr_t)c.data) & (alignment - 1));
+            c.used = offset + size;
+            DWORD dwProtect;
+            if (m_guard_pages && !VirtualProtect(c.data + c.size, m_page_size, PAGE_NOACCESS, &dwProtect)) {
+                DWORD dwResult = GetLastError();
+                VirtualFree(c.data, 0, MEM_RELEASE);
+                throw win_runtime_error(dwResult, "VirtualProtect failed.");
+            }
+            if (!VirtualLock(c.data, c.size)) {
+                DWORD dwResult = GetLastError();
+                VirtualFree(c.data, 0, MEM_RELEASE);
+                throw win_runtime_error(dwResult, "VirtualLock failed.");
+            }
+            try {
+                m_chunks.push_back(c);
+            } catch (...) {
+                VirtualUnlock(c.data, c.size);
+                VirtualFree(c.data, 0, MEM_RELEASE);
+                throw;
+            }
+            m_current = m_chunks.size() - 1;
+            return c.data + offset;
         }
 
-        /// @}
-    };
+        ///
+        /// Sanitizes all memory allocated and makes it available for reuse
+        ///
+        /// Chunks are kept locked for subsequent allocations.
+        ///
+        /// \note
+        /// All memory blocks allocated from the arena become invalid.
+        ///
+        inline void reset()
+        {
+            for (auto c = m_chunks.begin(), c_end = m_chunks.end(); c != c_end; ++c) {
+                SecureZeroMemory(c->data, c->used);
+                c->used = 0;
+            }
+            m_current = 0;
+        }
 
-    /// @}
+        ///
+        /// Returns total size of memory allocated from the system in bytes
+        ///
+        inline size_t capacity() const
+        {
+            size_t size = 0;
+            for (auto c = m_chunks.cbegin(), c_end = m_chunks.cend(); c != c_end; ++c)
+                size += c->size;
+            return size;
+        }
 
-    /// \addtogroup WinStdMemSanitize
-    /// @{
+    protected:
+        /// \cond internal
+        struct chunk
+        {
+            unsigned char *data;    ///< Chunk memory
+            size_t size;            ///< Size of the chunk in bytes (excluding guard page)
+            size_t used;            ///< Bytes used since last reset
+        };
+        /// \endcond
+
+        size_t m_chunk_size;            ///< Minimum size of the chunk in bytes
+        bool m_guard_pages;             ///< Are chunks followed by guard pages?
+        size_t m_page_size;             ///< System page size in bytes
+        std::vector<chunk> m_chunks;    ///< Chunks
+        size_t m_current;               ///< Index of the chunk being allocated from
+    };
 
-    // winstd::sanitizing_allocator::destroy() member generates _Ptr parameter not used warning for primitive datatypes _Ty.
-    #pragma warning(push)
-    #pragma warning(disable: 4100)
 
     ///
-    /// An allocator template that sanitizes each memory block before it is destroyed or reallocated
+    /// An allocator template that allocates memory from `sanitizing_arena`
     ///
-    /// \note
-    /// `sanitizing_allocator` introduces a performance penalty. However, it provides an additional level of security.
-    /// Use for security sensitive data memory storage only.
+    /// Deallocation is a no-op. Memory is sanitized on `sanitizing_arena::reset()` or arena destruction, which must
+    /// not happen before all containers using the arena are destroyed.
     ///
     template<class _Ty>
-    class sanitizing_allocator : public std::allocator<_Ty>
+    class sanitizing_arena_allocator
     {
     public:
-        typedef std::allocator<_Ty> _Mybase; ///< Base type
+        typedef _Ty value_type;                     ///< Element type
+        typedef _Ty *pointer;                       ///< Pointer to element
+        typedef const _Ty *const_pointer;           ///< Constant pointer to element
+        typedef _Ty &reference;                     ///< Reference to element
+        typedef const _Ty &const_reference;         ///< Constant reference to element
+        typedef size_t size_type;                   ///< Size type
+        typedef ptrdiff_t difference_type;          ///< Difference type
 
         ///
-        /// Convert this type to sanitizing_allocator<_Other>
+        /// Convert this type to sanitizing_arena_allocator<_Other>
         ///
         template<class _Other>
         struct rebind
         {
-            typedef sanitizing_allocator<_Other> other; ///< Other type
+            typedef sanitizing_arena_allocator<_Other> other; ///< Other type
         };
 
 
         ///
-        /// Construct default allocator
+        /// Construct allocator
         ///
-        inline sanitizing_allocator() : _Mybase()
+        /// \param[in] arena  Arena to allocate memory from
+        ///
+        inline sanitizing_arena_allocator(_In_ sanitizing_arena &arena) : m_arena(&arena)
         {
         }
 
 
         ///
-        /// Construct by copying
+        /// Construct from a related allocator
         ///
-        inline sanitizing_allocator(_In_ const sanitizing_allocator<_Ty> &_Othr) : _Mybase(_Othr)
+        template<class _Other>
+        inline sanitizing_arena_allocator(_In_ const sanitizing_arena_allocator<_Other> &_Othr) : m_arena(&_Othr.arena())
         {
         }
 
 
         ///
-        /// Construct from a related allocator
+        /// Allocate array of _Count elements
         ///
-        template<class _Other>
-        inline sanitizing_allocator(_In_ const sanitizing_allocator<_Other> &_Othr) : _Mybase(_Othr)
+        inline pointer allocate(_In_ size_type _Count)
         {
+            if (_Count > (size_t)-1 / sizeof(_Ty))
+                throw std::bad_alloc();
+            return static_cast<pointer>(m_arena->allocate(_Count * sizeof(_Ty), alignof(_Ty)));
         }
 
 
         ///
-        /// Deallocate object at _Ptr sanitizing its content first
+        /// Deallocate object at _Ptr
+        ///
+        /// Memory is sanitized on arena reset.
         ///
         inline void deallocate(_In_ pointer _Ptr, _In_ size_type _Size)
         {
-            // Sanitize then free.
-            SecureZeroMemory(_Ptr, _Size);
-            _Mybase::deallocate(_Ptr, _Size);
+            UNREFERENCED_PARAMETER(_Ptr);
+            UNREFERENCED_PARAMETER(_Size);
         }
-    };
 
-    #pragma warning(pop)
 
-    ///
-    /// Sanitizing BLOB
-    ///
-    template<size_t N>
-    class __declspec(novtable) sanitizing_blob
-    {
-    public:
         ///
-        /// Constructs uninitialized BLOB
+        /// Returns arena
         ///
-        inline sanitizing_blob()
+        inline sanitizing_arena& arena() const
         {
-            ZeroMemory(m_data, N);
+            return *m_arena;
         }
 
+
         ///
-        /// Sanitizes BLOB
+        /// Are allocators using the same arena?
         ///
-        inline ~sanitizing_blob()
+        template<class _Other>
+        inline bool operator==(_In_ const sanitizing_arena_allocator<_Other> &_Othr) const
         {
-            SecureZeroMemory(m_data, N);
+            return m_arena == &_Othr.arena();
         }
 
-    public:
-        unsigned char m_data[N];    ///< BLOB data
+
+        ///
+        /// Are allocators using different arenas?
+        ///
+        template<class _Other>
+        inline bool operator!=(_In_ const sanitizing_arena_allocator<_Other> &_Othr) const
+        {
+            return m_arena != &_Othr.arena();
+        }
+
+    protected:
+        sanitizing_arena *m_arena; ///< Arena
     };
 
     /// @}
@@ -1980,7 +4599,7 @@ namespace winstd
 #pragma warning(disable: 4995)
 #pragma warning(disable: 4996)
 
-#if _MSC_VER <= 1600
+#if defined(_MSC_VER) && _MSC_VER <= 1600
 
 inline int vsnprintf(_Out_z_cap_(capacity) char *str, _In_ size_t capacity, _In_z_ _Printf_format_string_ const char *format, _In_ va_list arg)
 {
@@ -1996,28 +4615,88 @@ inline int vsnprintf(_Out_z_cap_(capacity) wchar_t *str, _In_ size_t capacity, _
 }
 
 
+inline int vscprintf(_In_z_ _Printf_format_string_ const char *format, _In_ va_list arg)
+{
+    return _vscprintf(format, arg);
+}
+
+
+inline int vscprintf(_In_z_ _Printf_format_string_ const wchar_t *format, _In_ va_list arg)
+{
+    return _vscwprintf(format, arg);
+}
+
+
 template<class _Elem, class _Traits, class _Ax>
 inline int vsprintf(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ _Printf_format_string_ const _Elem *format, _In_ va_list arg)
 {
-    _Elem buf[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];
-
-    // Try with stack buffer first.
-    int count = vsnprintf(buf, _countof(buf) - 1, format, arg);
-    if (count >= 0) {
-        // Copy from stack.
-        str.assign(buf, count);
+    // Integer conversions alone are frequent (error codes, sizes...). Format them without the CRT.
+    int count = winstd::vsprintf_int(str, format, arg);
+    if (count >= 0)
+        return count;
+
+    // The template or string arguments may point into str. Keep it intact until the result is complete then.
+    const std::less<const _Elem*> before;
+    const bool aliased =
+        (!before(format, str.data()) && before(format, str.data() + str.capacity())) ||
+        winstd::vsprintf_has_strings(format);
+
+    // On overflow, _vsnprintf() and _vsnwprintf() return -1, while C99 vsnprintf() returns the length required.
+    if (!aliased && str.size() >= WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)) {
+        // The string held a long result before. Expect a similar one and format directly into its storage.
+        size_t capacity = str.capacity();
+        str.resize(capacity);
+        count = winstd::vsnprintf_copy(&str[0], capacity, format, arg);
+        if (0 <= count && (size_t)count < capacity) {
+            str.resize(count);
+            return count;
+        }
     } else {
-        for (size_t capacity = 2*WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem);; capacity *= 2) {
-            // Allocate on heap and retry.
-            std::unique_ptr<_Elem[]> buf_dyn(new _Elem[capacity]);
-            count = vsnprintf(buf_dyn.get(), capacity - 1, format, arg);
-            if (count >= 0) {
-                str.assign(buf_dyn.get(), count);
-                break;
+        // Try with stack buffer first.
+        _Elem buf[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];
+        count = winstd::vsnprintf_copy(buf, _countof(buf), format, arg);
+        if (0 <= count && (size_t)count < _countof(buf)) {
+            // Copy from stack.
+            str.assign(buf, count);
+            return count;
+        }
+
+#if WINSTD_FORMAT_TLS_BUFFERS
+        // Try with thread's scratch buffer next.
+        std::vector<_Elem> &tls = winstd::get_format_buffer<_Elem>();
+        if ((count < 0 || (size_t)count < tls.size()) && tls.size() > _countof(buf)) {
+            count = winstd::vsnprintf_copy(tls.data(), tls.size(), format, arg);
+            if (0 <= count && (size_t)count < tls.size()) {
+                str.assign(tls.data(), count);
+                winstd::count_format_buffer_hit<_Elem>(count);
+                return count;
             }
         }
+        winstd::get_format_buffer_stats().misses.fetch_add(1, std::memory_order_relaxed);
+#endif
     }
 
+    // Query exact length.
+    if (count < 0 && (count = winstd::vsnprintf_copy((_Elem*)NULL, 0, format, arg)) < 0) {
+        str.clear();
+        return count;
+    }
+    if (aliased) {
+        // Format into new storage, and release the old one only after.
+        std::basic_string<_Elem, _Traits, _Ax> result(str.get_allocator());
+        result.resize(count);
+        winstd::vsnprintf_copy(&result[0], (size_t)count + 1, format, arg);
+        str.swap(result);
+    } else {
+        // Format directly into the string storage.
+        str.resize(count);
+        winstd::vsnprintf_copy(&str[0], (size_t)count + 1, format, arg);
+    }
+#if WINSTD_FORMAT_TLS_BUFFERS
+    // Grow thread's scratch buffer for the next result of similar length.
+    if ((size_t)count >= WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem))
+        winstd::grow_format_buffer(winstd::get_format_buffer<_Elem>(), count);
+#endif
     return count;
 }
 
@@ -2038,10 +4717,20 @@ inline int sprintf(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ _
 template<class _Traits, class _Ax>
 inline DWORD FormatMessage(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _Inout_ std::basic_string<char, _Traits, _Ax> &str, _In_opt_ va_list *Arguments)
 {
+#if WINSTD_FORMAT_TLS_BUFFERS
+    int count = winstd::FormatMessage_tls(FormatMessageA, dwFlags, lpSource, dwMessageId, dwLanguageId, str, Arguments);
+    if (count >= 0)
+        return (DWORD)count;
+#endif
+
     std::unique_ptr<CHAR[], winstd::LocalFree_delete<CHAR[]> > lpBuffer;
     DWORD dwResult = FormatMessageA(dwFlags | FORMAT_MESSAGE_ALLOCATE_BUFFER, lpSource, dwMessageId, dwLanguageId, reinterpret_cast<LPSTR>((LPSTR*)get_ptr(lpBuffer)), 0, Arguments);
-    if (dwResult)
+    if (dwResult) {
         str.assign(lpBuffer.get(), dwResult);
+#if WINSTD_FORMAT_TLS_BUFFERS
+        winstd::grow_format_buffer(winstd::get_format_buffer<char>(), dwResult);
+#endif
+    }
     return dwResult;
 }
 
@@ -2049,9 +4738,35 @@ inline DWORD FormatMessage(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ D
 template<class _Traits, class _Ax>
 inline DWORD FormatMessage(_In_ DWORD dwFlags, _In_opt_ LPCVOID lpSource, _In_ DWORD dwMessageId, _In_ DWORD dwLanguageId, _Inout_ std::basic_string<wchar_t, _Traits, _Ax> &str, _In_opt_ va_list *Arguments)
 {
+#if WINSTD_FORMAT_TLS_BUFFERS
+    int count = winstd::FormatMessage_tls(FormatMessageW, dwFlags, lpSource, dwMessageId, dwLanguageId, str, Arguments);
+    if (count >= 0)
+        return (DWORD)count;
+#endif
+
     std::unique_ptr<WCHAR[], winstd::LocalFree_delete<WCHAR[]> > lpBuffer;
     DWORD dwResult = FormatMessageW(dwFlags | FORMAT_MESSAGE_ALLOCATE_BUFFER, lpSource, dwMessageId, dwLanguageId, reinterpret_cast<LPWSTR>((LPWSTR*)get_ptr(lpBuffer)), 0, Arguments);
-    if (dwResult)
+    if (dwResult) {
         str.assign(lpBuffer.get(), dwResult);
+#if WINSTD_FORMAT_TLS_BUFFERS
+        winstd::grow_format_buffer(winstd::get_format_buffer<wchar_t>(), dwResult);
+#endif
+    }
     return dwResult;
 }
+
+
+namespace std
+{
+    ///
+    /// Hash function for `winstd::guid`
+    ///
+    template<>
+    struct hash<winstd::guid>
+    {
+        inline size_t operator()(_In_ const winstd::guid &g) const
+        {
+            return g.hash();
+        }
+    };
+}
@@ -0,0 +1,1059 @@
+﻿/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+///
+/// \defgroup WinStdFormat Type-safe Formatting
+/// Provides `printf()` style formatting with format strings checked against argument types at compile time
+///
+
+#include "Common.h"
+
+#include <limits.h>
+
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace winstd
+{
+    /// \cond internal
+    struct format_spec;
+    struct format_arg;
+    template <size_t N> struct format_ops;
+    template <class _Elem> class format_buffer_sink;
+    /// \endcond
+
+    /// \addtogroup WinStdFormat
+    /// @{
+
+    template <class _Elem> class basic_msg_format;
+
+    ///
+    /// Single-byte character message template using `FormatMessage()` insertion syntax
+    ///
+    typedef basic_msg_format<char> msg_format;
+
+    ///
+    /// Wide character message template using `FormatMessage()` insertion syntax
+    ///
+    typedef basic_msg_format<wchar_t> wmsg_format;
+
+    ///
+    /// Multi-byte / Wide-character message template (according to _UNICODE)
+    ///
+#ifdef _UNICODE
+    typedef wmsg_format tmsg_format;
+#else
+    typedef msg_format tmsg_format;
+#endif
+
+    /// @}
+}
+
+///
+/// Declares a format string for `winstd::format()` to parse and check against argument types at compile time
+///
+/// \param[in] s  String literal using `printf()` style: `"..."` or `L"..."`
+///
+#define WINSTD_FORMAT(s) \
+    ([]() { \
+        struct _Format_string { \
+            typedef std::remove_const<std::remove_reference<decltype((s)[0])>::type>::type elem_type; \
+            static constexpr const elem_type *c_str() { return s; } \
+        }; \
+        return _Format_string(); \
+    }())
+
+#pragma once
+
+
+namespace winstd
+{
+    /// \addtogroup WinStdFormat
+    /// @{
+
+    /// \cond internal
+
+    ///
+    /// Argument kinds
+    ///
+    enum format_arg_kind_t {
+        format_arg_none = 0,    ///< Unsupported type
+        format_arg_int,         ///< Signed integer
+        format_arg_uint,        ///< Unsigned integer
+        format_arg_float,       ///< Floating point number
+        format_arg_str,         ///< Single-byte string
+        format_arg_wstr,        ///< Wide string
+        format_arg_ptr,         ///< Pointer
+        format_arg_guid,        ///< GUID
+    };
+
+    ///
+    /// Maps argument type to its kind
+    ///
+    template <class T, class _Enable = void> struct format_arg_kind : std::integral_constant<int, format_arg_none> {};
+    template <class T> struct format_arg_kind<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type> : std::integral_constant<int, format_arg_int> {};
+    template <class T> struct format_arg_kind<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type> : std::integral_constant<int, format_arg_uint> {};
+    template <class T> struct format_arg_kind<T, typename std::enable_if<std::is_enum<T>::value>::type> : format_arg_kind<typename std::underlying_type<T>::type> {};
+    template <class T> struct format_arg_kind<T, typename std::enable_if<std::is_floating_point<T>::value>::type> : std::integral_constant<int, format_arg_float> {};
+    template <class T> struct format_arg_kind<T*, void> : std::integral_constant<int, format_arg_ptr> {};
+    template <> struct format_arg_kind<std::nullptr_t, void> : std::integral_constant<int, format_arg_ptr> {};
+    template <> struct format_arg_kind<char*, void> : std::integral_constant<int, format_arg_str> {};
+    template <> struct format_arg_kind<const char*, void> : std::integral_constant<int, format_arg_str> {};
+    template <> struct format_arg_kind<wchar_t*, void> : std::integral_constant<int, format_arg_wstr> {};
+    template <> struct format_arg_kind<const wchar_t*, void> : std::integral_constant<int, format_arg_wstr> {};
+    template <class _Traits, class _Ax> struct format_arg_kind<std::basic_string<char, _Traits, _Ax>, void> : std::integral_constant<int, format_arg_str> {};
+    template <class _Traits, class _Ax> struct format_arg_kind<std::basic_string<wchar_t, _Traits, _Ax>, void> : std::integral_constant<int, format_arg_wstr> {};
+    template <class T> struct format_arg_kind<T, typename std::enable_if<std::is_base_of<GUID, T>::value>::type> : std::integral_constant<int, format_arg_guid> {};
+
+    ///
+    /// Kinds of all arguments, terminated by `format_arg_none`
+    ///
+    template <class... _Args>
+    struct format_arg_kinds
+    {
+        static constexpr int value[sizeof...(_Args) + 1] = { format_arg_kind<typename std::decay<_Args>::type>::value..., format_arg_none };
+    };
+
+    template <class... _Args> constexpr int format_arg_kinds<_Args...>::value[sizeof...(_Args) + 1];
+
+    ///
+    /// Conversion specification: literal text followed by an optional `%` conversion
+    ///
+    struct format_spec
+    {
+        enum {
+            flag_left  = 0x01,  ///< `-`: Align left within the field width
+            flag_sign  = 0x02,  ///< `+`: Prefix positive numbers with a plus sign
+            flag_space = 0x04,  ///< ` `: Prefix positive numbers with a space
+            flag_alt   = 0x08,  ///< `#`: Prefix octal and hexadecimal numbers with `0` or `0x`
+            flag_zero  = 0x10,  ///< `0`: Pad numbers with zeros
+        };
+
+        enum {
+            none     = -1,      ///< Width or precision not specified
+            from_arg = -2,      ///< Width or precision taken from an argument (`*`)
+        };
+
+        size_t lit_start;       ///< Offset of literal text in format string
+        size_t lit_len;         ///< Length of literal text
+        unsigned char flags;    ///< Combination of `flag_*`
+        unsigned char size;     ///< Integer size in bytes from length modifier; 0 when none
+        char conv;              ///< Conversion character; 0 when literal text only
+        int width;              ///< Minimum field width, `none` or `from_arg`
+        int precision;          ///< Precision, `none` or `from_arg`
+
+        constexpr format_spec() :
+            lit_start(0),
+            lit_len(0),
+            flags(0),
+            size(0),
+            conv(0),
+            width(none),
+            precision(none)
+        {
+        }
+    };
+
+    ///
+    /// Parses literal text and the conversion following it
+    ///
+    /// \param[in ] fmt   Format string using `printf()` style
+    /// \param[in ] pos   Offset to start parsing at
+    /// \param[out] spec  Conversion specification
+    ///
+    /// \returns Offset to continue parsing at
+    ///
+    template <class _Elem>
+    constexpr size_t format_parse(_In_z_ const _Elem *fmt, _In_ size_t pos, _Out_ format_spec &spec)
+    {
+        spec = format_spec();
+        spec.lit_start = pos;
+        for (; fmt[pos] != '%'; pos++) {
+            if (!fmt[pos]) {
+                spec.lit_len = pos - spec.lit_start;
+                return pos;
+            }
+        }
+        if (fmt[pos + 1] == '%') {
+            // Escaped percent sign ends literal text.
+            spec.lit_len = pos + 1 - spec.lit_start;
+            return pos + 2;
+        }
+        spec.lit_len = pos++ - spec.lit_start;
+
+        for (;; pos++) {
+            if      (fmt[pos] == '-') spec.flags |= format_spec::flag_left;
+            else if (fmt[pos] == '+') spec.flags |= format_spec::flag_sign;
+            else if (fmt[pos] == ' ') spec.flags |= format_spec::flag_space;
+            else if (fmt[pos] == '#') spec.flags |= format_spec::flag_alt;
+            else if (fmt[pos] == '0') spec.flags |= format_spec::flag_zero;
+            else break;
+        }
+
+        if (fmt[pos] == '*') {
+            spec.width = format_spec::from_arg;
+            pos++;
+        } else if ('0' <= fmt[pos] && fmt[pos] <= '9') {
+            for (spec.width = 0; '0' <= fmt[pos] && fmt[pos] <= '9'; pos++) {
+                if (spec.width > (INT_MAX - 9) / 10) throw std::invalid_argument("Format width too large");
+                spec.width = spec.width * 10 + (fmt[pos] - '0');
+            }
+        }
+
+        if (fmt[pos] == '.') {
+            pos++;
+            if (fmt[pos] == '*') {
+                spec.precision = format_spec::from_arg;
+                pos++;
+            } else {
+                for (spec.precision = 0; '0' <= fmt[pos] && fmt[pos] <= '9'; pos++) {
+                    if (spec.precision > (INT_MAX - 9) / 10) throw std::invalid_argument("Format precision too large");
+                    spec.precision = spec.precision * 10 + (fmt[pos] - '0');
+                }
+            }
+        }
+
+        // Length modifiers only truncate integers, as argument types are known.
+        if (fmt[pos] == 'h') {
+            if (fmt[pos + 1] == 'h') { spec.size = 1; pos += 2; }
+            else                     { spec.size = 2; pos++;    }
+        } else if (fmt[pos] == 'l') {
+            if (fmt[pos + 1] == 'l') { spec.size = 8;            pos += 2; }
+            else                     { spec.size = sizeof(long); pos++;    }
+        } else if (fmt[pos] == 'I') {
+            if      (fmt[pos + 1] == '6' && fmt[pos + 2] == '4') { spec.size = 8;              pos += 3; }
+            else if (fmt[pos + 1] == '3' && fmt[pos + 2] == '2') { spec.size = 4;              pos += 3; }
+            else                                                 { spec.size = sizeof(size_t); pos++;    }
+        } else if (fmt[pos] == 'z' || fmt[pos] == 't') {
+            spec.size = sizeof(size_t);
+            pos++;
+        } else if (fmt[pos] == 'j') {
+            spec.size = 8;
+            pos++;
+        } else if (fmt[pos] == 'L' || fmt[pos] == 'w')
+            pos++;
+
+        switch (fmt[pos]) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        case 'c': case 'C': case 's': case 'S': case 'p':
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec.conv = (char)fmt[pos];
+            return pos + 1;
+        default:
+            throw std::invalid_argument("Invalid format conversion");
+        }
+    }
+
+    ///
+    /// Tests if the conversion accepts the argument kind
+    ///
+    constexpr bool format_accepts(_In_ char conv, _In_ int kind)
+    {
+        return
+            conv == 's' || conv == 'S' ? kind == format_arg_str || kind == format_arg_wstr || kind == format_arg_guid :
+            conv == 'p' ? kind == format_arg_ptr || kind == format_arg_str || kind == format_arg_wstr :
+            conv == 'e' || conv == 'E' || conv == 'f' || conv == 'F' || conv == 'g' || conv == 'G' || conv == 'a' || conv == 'A' ? kind == format_arg_float :
+            kind == format_arg_int || kind == format_arg_uint;
+    }
+
+    ///
+    /// Tests if the format string matches the argument kinds
+    ///
+    /// \param[in] fmt    Format string using `printf()` style
+    /// \param[in] kinds  Argument kinds
+    /// \param[in] count  Number of arguments
+    ///
+    template <class _Elem>
+    constexpr bool format_check(_In_z_ const _Elem *fmt, _In_count_(count) const int *kinds, _In_ size_t count)
+    {
+        size_t arg = 0;
+        for (size_t pos = 0; fmt[pos];) {
+            format_spec spec;
+            pos = format_parse(fmt, pos, spec);
+            if (!spec.conv)
+                continue;
+            if (spec.width == format_spec::from_arg) {
+                if (arg >= count || (kinds[arg] != format_arg_int && kinds[arg] != format_arg_uint)) return false;
+                arg++;
+            }
+            if (spec.precision == format_spec::from_arg) {
+                if (arg >= count || (kinds[arg] != format_arg_int && kinds[arg] != format_arg_uint)) return false;
+                arg++;
+            }
+            if (arg >= count || !format_accepts(spec.conv, kinds[arg])) return false;
+            arg++;
+        }
+        return arg == count;
+    }
+
+    ///
+    /// Counts conversion specifications in the format string
+    ///
+    template <class _Elem>
+    constexpr size_t format_count(_In_z_ const _Elem *fmt)
+    {
+        size_t count = 0;
+        for (size_t pos = 0; fmt[pos]; count++) {
+            format_spec spec;
+            pos = format_parse(fmt, pos, spec);
+        }
+        return count;
+    }
+
+    ///
+    /// Parsed format string
+    ///
+    template <size_t N>
+    struct format_ops
+    {
+        format_spec spec[N + 1];    ///< Conversion specifications
+
+        constexpr format_ops() : spec() {}
+    };
+
+    ///
+    /// Parses the format string
+    ///
+    /// \tparam N  Number of conversion specifications as returned by `format_count()`
+    ///
+    template <size_t N, class _Elem>
+    constexpr format_ops<N> format_compile(_In_z_ const _Elem *fmt)
+    {
+        format_ops<N> ops;
+        for (size_t pos = 0, i = 0; fmt[pos]; i++)
+            pos = format_parse(fmt, pos, ops.spec[i]);
+        return ops;
+    }
+
+    ///
+    /// Type-erased argument
+    ///
+    struct format_arg
+    {
+        int kind;                       ///< Argument kind
+        unsigned char size;             ///< Integer size in bytes after integral promotion
+        size_t len;                     ///< String length, or `(size_t)-1` when zero-terminated
+        union {
+            unsigned long long u;       ///< Integer value, sign-extended
+            double f;                   ///< Floating point value
+            const void *p;              ///< Pointer value
+            const char *s;              ///< Single-byte string
+            const wchar_t *ws;          ///< Wide string
+            const GUID *g;              ///< GUID
+        };
+
+        inline format_arg() : kind(format_arg_none), size(0), len(0), u(0) {}
+
+        template <class T> inline format_arg(_In_ const T &v) : size(0), len((size_t)-1) { init(v, std::integral_constant<int, format_arg_kind<T>::value>()); }
+        template <class T, size_t N> inline format_arg(_In_ const T (&v)[N]) : size(0), len((size_t)-1) { init(static_cast<const T*>(v), std::integral_constant<int, format_arg_kind<const T*>::value>()); }
+
+    protected:
+        template <class T> inline void init(_In_ const T &v, std::integral_constant<int, format_arg_int>)   { kind = format_arg_int;   u = (unsigned long long)static_cast<long long>(v);  size = sizeof(T) < sizeof(int) ? sizeof(int) : sizeof(T); }
+        template <class T> inline void init(_In_ const T &v, std::integral_constant<int, format_arg_uint>)  { kind = format_arg_uint;  u = static_cast<unsigned long long>(v);             size = sizeof(T) < sizeof(int) ? sizeof(int) : sizeof(T); }
+        template <class T> inline void init(_In_ const T &v, std::integral_constant<int, format_arg_float>) { kind = format_arg_float; f = static_cast<double>(v); }
+        template <class T> inline void init(_In_ const T &v, std::integral_constant<int, format_arg_ptr>)   { kind = format_arg_ptr;   p = v; size = sizeof(void*); }
+        inline void init(_In_opt_z_ const char *v, std::integral_constant<int, format_arg_str>)             { kind = format_arg_str;   s = v; }
+        inline void init(_In_opt_z_ const wchar_t *v, std::integral_constant<int, format_arg_wstr>)         { kind = format_arg_wstr;  ws = v; }
+        template <class _Traits, class _Ax> inline void init(_In_ const std::basic_string<char, _Traits, _Ax> &v, std::integral_constant<int, format_arg_str>)     { kind = format_arg_str;  s  = v.c_str(); len = v.size(); }
+        template <class _Traits, class _Ax> inline void init(_In_ const std::basic_string<wchar_t, _Traits, _Ax> &v, std::integral_constant<int, format_arg_wstr>) { kind = format_arg_wstr; ws = v.c_str(); len = v.size(); }
+        inline void init(_In_ const GUID &v, std::integral_constant<int, format_arg_guid>)                  { kind = format_arg_guid;  g = &v; }
+    };
+
+    ///
+    /// Output to a fixed-size buffer. Excess characters are counted, but not written.
+    ///
+    template <class _Elem>
+    class format_buffer_sink
+    {
+    public:
+        inline format_buffer_sink(_Out_writes_(capacity) _Elem *buf, _In_ size_t capacity) :
+            m_buf(buf),
+            m_capacity(capacity),
+            m_count(0)
+        {
+        }
+
+        inline void append(_In_count_(n) const _Elem *str, _In_ size_t n)
+        {
+            if (m_count < m_capacity)
+                std::char_traits<_Elem>::copy(m_buf + m_count, str, std::min<size_t>(n, m_capacity - m_count));
+            m_count += n;
+        }
+
+        inline void append(_In_ size_t n, _In_ _Elem c)
+        {
+            if (m_count < m_capacity)
+                std::char_traits<_Elem>::assign(m_buf + m_count, std::min<size_t>(n, m_capacity - m_count), c);
+            m_count += n;
+        }
+
+        ///
+        /// Zero-terminates the buffer, truncating when needed
+        ///
+        /// \returns Number of characters in complete result
+        ///
+        inline size_t finish()
+        {
+            if (m_capacity)
+                m_buf[std::min<size_t>(m_count, m_capacity - 1)] = 0;
+            return m_count;
+        }
+
+    protected:
+        _Elem *m_buf;           ///< Buffer
+        size_t m_capacity;      ///< Buffer size in characters
+        size_t m_count;         ///< Number of characters in result
+    };
+
+    ///
+    /// Appends field padded to width
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_field(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_count_(len) const _Elem *str, _In_ size_t len)
+    {
+        size_t pad = width > 0 && (size_t)width > len ? width - len : 0;
+        if (pad && !(flags & format_spec::flag_left)) out.append(pad, ' ');
+        out.append(str, len);
+        if (pad &&  (flags & format_spec::flag_left)) out.append(pad, ' ');
+    }
+
+    ///
+    /// Appends string converted to output character type
+    ///
+    template <class _Sink>
+    inline void format_convert(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_count_(len) const wchar_t *str, _In_ size_t len, char)
+    {
+        std::string tmp;
+        int n = ::WideCharToMultiByte(CP_ACP, 0, str, (int)len, NULL, 0, NULL, NULL);
+        if (n > 0) {
+            tmp.resize(n);
+            ::WideCharToMultiByte(CP_ACP, 0, str, (int)len, &tmp[0], n, NULL, NULL);
+        }
+        format_field(out, flags, width, tmp.c_str(), precision >= 0 ? std::min<size_t>(tmp.size(), precision) : tmp.size());
+    }
+
+    ///
+    /// Appends string converted to output character type
+    ///
+    template <class _Sink>
+    inline void format_convert(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_count_(len) const char *str, _In_ size_t len, wchar_t)
+    {
+        std::wstring tmp;
+        int n = ::MultiByteToWideChar(CP_ACP, 0, str, (int)len, NULL, 0);
+        if (n > 0) {
+            tmp.resize(n);
+            ::MultiByteToWideChar(CP_ACP, 0, str, (int)len, &tmp[0], n);
+        }
+        format_field(out, flags, width, tmp.c_str(), precision >= 0 ? std::min<size_t>(tmp.size(), precision) : tmp.size());
+    }
+
+    ///
+    /// Appends string of the output character type
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_convert(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_count_(len) const _Elem *str, _In_ size_t len, _Elem)
+    {
+        format_field(out, flags, width, str, precision >= 0 ? std::min<size_t>(len, precision) : len);
+    }
+
+    ///
+    /// Appends string
+    ///
+    template <class _Elem, class _Sink, class _Tchr>
+    inline void format_str(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_opt_z_ const _Tchr *str, _In_ size_t len)
+    {
+        static const _Tchr null[] = { '(', 'n', 'u', 'l', 'l', ')', 0 };
+        if (!str) {
+            str = null;
+            len = _countof(null) - 1;
+        }
+        if (len == (size_t)-1) {
+            // Do not read past precision: string need not be zero-terminated.
+            for (len = 0; (precision < 0 || len < (size_t)precision) && str[len]; len++);
+        }
+        format_convert(out, flags, width, precision, str, len, _Elem());
+    }
+
+    ///
+    /// Appends GUID in `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` form
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_guid(_Inout_ _Sink &out, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_ const GUID &guid)
+    {
+        _Elem buf[38];
+        guid_format(buf, guid);
+        format_field(out, flags, width, buf, precision >= 0 ? std::min<size_t>(_countof(buf), precision) : _countof(buf));
+    }
+
+    ///
+    /// Appends integer
+    ///
+    /// \param[inout] out        Output
+    /// \param[in   ] conv       Conversion character: `d`, `i`, `u`, `o`, `x` or `X`
+    /// \param[in   ] flags      Combination of `format_spec::flag_*`
+    /// \param[in   ] width      Minimum field width
+    /// \param[in   ] precision  Minimum number of digits, or negative when not specified
+    /// \param[in   ] size       Integer size in bytes
+    /// \param[in   ] value      Integer value
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_int(_Inout_ _Sink &out, _In_ char conv, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_ unsigned size, _In_ unsigned long long value)
+    {
+        // Reinterpret the value as printf() would: as signed or unsigned integer of given size.
+        unsigned bits = size * 8;
+        if (bits < 64) value &= (1ull << bits) - 1;
+        _Elem prefix[2];
+        size_t prefix_len = 0;
+        if (conv == 'd' || conv == 'i') {
+            if (bits < 64 && (value >> (bits - 1)) & 1) value |= ~0ull << bits;
+            if ((long long)value < 0) {
+                prefix[prefix_len++] = '-';
+                value = 0 - value;
+            } else if (flags & format_spec::flag_sign)
+                prefix[prefix_len++] = '+';
+            else if (flags & format_spec::flag_space)
+                prefix[prefix_len++] = ' ';
+        }
+
+        _Elem digits[24], *end = digits + _countof(digits), *p = end;
+        if (value || precision) {
+            if (conv == 'o') {
+                do { *--p = (_Elem)('0' + (value & 7)); } while (value >>= 3);
+                if ((flags & format_spec::flag_alt) && *p != '0')
+                    *--p = '0';
+            } else if (conv == 'x' || conv == 'X') {
+                if ((flags & format_spec::flag_alt) && value) {
+                    prefix[prefix_len++] = '0';
+                    prefix[prefix_len++] = conv;
+                }
+                p = hex_digits(end, value, conv == 'x');
+            } else
+                p = dec_digits(end, value);
+        } else if (conv == 'o' && (flags & format_spec::flag_alt))
+            *--p = '0';
+
+        size_t len = end - p;
+        size_t zeros = precision > 0 && (size_t)precision > len ? precision - len : 0;
+        size_t total = prefix_len + zeros + len;
+        size_t pad = width > 0 && (size_t)width > total ? width - total : 0;
+        if (pad && !(flags & format_spec::flag_left)) {
+            if ((flags & format_spec::flag_zero) && precision < 0) {
+                zeros += pad;
+                pad = 0;
+            } else
+                out.append(pad, ' ');
+        }
+        if (prefix_len) out.append(prefix, prefix_len);
+        if (zeros) out.append(zeros, '0');
+        out.append(p, len);
+        if (pad && (flags & format_spec::flag_left)) out.append(pad, ' ');
+    }
+
+    ///
+    /// Formats floating point number using CRT
+    ///
+    inline int format_float_crt(_Out_writes_z_(capacity) char *buf, _In_ size_t capacity, _In_z_ _Printf_format_string_ const char *fmt, ...)
+    {
+        va_list arg;
+        va_start(arg, fmt);
+        int count = vsnprintf(buf, capacity, fmt, arg);
+        va_end(arg);
+        return count;
+    }
+
+    ///
+    /// Appends floating point number
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_float(_Inout_ _Sink &out, _In_ char conv, _In_ unsigned flags, _In_ int width, _In_ int precision, _In_ double value)
+    {
+        char fmt[16], *f = fmt;
+        *f++ = '%';
+        if (flags & format_spec::flag_left ) *f++ = '-';
+        if (flags & format_spec::flag_sign ) *f++ = '+';
+        if (flags & format_spec::flag_space) *f++ = ' ';
+        if (flags & format_spec::flag_alt  ) *f++ = '#';
+        if (flags & format_spec::flag_zero ) *f++ = '0';
+        *f++ = '*';
+        if (precision >= 0) { *f++ = '.'; *f++ = '*'; }
+        *f++ = conv;
+        *f = 0;
+
+        char buf[WINSTD_STACK_BUFFER_BYTES];
+        std::vector<char> buf_dyn;
+        char *str = buf;
+        size_t capacity = _countof(buf);
+        for (;;) {
+            int count = precision >= 0 ?
+                format_float_crt(str, capacity, fmt, width, precision, value) :
+                format_float_crt(str, capacity, fmt, width, value);
+            if (0 <= count && (size_t)count < capacity) {
+                // Result is ASCII.
+                for (int i = 0; i < count; i++) {
+                    _Elem c = str[i];
+                    out.append(&c, 1);
+                }
+                return;
+            }
+            capacity = count >= 0 ? (size_t)count + 1 : capacity * 2;
+            buf_dyn.resize(capacity);
+            str = buf_dyn.data();
+        }
+    }
+
+    ///
+    /// Returns the next argument
+    ///
+    inline const format_arg& format_next_arg(_In_count_(count) const format_arg *args, _In_ size_t count, _Inout_ size_t &idx)
+    {
+        if (idx >= count) throw std::invalid_argument("Too few format arguments");
+        return args[idx++];
+    }
+
+    ///
+    /// Appends literal text and converted argument of a single conversion specification
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_one(_Inout_ _Sink &out, _In_z_ const _Elem *fmt, _In_ const format_spec &spec, _In_count_(count) const format_arg *args, _In_ size_t count, _Inout_ size_t &idx)
+    {
+        if (spec.lit_len)
+            out.append(fmt + spec.lit_start, spec.lit_len);
+        if (!spec.conv)
+            return;
+
+        unsigned flags = spec.flags;
+        int width = spec.width, precision = spec.precision;
+        if (width == format_spec::from_arg) {
+            const format_arg &a = format_next_arg(args, count, idx);
+            if (a.kind != format_arg_int && a.kind != format_arg_uint) throw std::invalid_argument("Format width must be integer");
+            width = (int)a.u;
+            if (width < 0) {
+                flags |= format_spec::flag_left;
+                width = -width;
+            }
+        }
+        if (precision == format_spec::from_arg) {
+            const format_arg &a = format_next_arg(args, count, idx);
+            if (a.kind != format_arg_int && a.kind != format_arg_uint) throw std::invalid_argument("Format precision must be integer");
+            precision = (int)a.u;
+            if (precision < 0)
+                precision = format_spec::none;
+        }
+
+        const format_arg &a = format_next_arg(args, count, idx);
+        if (!format_accepts(spec.conv, a.kind)) throw std::invalid_argument("Format argument type mismatch");
+        switch (spec.conv) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            format_int<_Elem>(out, spec.conv, flags, width, precision, spec.size && spec.size < a.size ? spec.size : a.size, a.u);
+            break;
+
+        case 'c': case 'C': {
+            _Elem c = (_Elem)a.u;
+            format_field(out, flags, width, &c, 1);
+            break;
+        }
+
+        case 's': case 'S':
+            if (a.kind == format_arg_str)
+                format_str<_Elem>(out, flags, width, precision, a.s, a.len);
+            else if (a.kind == format_arg_wstr)
+                format_str<_Elem>(out, flags, width, precision, a.ws, a.len);
+            else
+                format_guid<_Elem>(out, flags, width, precision, *a.g);
+            break;
+
+        case 'p':
+            // As MSVC does: uppercase hexadecimal zero-padded to pointer size.
+            format_int<_Elem>(out, 'X', flags, width, precision >= 0 ? precision : (int)(2*sizeof(void*)), sizeof(void*), (unsigned long long)(size_t)a.p);
+            break;
+
+        default:
+            format_float<_Elem>(out, spec.conv, flags, width, precision, a.f);
+        }
+    }
+
+    ///
+    /// Formats into output using a format string parsed at compile time
+    ///
+    template <class _Fmt, class _Sink>
+    inline void format_compiled(_Inout_ _Sink &out, _In_count_(count) const format_arg *args, _In_ size_t count)
+    {
+        static constexpr size_t n = format_count(_Fmt::c_str());
+        static constexpr format_ops<n> ops = format_compile<n>(_Fmt::c_str());
+        size_t idx = 0;
+        for (size_t i = 0; i < n; i++)
+            format_one(out, _Fmt::c_str(), ops.spec[i], args, count, idx);
+    }
+
+    ///
+    /// Formats into output using a format string parsed at run time
+    ///
+    template <class _Elem, class _Sink>
+    inline void format_runtime(_Inout_ _Sink &out, _In_z_ const _Elem *fmt, _In_count_(count) const format_arg *args, _In_ size_t count)
+    {
+        size_t idx = 0;
+        for (size_t pos = 0; fmt[pos];) {
+            format_spec spec;
+            pos = format_parse(fmt, pos, spec);
+            format_one(out, fmt, spec, args, count, idx);
+        }
+        if (idx != count) throw std::invalid_argument("Too many format arguments");
+    }
+
+    ///
+    /// Checks if the format string or any string argument points into the storage of `str`
+    ///
+    /// Such `str` must be kept intact until the result is complete.
+    ///
+    template <class _Elem, class _Traits, class _Ax>
+    inline bool format_aliases(_In_ const std::basic_string<_Elem, _Traits, _Ax> &str, _In_opt_ const void *fmt, _In_count_(count) const format_arg *args, _In_ size_t count)
+    {
+        const std::less<const void*> before;
+        const void *begin = str.data(), *end = str.data() + str.capacity();
+        if (fmt && !before(fmt, begin) && before(fmt, end))
+            return true;
+        for (size_t i = 0; i < count; i++) {
+            const void *p =
+                args[i].kind == format_arg_str  ? static_cast<const void*>(args[i].s) :
+                args[i].kind == format_arg_wstr ? static_cast<const void*>(args[i].ws) : NULL;
+            if (p && !before(p, begin) && before(p, end))
+                return true;
+        }
+        return false;
+    }
+
+    /// \endcond
+
+    ///
+    /// Formats string using `printf()` syntax and type-safe arguments
+    ///
+    /// Length modifiers (`h`, `l`, `ll`, `I64`...) are optional, as argument types are known. Strings of both character
+    /// types are accepted by `%s`, and GUIDs are formatted as `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` by `%s`.
+    ///
+    /// \param[out] str   Formatted string. Its capacity is reused.
+    /// \param[in ] fmt   Format string declared using `WINSTD_FORMAT()`. It is parsed and checked against argument types at compile time.
+    /// \param[in ] args  Arguments
+    ///
+    /// \returns Number of characters in result
+    ///
+    template <class _Fmt, class _Traits, class _Ax, class... _Args>
+    inline size_t format(_Inout_ std::basic_string<typename _Fmt::elem_type, _Traits, _Ax> &str, _In_ const _Fmt &fmt, _In_ const _Args&... args)
+    {
+        UNREFERENCED_PARAMETER(fmt);
+        static_assert(format_check(_Fmt::c_str(), format_arg_kinds<_Args...>::value, sizeof...(_Args)), "Format string does not match argument types");
+        const format_arg a[] = { format_arg(args)..., format_arg() };
+        if (format_aliases(str, NULL, a, sizeof...(_Args))) {
+            std::basic_string<typename _Fmt::elem_type, _Traits, _Ax> result(str.get_allocator());
+            format_compiled<_Fmt>(result, a, sizeof...(_Args));
+            str.swap(result);
+        } else {
+            str.clear();
+            format_compiled<_Fmt>(str, a, sizeof...(_Args));
+        }
+        return str.size();
+    }
+
+    ///
+    /// Formats string using `printf()` syntax and type-safe arguments
+    ///
+    /// \param[out] str   Formatted string. Its capacity is reused.
+    /// \param[in ] fmt   Format string using `printf()` style. It is parsed at run time.
+    /// \param[in ] args  Arguments
+    ///
+    /// \returns Number of characters in result
+    ///
+    /// \throw std::invalid_argument  Invalid format string, or format string does not match arguments
+    ///
+    template <class _Elem, class _Traits, class _Ax, class... _Args>
+    inline size_t format(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ _Printf_format_string_ const _Elem *fmt, _In_ const _Args&... args)
+    {
+        const format_arg a[] = { format_arg(args)..., format_arg() };
+        if (format_aliases(str, fmt, a, sizeof...(_Args))) {
+            std::basic_string<_Elem, _Traits, _Ax> result(str.get_allocator());
+            format_runtime(result, fmt, a, sizeof...(_Args));
+            str.swap(result);
+        } else {
+            str.clear();
+            format_runtime(str, fmt, a, sizeof...(_Args));
+        }
+        return str.size();
+    }
+
+    ///
+    /// Formats string into buffer using `printf()` syntax and type-safe arguments
+    ///
+    /// \param[out] buf       Buffer to receive zero-terminated result. It is truncated when too small.
+    /// \param[in ] capacity  Size of `buf` in characters
+    /// \param[in ] fmt       Format string declared using `WINSTD_FORMAT()`. It is parsed and checked against argument types at compile time.
+    /// \param[in ] args      Arguments
+    ///
+    /// \returns Number of characters in complete result, not including zero terminator
+    ///
+    template <class _Fmt, class... _Args>
+    inline size_t format(_Out_writes_z_(capacity) typename _Fmt::elem_type *buf, _In_ size_t capacity, _In_ const _Fmt &fmt, _In_ const _Args&... args)
+    {
+        UNREFERENCED_PARAMETER(fmt);
+        static_assert(format_check(_Fmt::c_str(), format_arg_kinds<_Args...>::value, sizeof...(_Args)), "Format string does not match argument types");
+        const format_arg a[] = { format_arg(args)..., format_arg() };
+        format_buffer_sink<typename _Fmt::elem_type> out(buf, capacity);
+        format_compiled<_Fmt>(out, a, sizeof...(_Args));
+        return out.finish();
+    }
+
+    ///
+    /// Formats string into buffer using `printf()` syntax and type-safe arguments
+    ///
+    /// \param[out] buf       Buffer to receive zero-terminated result. It is truncated when too small.
+    /// \param[in ] capacity  Size of `buf` in characters
+    /// \param[in ] fmt       Format string using `printf()` style. It is parsed at run time.
+    /// \param[in ] args      Arguments
+    ///
+    /// \returns Number of characters in complete result, not including zero terminator
+    ///
+    /// \throw std::invalid_argument  Invalid format string, or format string does not match arguments
+    ///
+    template <class _Elem, class... _Args>
+    inline size_t format(_Out_writes_z_(capacity) _Elem *buf, _In_ size_t capacity, _In_z_ _Printf_format_string_ const _Elem *fmt, _In_ const _Args&... args)
+    {
+        const format_arg a[] = { format_arg(args)..., format_arg() };
+        format_buffer_sink<_Elem> out(buf, capacity);
+        format_runtime(out, fmt, a, sizeof...(_Args));
+        return out.finish();
+    }
+
+
+    ///
+    /// Message template using `FormatMessage()` insertion syntax
+    ///
+    /// The template is parsed once on construction. Formatting walks the parsed operations only. Keep the instance
+    /// (i.e. `static const`) to format the same message repeatedly.
+    ///
+    /// Supported syntax is that of `FORMAT_MESSAGE_FROM_STRING` without line width limit:
+    /// - `%1` to `%99`: insertion of the argument. Its `printf()` conversion may follow in exclamation marks: `%1!08X!`.
+    ///   Without one, the argument is formatted according to its type: strings, GUIDs and pointers as with `%s` and
+    ///   `%p`, integers as with `%d` or `%u`, and floating point numbers as with `%g`. `*` width and precision consume
+    ///   the insertion's and the following arguments, as `FormatMessage()` does.
+    /// - `%0`: terminates the message
+    /// - `%n`: hard line break (`\r\n`); `%r`: carriage return; `%t`: tab; `%b` and `% `: space
+    /// - `%%`, `%.` and `%!`: literal `%`, `.` and `!`
+    ///
+    template <class _Elem>
+    class basic_msg_format
+    {
+    public:
+        ///
+        /// Parses message template
+        ///
+        /// \param[in] fmt  Message template using `FormatMessage()` insertion syntax
+        ///
+        /// \throw std::invalid_argument  Invalid insertion
+        ///
+        inline basic_msg_format(_In_z_ _FormatMessage_format_string_ const _Elem *fmt)
+        {
+            parse(fmt);
+        }
+
+        ///
+        /// Parses message template
+        ///
+        /// \param[in] fmt  Message template using `FormatMessage()` insertion syntax
+        ///
+        /// \throw std::invalid_argument  Invalid insertion
+        ///
+        template<class _Traits, class _Ax>
+        inline basic_msg_format(_In_ const std::basic_string<_Elem, _Traits, _Ax> &fmt)
+        {
+            parse(fmt.c_str());
+        }
+
+        ///
+        /// Appends formatted message to output
+        ///
+        /// \param[inout] out    Output: `std::basic_string<_Elem>` or another class providing the same `append()` methods
+        /// \param[in   ] args   Arguments
+        /// \param[in   ] count  Number of arguments
+        ///
+        /// \throw std::invalid_argument  Message refers to an argument not provided, or conversion does not match argument type
+        ///
+        template <class _Sink>
+        inline void append(_Inout_ _Sink &out, _In_count_(count) const format_arg *args, _In_ size_t count) const
+        {
+            const _Elem *text = m_text.c_str();
+            for (auto o = m_ops.cbegin(), o_end = m_ops.cend(); o != o_end; ++o) {
+                if (!o->arg) {
+                    out.append(text + o->spec.lit_start, o->spec.lit_len);
+                    continue;
+                }
+                if (o->arg > count) throw std::invalid_argument("Too few message arguments");
+                const format_arg *a = args + o->arg - 1;
+                size_t idx = 0;
+                if (o->spec.conv)
+                    format_one(out, text, o->spec, a, count - o->arg + 1, idx);
+                else {
+                    format_spec spec = o->spec;
+                    spec.conv = default_conv(a->kind);
+                    format_one(out, text, spec, a, count - o->arg + 1, idx);
+                }
+            }
+        }
+
+    protected:
+        /// \cond internal
+
+        ///
+        /// Literal text followed by an optional insertion
+        ///
+        struct op
+        {
+            format_spec spec;       ///< Literal text in `m_text` and insertion conversion. `conv` is 0 to convert by argument type.
+            unsigned char arg;      ///< Insertion number; 0 for literal text only
+        };
+
+        ///
+        /// Returns conversion for insertions without one
+        ///
+        static inline char default_conv(_In_ int kind)
+        {
+            switch (kind) {
+            case format_arg_int:   return 'd';
+            case format_arg_uint:  return 'u';
+            case format_arg_float: return 'g';
+            case format_arg_ptr:   return 'p';
+            default:               return 's';
+            }
+        }
+
+        ///
+        /// Parses message template into operations
+        ///
+        inline void parse(_In_z_ const _Elem *fmt)
+        {
+            op o = {};
+            for (size_t pos = 0;;) {
+                _Elem c = fmt[pos++];
+                if (!c)
+                    break;
+                if (c != '%') {
+                    m_text += c;
+                    continue;
+                }
+
+                c = fmt[pos++];
+                if ('1' <= c && c <= '9') {
+                    unsigned arg = c - '0';
+                    if ('0' <= fmt[pos] && fmt[pos] <= '9')
+                        arg = arg * 10 + (fmt[pos++] - '0');
+
+                    o.spec.lit_len = m_text.size() - o.spec.lit_start;
+                    o.arg = (unsigned char)arg;
+                    if (fmt[pos] == '!') {
+                        // Parse printf() conversion in exclamation marks.
+                        size_t start = ++pos;
+                        for (; fmt[pos] != '!'; pos++)
+                            if (!fmt[pos]) throw std::invalid_argument("Unterminated message insertion format");
+                        std::basic_string<_Elem> conv(1, '%');
+                        conv.append(fmt + start, pos++ - start);
+                        format_spec spec;
+                        if (format_parse(conv.c_str(), 0, spec) != conv.size() || !spec.conv)
+                            throw std::invalid_argument("Invalid message insertion format");
+                        o.spec.flags     = spec.flags;
+                        o.spec.size      = spec.size;
+                        o.spec.conv      = spec.conv;
+                        o.spec.width     = spec.width;
+                        o.spec.precision = spec.precision;
+                    }
+                    m_ops.push_back(o);
+                    o = op();
+                    o.spec.lit_start = m_text.size();
+                    continue;
+                }
+
+                if (c == '0')
+                    break;
+                switch (c) {
+                case 0:   pos--; m_text += '%'; break;
+                case 'n': m_text += '\r'; m_text += '\n'; break;
+                case 'r': m_text += '\r'; break;
+                case 't': m_text += '\t'; break;
+                case 'b': m_text += ' '; break;
+                default:  m_text += c;
+                }
+            }
+            o.spec.lit_len = m_text.size() - o.spec.lit_start;
+            if (o.spec.lit_len)
+                m_ops.push_back(o);
+        }
+
+        /// \endcond
+
+    protected:
+        std::basic_string<_Elem> m_text;    ///< Literal text with escapes resolved
+        std::vector<op> m_ops;              ///< Parsed operations
+    };
+
+
+    ///
+    /// Formats message using `FormatMessage()` insertion syntax and type-safe arguments
+    ///
+    /// \param[out] str   Formatted string. Its capacity is reused.
+    /// \param[in ] fmt   Parsed message template
+    /// \param[in ] args  Arguments to insert
+    ///
+    /// \returns Number of characters in result
+    ///
+    /// \throw std::invalid_argument  Message refers to an argument not provided, or conversion does not match argument type
+    ///
+    template <class _Elem, class _Traits, class _Ax, class... _Args>
+    inline size_t format_msg(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_ const basic_msg_format<_Elem> &fmt, _In_ const _Args&... args)
+    {
+        const format_arg a[] = { format_arg(args)..., format_arg() };
+        if (format_aliases(str, NULL, a, sizeof...(_Args))) {
+            std::basic_string<_Elem, _Traits, _Ax> result(str.get_allocator());
+            fmt.append(result, a, sizeof...(_Args));
+            str.swap(result);
+        } else {
+            str.clear();
+            fmt.append(str, a, sizeof...(_Args));
+        }
+        return str.size();
+    }
+
+    ///
+    /// Formats message using `FormatMessage()` insertion syntax and type-safe arguments
+    ///
+    /// \param[out] str   Formatted string. Its capacity is reused.
+    /// \param[in ] fmt   Message template using `FormatMessage()` insertion syntax. It is parsed on every call.
+    /// \param[in ] args  Arguments to insert
+    ///
+    /// \returns Number of characters in result
+    ///
+    /// \throw std::invalid_argument  Invalid message template, message refers to an argument not provided, or conversion does not match argument type
+    ///
+    template <class _Elem, class _Traits, class _Ax, class... _Args>
+    inline size_t format_msg(_Inout_ std::basic_string<_Elem, _Traits, _Ax> &str, _In_z_ _FormatMessage_format_string_ const _Elem *fmt, _In_ const _Args&... args)
+    {
+        return format_msg(str, basic_msg_format<_Elem>(fmt), args...);
+    }
+
+    /// @}
+}
@@ -25,13 +25,54 @@
 
 #include "Common.h"
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace winstd
 {
     class WINSTD_API hex_enc;
     class WINSTD_API hex_dec;
+    template<class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_hex_enc_ostreambuf;
+    template<class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_hex_enc_istreambuf;
+    template<class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_hex_dec_ostreambuf;
+    template<class _Elem = char, class _Traits = std::char_traits<_Elem> > class basic_hex_dec_istreambuf;
+
+    /// \addtogroup WinStdHexadecimal
+    /// @{
+
+    ///
+    /// Hexadecimal encoding output stream buffer
+    ///
+    typedef basic_hex_enc_ostreambuf<> hex_enc_ostreambuf;
+
+    ///
+    /// Hexadecimal encoding input stream buffer
+    ///
+    typedef basic_hex_enc_istreambuf<> hex_enc_istreambuf;
+
+    ///
+    /// Hexadecimal decoding output stream buffer
+    ///
+    typedef basic_hex_dec_ostreambuf<> hex_dec_ostreambuf;
+
+    ///
+    /// Hexadecimal decoding input stream buffer
+    ///
+    typedef basic_hex_dec_istreambuf<> hex_dec_istreambuf;
+
+    /// @}
+
+    /// \cond internal
+    WINSTD_API char    *hex_encode(_Out_writes_(size*2) char    *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_ bool lowercase);
+    WINSTD_API wchar_t *hex_encode(_Out_writes_(size*2) wchar_t *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_ bool lowercase);
+    WINSTD_API size_t hex_decode(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const char    *data, _In_ size_t size);
+    WINSTD_API size_t hex_decode(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size);
+    /// \endcond
 }
 
 #pragma once
@@ -51,7 +92,10 @@ namespace winstd
         ///
         /// Constructs blank encoding session
         ///
-        inline hex_enc()
+        /// \param[in] lowercase  Use lowercase `a`-`f` digits instead of uppercase `A`-`F`
+        ///
+        explicit inline hex_enc(_In_opt_ bool lowercase = false) :
+            lowercase(lowercase)
         {
         }
 
@@ -68,19 +112,88 @@ namespace winstd
         {
             assert(data || !size);
 
-            // Preallocate output
-            out.reserve(out.size() + enc_size(size));
+            // Preallocate output and convert directly into it.
+            size_t offset = out.size();
+            out.resize(offset + enc_size(size));
+            encode(&out[0] + offset, data, size);
+        }
+
+
+        ///
+        /// Encodes one block of information into a buffer
+        ///
+        /// \param[out] out       Output
+        /// \param[in ] capacity  Size of `out` in characters. `enc_size(size)` characters is always sufficient.
+        /// \param[out] consumed  Number of bytes of `data` consumed. Less than `size` when `out` is too small.
+        /// \param[in ] data      Data to encode
+        /// \param[in ] size      Length of `data` in bytes
+        ///
+        /// \returns Number of characters written to `out`
+        ///
+        template<class _Elem>
+        inline size_t encode(_Out_writes_to_(capacity, return) _Elem *out, _In_ size_t capacity, _Out_ size_t &consumed, _In_bytecount_(size) const void *data, _In_ size_t size)
+        {
+            assert(data || !size);
+
+            consumed = std::min<size_t>(size, capacity/2);
+            return encode(out, data, consumed) - out;
+        }
+
+
+        ///
+        /// Encodes one block of information, and writes it to the output iterator
+        ///
+        /// \param[out] out   Output iterator
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes
+        ///
+        /// \returns Output iterator past the last character written
+        ///
+        template<class _OutIt>
+        inline _OutIt encode(_In_ _OutIt out, _In_bytecount_(size) const void *data, _In_ size_t size)
+        {
+            assert(data || !size);
 
             // Convert data character by character.
             for (size_t i = 0; i < size; i++) {
-                unsigned char
-                    x   = reinterpret_cast<const unsigned char*>(data)[i],
-                    x_h = ((x & 0xf0) >> 4),
-                    x_l = ((x & 0x0f)     );
-
-                out += x_h < 10 ? '0' + x_h : 'A' - 10 + x_h;
-                out += x_l < 10 ? '0' + x_l : 'A' - 10 + x_l;
+                unsigned char x = reinterpret_cast<const unsigned char*>(data)[i];
+                *out++ = digit(x >> 4);
+                *out++ = digit(x & 0x0f);
             }
+
+            return out;
+        }
+
+
+        ///
+        /// Encodes one block of information into a buffer of `enc_size(size)` characters
+        ///
+        /// \param[out] out   Output
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes
+        ///
+        /// \returns Pointer past the last character written
+        ///
+        inline char *encode(_Out_writes_(size*2) char *out, _In_bytecount_(size) const void *data, _In_ size_t size)
+        {
+            assert(data || !size);
+            return hex_encode(out, reinterpret_cast<const unsigned char*>(data), size, lowercase);
+        }
+
+
+        ///
+        /// Encodes one block of information into a buffer of `enc_size(size)` characters
+        ///
+        /// \param[out] out   Output
+        /// \param[in ] data  Data to encode
+        /// \param[in ] size  Length of `data` in bytes
+        ///
+        /// \returns Pointer past the last character written
+        ///
+        inline wchar_t *encode(_Out_writes_(size*2) wchar_t *out, _In_bytecount_(size) const void *data, _In_ size_t size)
+        {
+            assert(data || !size);
+            return hex_encode(out, reinterpret_cast<const unsigned char*>(data), size, lowercase);
         }
 
 
@@ -95,6 +208,21 @@ namespace winstd
         {
             return size*2;
         }
+
+
+    protected:
+        ///
+        /// Returns hexadecimal digit of a nibble without branching
+        ///
+        inline char digit(_In_ unsigned int x) const
+        {
+            // (9 - x) >> 8 is all ones for x > 9 only.
+            return (char)('0' + x + (((9 - x) >> 8) & ((lowercase ? 'a' : 'A') - '0' - 10)));
+        }
+
+
+    protected:
+        bool lowercase;     ///< Use lowercase digits
     };
 
 
@@ -125,39 +253,155 @@ namespace winstd
         template<class _Ty, class _Ax, class _Tchr>
         inline void decode(_Inout_ std::vector<_Ty, _Ax> &out, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
         {
-            is_last = false;
+            // Preallocate output and decode directly into it.
+            size_t offset = out.size(), consumed;
+            out.resize(offset + dec_size(size));
+            out.resize(offset + decode(out.data() + offset, out.size() - offset, consumed, is_last, data, size));
+        }
 
-            // Trim data size to first terminator.
-            for (size_t k = 0; k < size; k++)
-                if (!data[k]) { size = k; break; }
 
-            // Preallocate output
-            out.reserve(out.size() + dec_size(size));
+        ///
+        /// Decodes one block of information into a buffer
+        ///
+        /// Decoding stops at the terminator, or when the buffer might not have enough room for the next byte.
+        ///
+        /// \param[out] out       Output
+        /// \param[in ] capacity  Size of `out` in elements. `dec_size(size)` elements is always sufficient.
+        /// \param[out] consumed  Number of characters of `data` consumed
+        /// \param[out] is_last   Was this the last block of data? Actually, is this block of data complete?
+        /// \param[in ] data      Data to decode
+        /// \param[in ] size      Length of `data` in characters
+        ///
+        /// \returns Number of elements written to `out`
+        ///
+        template<class _Ty, class _Tchr>
+        inline size_t decode(_Out_writes_to_(capacity, return) _Ty *out, _In_ size_t capacity, _Out_ size_t &consumed, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            // Take only as much data as there is room for all bytes it might complete.
+            size = std::min<size_t>(size, capacity*2 + 1 - num);
 
-            for (size_t i = 0;; i++) {
+            _Ty *dst = out;
+            size_t i = 0;
+            for (;; i++) {
                 if (num >= 2) {
                     // Buffer full.
-                    out.push_back(buf);
+                    *dst++ = buf;
                     num = 0;
                     is_last = true;
                 } else
                     is_last = false;
 
-                if (i >= size)
+                if (i >= size || !data[i])
                     break;
 
-                int x = data[i];
-                if ('0' <= x && x <= '9') {
-                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - '0');
-                    num++;
-                } else if ('A' <= x && x <= 'F') {
-                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - ('A' - 10));
-                    num++;
-                } else if ('a' <= x && x <= 'f') {
-                    buf = ((buf & 0xf) << 4) | (unsigned char)(x - ('a' - 10));
+                unsigned char x = nibble(data[i]);
+                if (x < 0x10) {
+                    buf = ((buf & 0xf) << 4) | x;
                     num++;
                 }
             }
+
+            consumed = i;
+            return dst - out;
+        }
+
+
+        ///
+        /// Decodes one block of information strictly, and _appends_ it to the output
+        ///
+        /// Unlike `decode()`, which skips anything but hexadecimal digits, decoding stops at the first character that is
+        /// not a hexadecimal digit. Use `decode()` for human-formatted input like `AB:CD:EF`.
+        ///
+        /// \param[inout] out      Output
+        /// \param[out  ] is_last  Is the last byte complete?
+        /// \param[in   ] data     Data to decode
+        /// \param[in   ] size     Length of `data` in characters
+        ///
+        /// \returns Position of the first character that is not a hexadecimal digit; `size` if there is none
+        ///
+        template<class _Ty, class _Ax, class _Tchr>
+        inline size_t decode_strict(_Inout_ std::vector<_Ty, _Ax> &out, _Out_ bool &is_last, _In_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            // Preallocate output and decode directly into it.
+            size_t offset = out.size(), written;
+            out.resize(offset + dec_size(size));
+            size_t result = decode_strict(out.data() + offset, written, is_last, data, size);
+            out.resize(offset + written);
+            return result;
+        }
+
+
+        ///
+        /// Decodes one block of information strictly into a buffer
+        ///
+        /// \copydetails decode_strict(std::vector<_Ty, _Ax> &, bool &, const _Tchr *, size_t)
+        ///
+        /// \param[out] out      Output. Must have room for `dec_size(size)` elements.
+        /// \param[out] written  Number of elements written to `out`
+        ///
+        template<class _Ty, class _Tchr>
+        inline size_t decode_strict(_Out_writes_to_(dec_size(size), written) _Ty *out, _Out_ size_t &written, _Out_ bool &is_last, _In_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            _Ty *dst = out;
+            size_t i = 0;
+
+            if (num && i < size) {
+                // Complete the byte left over from the previous block first.
+                unsigned char x = nibble(data[i]);
+                if (x < 0x10) {
+                    *dst++ = (_Ty)(((buf & 0xf) << 4) | x);
+                    num = 0;
+                    i++;
+                }
+            }
+
+            if (!num && sizeof(_Ty) == 1) {
+                // Decode as many complete blocks as possible directly from the input.
+                size_t n = decode_bulk(reinterpret_cast<unsigned char*>(dst), data + i, size - i);
+                dst += n/2;
+                i   += n;
+            }
+
+            for (; i < size; i++) {
+                unsigned char x = nibble(data[i]);
+                if (x >= 0x10)
+                    break;
+                buf = ((buf & 0xf) << 4) | x;
+                if (++num >= 2) {
+                    *dst++ = buf;
+                    num = 0;
+                }
+            }
+
+            written = dst - out;
+            is_last = !num;
+            return i;
+        }
+
+
+        ///
+        /// Decodes one block of information, and writes it to the output iterator
+        ///
+        /// \param[out] out      Output iterator
+        /// \param[out] is_last  Was this the last block of data? Actually, is this block of data complete?
+        /// \param[in ] data     Data to decode
+        /// \param[in ] size     Length of `data` in characters
+        ///
+        /// \returns Output iterator past the last element written
+        ///
+        template<class _OutIt, class _Tchr>
+        inline _OutIt decode(_In_ _OutIt out, _Out_ bool &is_last, _In_z_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            // Decode in stack buffer sized chunks, then copy.
+            unsigned char chunk[WINSTD_STACK_BUFFER_BYTES];
+            do {
+                size_t consumed, n = decode(chunk, _countof(chunk), consumed, is_last, data, size);
+                for (size_t i = 0; i < n; i++)
+                    *out++ = chunk[i];
+                data += consumed;
+                size -= consumed;
+            } while (size && *data);
+            return out;
         }
 
 
@@ -183,10 +427,430 @@ namespace winstd
         }
 
 
+    protected:
+        ///
+        /// Returns value of a hexadecimal digit, or 0xff if the character is not a hexadecimal digit
+        ///
+        template<class _Tchr>
+        static inline unsigned char nibble(_In_ _Tchr chr)
+        {
+            auto x = static_cast<typename std::make_unsigned<_Tchr>::type>(chr);
+            if ((unsigned int)(x - '0') < 10)
+                return (unsigned char)(x - '0');
+            if ((unsigned int)((x | 0x20) - 'a') < 6)
+                return (unsigned char)((x | 0x20) - ('a' - 10));
+            return 0xff;
+        }
+
+
+        ///
+        /// Decodes complete blocks of data
+        ///
+        /// Generic character types are decoded character by character.
+        ///
+        /// \returns Always 0
+        ///
+        template<class _Tchr>
+        static inline size_t decode_bulk(_Out_ unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size)
+        {
+            UNREFERENCED_PARAMETER(out);
+            UNREFERENCED_PARAMETER(data);
+            UNREFERENCED_PARAMETER(size);
+            return 0;
+        }
+
+
+        ///
+        /// Decodes complete blocks of data
+        ///
+        /// Uses the fastest implementation the CPU supports: AVX2, SSSE3 or none. Decoding stops at the first block of
+        /// characters containing anything but hexadecimal digits, leaving it to the character by character decoder.
+        ///
+        /// \param[out] out   Output. Must have room for `size/2` bytes.
+        /// \param[in ] data  Data to decode
+        /// \param[in ] size  Length of `data` in characters
+        ///
+        /// \returns Number of characters decoded. Always a multiple of 2.
+        ///
+        static inline size_t decode_bulk(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const char *data, _In_ size_t size)
+        {
+            return hex_decode(out, data, size);
+        }
+
+
+        ///
+        /// Decodes complete blocks of data
+        ///
+        /// \copydetails decode_bulk(unsigned char *, const char *, size_t)
+        ///
+        static inline size_t decode_bulk(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size)
+        {
+            return hex_decode(out, data, size);
+        }
+
+
     protected:
         unsigned char buf;  ///< Internal buffer
         size_t num;         ///< Number of nibbles used in `buf`
     };
 
+
+    /// \cond internal
+
+    ///
+    /// Returns value of a hexadecimal digit. Throws when the character is not a hexadecimal digit.
+    ///
+    constexpr unsigned char hex_nibble(_In_ char chr)
+    {
+        return
+            '0' <= chr && chr <= '9' ? (unsigned char)(chr - '0') :
+            'A' <= chr && chr <= 'F' ? (unsigned char)(chr - ('A' - 10)) :
+            'a' <= chr && chr <= 'f' ? (unsigned char)(chr - ('a' - 10)) :
+            throw std::invalid_argument("Not a hexadecimal digit");
+    }
+
+
+    ///
+    /// Returns hexadecimal digit of a nibble
+    ///
+    constexpr char hex_digit(_In_ unsigned char x, _In_ bool lowercase)
+    {
+        return x < 10 ? (char)('0' + x) : (char)((lowercase ? 'a' : 'A') - 10 + x);
+    }
+
+
+    template<size_t... _Idx>
+    constexpr std::array<unsigned char, sizeof...(_Idx)> hex_dec_array(_In_z_ const char *str, _In_ std::index_sequence<_Idx...>)
+    {
+        return {{ (unsigned char)((hex_nibble(str[_Idx*2]) << 4) | hex_nibble(str[_Idx*2 + 1]))... }};
+    }
+
+
+    template<size_t _Size, size_t... _Idx>
+    constexpr std::array<char, sizeof...(_Idx)> hex_enc_array(_In_ const std::array<unsigned char, _Size> &data, _In_ bool lowercase, _In_ std::index_sequence<_Idx...>)
+    {
+        return {{ (_Idx < _Size*2 ? hex_digit(_Idx % 2 ? data[_Idx/2] & 0x0f : data[_Idx/2] >> 4, lowercase) : '\0')... }};
+    }
+
+    /// \endcond
+
+
+    ///
+    /// Decodes hexadecimal string literal at compile time
+    ///
+    /// Use in constant expressions to embed binary data without runtime decoding:
+    /// \code
+    /// constexpr std::array<unsigned char, 4> magic = winstd::hex_dec_array("DEADBEEF");
+    /// \endcode
+    /// Literals of odd length, or containing anything but hexadecimal digits, fail to compile.
+    ///
+    /// \param[in] str  Hexadecimal string literal
+    ///
+    /// \returns Decoded data
+    ///
+    template<size_t _Len>
+    constexpr std::array<unsigned char, (_Len - 1)/2> hex_dec_array(_In_z_ const char (&str)[_Len])
+    {
+        static_assert((_Len - 1) % 2 == 0, "Hexadecimal string length must be even");
+        return hex_dec_array(str, std::make_index_sequence<(_Len - 1)/2>());
+    }
+
+
+    ///
+    /// Encodes data as hexadecimal at compile time
+    ///
+    /// \param[in] data       Data to encode
+    /// \param[in] lowercase  Use lowercase `a`-`f` digits instead of uppercase `A`-`F`
+    ///
+    /// \returns Zero-terminated hexadecimal string
+    ///
+    template<size_t _Size>
+    constexpr std::array<char, _Size*2 + 1> hex_enc_array(_In_ const std::array<unsigned char, _Size> &data, _In_opt_ bool lowercase = false)
+    {
+        return hex_enc_array(data, lowercase, std::make_index_sequence<_Size*2 + 1>());
+    }
+
+
+    ///
+    /// Hexadecimal encoding output stream buffer
+    ///
+    /// Data written is encoded in blocks and passed to the target stream buffer, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Elem, class _Traits>
+    class basic_hex_enc_ostreambuf : public std::streambuf
+    {
+        WINSTD_NONCOPYABLE(basic_hex_enc_ostreambuf)
+
+    public:
+        ///
+        /// Constructs encoding stream buffer
+        ///
+        /// \param[in] target     Stream buffer to write encoded data to
+        /// \param[in] lowercase  Use lowercase `a`-`f` digits instead of uppercase `A`-`F`
+        ///
+        inline basic_hex_enc_ostreambuf(_In_ std::basic_streambuf<_Elem, _Traits> *target, _In_opt_ bool lowercase = false) :
+            m_target(target),
+            m_enc(lowercase)
+        {
+            setp(m_in, m_in + _countof(m_in));
+        }
+
+
+        ///
+        /// Encodes pending data and destroys the stream buffer
+        ///
+        virtual ~basic_hex_enc_ostreambuf()
+        {
+            sync();
+        }
+
+
+    protected:
+        virtual int_type overflow(_In_ int_type ch = traits_type::eof())
+        {
+            if (!encode())
+                return traits_type::eof();
+            if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+
+        virtual int sync()
+        {
+            return encode() && m_target->pubsync() == 0 ? 0 : -1;
+        }
+
+
+        ///
+        /// Encodes data in the put area and writes it to the target stream buffer
+        ///
+        inline bool encode()
+        {
+            const char *data = pbase();
+            size_t size = pptr() - pbase();
+            while (size) {
+                size_t consumed, n = m_enc.encode(m_out, _countof(m_out), consumed, data, size);
+                if (m_target->sputn(m_out, n) != (std::streamsize)n)
+                    return false;
+                data += consumed;
+                size -= consumed;
+            }
+            setp(m_in, m_in + _countof(m_in));
+            return true;
+        }
+
+
+    protected:
+        std::basic_streambuf<_Elem, _Traits> *m_target;            ///< Target stream buffer
+        hex_enc m_enc;                                              ///< Encoding session
+        char m_in[WINSTD_STACK_BUFFER_BYTES/2];                     ///< Data pending encoding
+        _Elem m_out[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];       ///< Encoded data
+    };
+
+
+    ///
+    /// Hexadecimal encoding input stream buffer
+    ///
+    /// Reads data from the source stream buffer in blocks and provides it encoded, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Elem, class _Traits>
+    class basic_hex_enc_istreambuf : public std::basic_streambuf<_Elem, _Traits>
+    {
+        WINSTD_NONCOPYABLE(basic_hex_enc_istreambuf)
+
+    public:
+        typedef typename std::basic_streambuf<_Elem, _Traits>::int_type int_type;
+
+        ///
+        /// Constructs encoding stream buffer
+        ///
+        /// \param[in] source     Stream buffer to read data to encode from
+        /// \param[in] lowercase  Use lowercase `a`-`f` digits instead of uppercase `A`-`F`
+        ///
+        inline basic_hex_enc_istreambuf(_In_ std::streambuf *source, _In_opt_ bool lowercase = false) :
+            m_source(source),
+            m_enc(lowercase),
+            m_head(0),
+            m_tail(0)
+        {
+        }
+
+
+    protected:
+        virtual int_type underflow()
+        {
+            if (m_head >= m_tail) {
+                m_head = 0;
+                m_tail = (size_t)m_source->sgetn(m_in, _countof(m_in));
+                if (!m_tail)
+                    return _Traits::eof();
+            }
+            size_t consumed, n = m_enc.encode(m_out, _countof(m_out), consumed, m_in + m_head, m_tail - m_head);
+            m_head += consumed;
+            this->setg(m_out, m_out, m_out + n);
+            return _Traits::to_int_type(m_out[0]);
+        }
+
+
+    protected:
+        std::streambuf *m_source;                                   ///< Source stream buffer
+        hex_enc m_enc;                                              ///< Encoding session
+        size_t m_head;                                              ///< Start of data pending encoding in `m_in`
+        size_t m_tail;                                              ///< End of data pending encoding in `m_in`
+        char m_in[WINSTD_STACK_BUFFER_BYTES/2];                     ///< Data read from source
+        _Elem m_out[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];       ///< Encoded data
+    };
+
+
+    ///
+    /// Hexadecimal decoding output stream buffer
+    ///
+    /// Text written is decoded in blocks and passed to the target stream buffer, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Elem, class _Traits>
+    class basic_hex_dec_ostreambuf : public std::basic_streambuf<_Elem, _Traits>
+    {
+        WINSTD_NONCOPYABLE(basic_hex_dec_ostreambuf)
+
+    public:
+        typedef typename std::basic_streambuf<_Elem, _Traits>::int_type int_type;
+
+        ///
+        /// Constructs decoding stream buffer
+        ///
+        /// \param[in] target  Stream buffer to write decoded data to
+        ///
+        inline basic_hex_dec_ostreambuf(_In_ std::streambuf *target) :
+            m_target(target)
+        {
+            this->setp(m_in, m_in + _countof(m_in));
+        }
+
+
+        ///
+        /// Decodes pending text and destroys the stream buffer
+        ///
+        virtual ~basic_hex_dec_ostreambuf()
+        {
+            sync();
+        }
+
+
+    protected:
+        virtual int_type overflow(_In_ int_type ch = _Traits::eof())
+        {
+            if (!decode())
+                return _Traits::eof();
+            if (!_Traits::eq_int_type(ch, _Traits::eof())) {
+                *this->pptr() = _Traits::to_char_type(ch);
+                this->pbump(1);
+            }
+            return _Traits::not_eof(ch);
+        }
+
+
+        virtual int sync()
+        {
+            return decode() && m_target->pubsync() == 0 ? 0 : -1;
+        }
+
+
+        ///
+        /// Decodes text in the put area and writes it to the target stream buffer
+        ///
+        inline bool decode()
+        {
+            const _Elem *data = this->pbase();
+            size_t size = this->pptr() - this->pbase();
+            while (size) {
+                bool is_last;
+                size_t consumed, n = m_dec.decode(m_out, _countof(m_out), consumed, is_last, data, size);
+                if (m_target->sputn(m_out, n) != (std::streamsize)n)
+                    return false;
+                if (consumed < size && !data[consumed]) {
+                    // Skip the terminator.
+                    consumed++;
+                }
+                data += consumed;
+                size -= consumed;
+            }
+            this->setp(m_in, m_in + _countof(m_in));
+            return true;
+        }
+
+
+    protected:
+        std::streambuf *m_target;                                   ///< Target stream buffer
+        hex_dec m_dec;                                              ///< Decoding session
+        _Elem m_in[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];        ///< Text pending decoding
+        char m_out[WINSTD_STACK_BUFFER_BYTES/2];                    ///< Decoded data
+    };
+
+
+    ///
+    /// Hexadecimal decoding input stream buffer
+    ///
+    /// Reads text from the source stream buffer in blocks and provides it decoded, so memory use is constant regardless of
+    /// the size of data.
+    ///
+    template<class _Elem, class _Traits>
+    class basic_hex_dec_istreambuf : public std::streambuf
+    {
+        WINSTD_NONCOPYABLE(basic_hex_dec_istreambuf)
+
+    public:
+        ///
+        /// Constructs decoding stream buffer
+        ///
+        /// \param[in] source  Stream buffer to read text to decode from
+        ///
+        inline basic_hex_dec_istreambuf(_In_ std::basic_streambuf<_Elem, _Traits> *source) :
+            m_source(source),
+            m_head(0),
+            m_tail(0)
+        {
+        }
+
+
+    protected:
+        virtual int_type underflow()
+        {
+            for (;;) {
+                if (m_head >= m_tail) {
+                    m_head = 0;
+                    m_tail = (size_t)m_source->sgetn(m_in, _countof(m_in));
+                    if (!m_tail)
+                        return traits_type::eof();
+                }
+                bool is_last;
+                size_t consumed, n = m_dec.decode(m_out, _countof(m_out), consumed, is_last, m_in + m_head, m_tail - m_head);
+                m_head += consumed;
+                if (m_head < m_tail && !m_in[m_head]) {
+                    // Skip the terminator.
+                    m_head++;
+                }
+                if (n) {
+                    setg(m_out, m_out, m_out + n);
+                    return traits_type::to_int_type(m_out[0]);
+                }
+            }
+        }
+
+
+    protected:
+        std::basic_streambuf<_Elem, _Traits> *m_source;            ///< Source stream buffer
+        hex_dec m_dec;                                              ///< Decoding session
+        size_t m_head;                                              ///< Start of text pending decoding in `m_in`
+        size_t m_tail;                                              ///< End of text pending decoding in `m_in`
+        _Elem m_in[WINSTD_STACK_BUFFER_BYTES/sizeof(_Elem)];        ///< Text read from source
+        char m_out[WINSTD_STACK_BUFFER_BYTES/2];                    ///< Decoded data
+    };
+
     /// @}
 }
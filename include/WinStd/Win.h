@@ -28,6 +28,7 @@
 #include <Windows.h>
 
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace winstd
@@ -116,7 +117,7 @@ _Success_(return) BOOL WINSTD_API StringToGuidA(_In_z_ LPCSTR lpszGuid, _Out_ LP
 ///
 /// Parses string with GUID and stores it to GUID
 ///
-/// \param[in ] lpszGuid     String with GUID
+/// \param[in ] lpszGuid     String with GUID in `{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}` form. Braces are optional.
 /// \param[out] lpGuid       GUID to store the result to
 /// \param[out] lpszGuidEnd  If non-NULL the pointer to the end of parsed GUID within `lpszGuid` is returned
 ///
@@ -1325,28 +1326,14 @@ inline DWORD ExpandEnvironmentStringsW(_In_z_ LPCWSTR lpSrc, _Inout_ std::basic_
 template<class _Elem, class _Traits, class _Ax>
 inline VOID GuidToStringA(_In_ LPCGUID lpGuid, _Inout_ std::basic_string<_Elem, _Traits, _Ax> &str)
 {
-    assert(0); // TODO: Test this code.
-
-    sprintf(str, "{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}",
-        lpGuid->Data1,
-        lpGuid->Data2,
-        lpGuid->Data3,
-        lpGuid->Data4[0], lpGuid->Data4[1],
-        lpGuid->Data4[2], lpGuid->Data4[3], lpGuid->Data4[4], lpGuid->Data4[5], lpGuid->Data4[6], lpGuid->Data4[7]);
+    winstd::guid_format(str, *lpGuid);
 }
 
 
 template<class _Elem, class _Traits, class _Ax>
 inline VOID GuidToStringW(_In_ LPCGUID lpGuid, _Inout_ std::basic_string<_Elem, _Traits, _Ax> &str)
 {
-    assert(0); // TODO: Test this code.
-
-    sprintf(str, L"{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}",
-        lpGuid->Data1,
-        lpGuid->Data2,
-        lpGuid->Data3,
-        lpGuid->Data4[0], lpGuid->Data4[1],
-        lpGuid->Data4[2], lpGuid->Data4[3], lpGuid->Data4[4], lpGuid->Data4[5], lpGuid->Data4[6], lpGuid->Data4[7]);
+    winstd::guid_format(str, *lpGuid);
 }
 
 
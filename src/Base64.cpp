@@ -22,41 +22,318 @@
 
 
 //////////////////////////////////////////////////////////////////////
-// winstd::base64_enc
+// Base64 alphabets
+//////////////////////////////////////////////////////////////////////
+
+constexpr char          winstd::base64_std::lookup_enc[64];
+constexpr unsigned char winstd::base64_std::lookup_dec[256];
+constexpr bool          winstd::base64_std::padding;
+constexpr size_t        winstd::base64_std::line_max;
+
+constexpr bool          winstd::base64_std_nopad::padding;
+
+constexpr char          winstd::base64_url::lookup_enc[64];
+constexpr unsigned char winstd::base64_url::lookup_dec[256];
+constexpr bool          winstd::base64_url::padding;
+constexpr size_t        winstd::base64_url::line_max;
+
+constexpr bool          winstd::base64_url_nopad::padding;
+
+constexpr size_t        winstd::base64_mime::line_max;
+
+
+//////////////////////////////////////////////////////////////////////
+// Base64 encoding
 //////////////////////////////////////////////////////////////////////
 
 /// \cond internal
-const char winstd::base64_enc::lookup[64] = {
-    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
-};
+
+static void base64_encode_scalar(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(64) const char *lookup)
+{
+    for (const unsigned char *data_end = data + size; data < data_end; data += 3, out += 4) {
+        unsigned long x = ((unsigned long)data[0] << 16) | ((unsigned long)data[1] << 8) | data[2];
+        out[0] = lookup[ x >> 18        ];
+        out[1] = lookup[(x >> 12) & 0x3f];
+        out[2] = lookup[(x >>  6) & 0x3f];
+        out[3] = lookup[ x        & 0x3f];
+    }
+}
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//
+// The vector implementations follow W. Mula and D. Lemire, "Faster Base64 Encoding and Decoding
+// Using AVX2 Instructions". Each 32-bit lane gets three input bytes, the four 6-bit indices are
+// extracted with two multiplications, and mapped to characters by adding an offset looked up by
+// the index range. The range offsets for indices 62 and 63 are taken from the alphabet.
+//
+
+static inline __m128i base64_encode_block_ssse3(_In_ __m128i in, _In_ __m128i shift_lut)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i
+        t0  = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040)),
+        t1  = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010)),
+        idx = _mm_or_si128(t0, t1),
+        r   = _mm_or_si128(
+            _mm_subs_epu8(idx, _mm_set1_epi8(51)),
+            _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, r), idx);
+}
+
+
+static inline __m256i base64_encode_block_avx2(_In_ __m256i in, _In_ __m256i shift_lut)
+{
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+        10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m256i
+        t0  = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040)),
+        t1  = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010)),
+        idx = _mm256_or_si256(t0, t1),
+        r   = _mm256_or_si256(
+            _mm256_subs_epu8(idx, _mm256_set1_epi8(51)),
+            _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx), _mm256_set1_epi8(13)));
+    return _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, r), idx);
+}
+
+
+static inline __m128i base64_shift_lut(_In_count_c_(64) const char *lookup)
+{
+    return _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, (char)(lookup[62] - 62), (char)(lookup[63] - 63), 'A', 0, 0);
+}
+
+
+static void base64_encode_ssse3(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(64) const char *lookup)
+{
+    const __m128i shift_lut = base64_shift_lut(lookup);
+
+    // Each step reads 16 bytes, but consumes only 12 of them.
+    for (; size >= 16; data += 12, out += 16, size -= 12)
+        _mm_storeu_si128((__m128i*)out, base64_encode_block_ssse3(_mm_loadu_si128((const __m128i*)data), shift_lut));
+
+    base64_encode_scalar(out, data, size, lookup);
+}
+
+
+static void base64_encode_avx2(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(64) const char *lookup)
+{
+    const __m256i shift_lut = _mm256_broadcastsi128_si256(base64_shift_lut(lookup));
+
+    // Each step reads 28 bytes, but consumes only 24 of them.
+    for (; size >= 28; data += 24, out += 32, size -= 24) {
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)data)),
+            _mm_loadu_si128((const __m128i*)(data + 12)), 1);
+        _mm256_storeu_si256((__m256i*)out, base64_encode_block_avx2(in, shift_lut));
+    }
+
+    // Not all compilers clear the upper halves before the call. Legacy SSE code in the caller would pay for the transition.
+    _mm256_zeroupper();
+    base64_encode_ssse3(out, data, size, lookup);
+}
+
+#endif
+
 /// \endcond
 
 
+char *winstd::base64_encode_groups(_Out_writes_(size/3*4) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(64) const char *lookup)
+{
+    assert(size % 3 == 0);
+
+#if defined(_M_IX86) || defined(_M_X64)
+    if (cpu_has_avx2())
+        base64_encode_avx2(out, data, size, lookup);
+    else if (cpu_has_ssse3())
+        base64_encode_ssse3(out, data, size, lookup);
+    else
+#endif
+        base64_encode_scalar(out, data, size, lookup);
+
+    return out + size/3*4;
+}
+
+
 //////////////////////////////////////////////////////////////////////
-// winstd::base64_dec
+// Base64 decoding
 //////////////////////////////////////////////////////////////////////
 
 /// \cond internal
-const unsigned char winstd::base64_dec::lookup[256] = {
-/*           0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F  */
-/* 0 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* 1 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* 2 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
-/* 3 */     52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255,  64, 255, 255,
-/* 4 */    255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
-/* 5 */     15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
-/* 6 */    255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
-/* 7 */     41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
-/* 8 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* 9 */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* A */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* B */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* C */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* D */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* E */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
-/* F */    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
-};
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//
+// Translates Base64 alphabet to 6-bit values. Returns false if any of the characters is not in the alphabet.
+//
+static inline bool base64_translate_ssse3(_In_ __m128i in, _Out_ __m128i &values, _In_ __m128i c62, _In_ __m128i c63)
+{
+    __m128i
+        upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), in)),
+        lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), in)),
+        digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), in)),
+        is62  = _mm_cmpeq_epi8(in, c62),
+        is63  = _mm_cmpeq_epi8(in, c63);
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit), _mm_or_si128(is62, is63))) != 0xffff)
+        return false;
+
+    __m128i shift = _mm_or_si128(
+        _mm_or_si128(
+            _mm_and_si128(upper, _mm_set1_epi8(-'A')),
+            _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+        _mm_or_si128(
+            _mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+            _mm_or_si128(
+                _mm_and_si128(is62, _mm_sub_epi8(_mm_set1_epi8(62), c62)),
+                _mm_and_si128(is63, _mm_sub_epi8(_mm_set1_epi8(63), c63)))));
+    values = _mm_add_epi8(in, shift);
+    return true;
+}
+
+
+//
+// Packs 16 6-bit values into 12 bytes
+//
+static inline void base64_pack_ssse3(_Out_writes_(12) unsigned char *out, _In_ __m128i values)
+{
+    __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+    merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storel_epi64((__m128i*)out, merged);
+    *(int*)(out + 8) = _mm_cvtsi128_si32(_mm_srli_si128(merged, 8));
+}
+
+
+static inline bool base64_translate_avx2(_In_ __m256i in, _Out_ __m256i &values, _In_ __m256i c62, _In_ __m256i c63)
+{
+    __m256i
+        upper = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), in)),
+        lower = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), in)),
+        digit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in)),
+        is62  = _mm256_cmpeq_epi8(in, c62),
+        is63  = _mm256_cmpeq_epi8(in, c63);
+    if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), digit), _mm256_or_si256(is62, is63))) != -1)
+        return false;
+
+    __m256i shift = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+            _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+        _mm256_or_si256(
+            _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+            _mm256_or_si256(
+                _mm256_and_si256(is62, _mm256_sub_epi8(_mm256_set1_epi8(62), c62)),
+                _mm256_and_si256(is63, _mm256_sub_epi8(_mm256_set1_epi8(63), c63)))));
+    values = _mm256_add_epi8(in, shift);
+    return true;
+}
+
+
+//
+// Packs 32 6-bit values into 24 bytes
+//
+static inline void base64_pack_avx2(_Out_writes_(24) unsigned char *out, _In_ __m256i values)
+{
+    __m256i merged = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)), _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(merged));
+    _mm_storel_epi64((__m128i*)(out + 16), _mm256_extracti128_si256(merged, 1));
+}
+
+
+//
+// Loads 16 characters as bytes. Wide characters outside of Latin-1 saturate to 0 or 255, which are not in the alphabet.
+//
+static inline __m128i base64_load_ssse3(_In_count_c_(16) const char *data)
+{
+    return _mm_loadu_si128((const __m128i*)data);
+}
+
+
+static inline __m128i base64_load_ssse3(_In_count_c_(16) const wchar_t *data)
+{
+    return _mm_packus_epi16(_mm_loadu_si128((const __m128i*)data), _mm_loadu_si128((const __m128i*)(data + 8)));
+}
+
+
+//
+// Loads 32 characters as bytes
+//
+static inline __m256i base64_load_avx2(_In_count_c_(32) const char *data)
+{
+    return _mm256_loadu_si256((const __m256i*)data);
+}
+
+
+static inline __m256i base64_load_avx2(_In_count_c_(32) const wchar_t *data)
+{
+    return _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(_mm256_loadu_si256((const __m256i*)data), _mm256_loadu_si256((const __m256i*)(data + 16))),
+        0xd8);
+}
+
+
+template <class _Tchr>
+static size_t base64_decode_ssse3(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size, _In_ char c62, _In_ char c63)
+{
+    const __m128i v62 = _mm_set1_epi8(c62), v63 = _mm_set1_epi8(c63);
+    size_t i = 0;
+    for (__m128i values; i + 16 <= size && base64_translate_ssse3(base64_load_ssse3(data + i), values, v62, v63); i += 16, out += 12)
+        base64_pack_ssse3(out, values);
+    return i;
+}
+
+
+template <class _Tchr>
+static size_t base64_decode_avx2(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size, _In_ char c62, _In_ char c63)
+{
+    const __m256i v62 = _mm256_set1_epi8(c62), v63 = _mm256_set1_epi8(c63);
+    size_t i = 0;
+    for (__m256i values; i + 32 <= size && base64_translate_avx2(base64_load_avx2(data + i), values, v62, v63); i += 32, out += 24)
+        base64_pack_avx2(out, values);
+    return i + base64_decode_ssse3(out, data + i, size - i, c62, c63);
+}
+
+#endif
+
 /// \endcond
+
+
+size_t winstd::base64_decode_groups(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const char *data, _In_ size_t size, _In_ char c62, _In_ char c63)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    if (cpu_has_avx2())
+        return base64_decode_avx2(out, data, size, c62, c63);
+    else if (cpu_has_ssse3())
+        return base64_decode_ssse3(out, data, size, c62, c63);
+#else
+    UNREFERENCED_PARAMETER(out);
+    UNREFERENCED_PARAMETER(data);
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(c62);
+    UNREFERENCED_PARAMETER(c63);
+#endif
+    return 0;
+}
+
+
+size_t winstd::base64_decode_groups(_Out_writes_(size/4*3) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size, _In_ char c62, _In_ char c63)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    if (cpu_has_avx2())
+        return base64_decode_avx2(out, data, size, c62, c63);
+    else if (cpu_has_ssse3())
+        return base64_decode_ssse3(out, data, size, c62, c63);
+#else
+    UNREFERENCED_PARAMETER(out);
+    UNREFERENCED_PARAMETER(data);
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(c62);
+    UNREFERENCED_PARAMETER(c63);
+#endif
+    return 0;
+}
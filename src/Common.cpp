@@ -0,0 +1,142 @@
+﻿/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StdAfx.h"
+
+
+//////////////////////////////////////////////////////////////////////
+// GUID parsing
+//////////////////////////////////////////////////////////////////////
+
+/// \cond internal
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//
+// Translates hexadecimal digits to nibble values. Returns mask of characters that are hexadecimal digits.
+//
+static inline int guid_translate_ssse3(_In_ __m128i in, _Out_ __m128i &values)
+{
+    __m128i
+        digit    = _mm_sub_epi8(in, _mm_set1_epi8('0')),
+        alpha    = _mm_sub_epi8(_mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a' - 10)),
+        is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit),
+        is_alpha = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(15)), alpha), _mm_cmpgt_epi8(alpha, _mm_set1_epi8(9)));
+    values = _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, alpha));
+    return _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+}
+
+
+//
+// Returns mask of dashes
+//
+static inline int guid_dashes_ssse3(_In_ __m128i in)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8('-')));
+}
+
+
+//
+// Loads 16 characters as bytes. Wide characters outside of Latin-1 saturate to 0 or 255, which are neither hexadecimal digits nor dashes.
+//
+static inline __m128i guid_load_ssse3(_In_count_c_(16) const char *data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+
+static inline __m128i guid_load_ssse3(_In_count_c_(16) const wchar_t *data)
+{
+    return _mm_packus_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data    )),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 8)));
+}
+
+
+//
+// Parses `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX` from 48 characters loaded at once. Characters past the 36th are ignored.
+//
+template<class _Tchr>
+static bool guid_parse_ssse3(_In_count_c_(48) const _Tchr *str, _Out_ GUID &guid)
+{
+    __m128i v0, v1, v2, in0 = guid_load_ssse3(str), in1 = guid_load_ssse3(str + 16), in2 = guid_load_ssse3(str + 32);
+    int
+        hex0 = guid_translate_ssse3(in0, v0),
+        hex1 = guid_translate_ssse3(in1, v1),
+        hex2 = guid_translate_ssse3(in2, v2);
+
+    // Dashes are at positions 8, 13, 18 and 23; all other positions up to 36 are hexadecimal digits.
+    if (((hex0 ^ 0xdeff) | (hex1 ^ 0xff7b) | ((hex2 & 0xf) ^ 0xf) | ((guid_dashes_ssse3(in0) & 0x2100) ^ 0x2100) | ((guid_dashes_ssse3(in1) & 0x0084) ^ 0x0084)) != 0)
+        return false;
+
+    // Gather 32 nibbles skipping the dashes, and merge them into 16 bytes in text order.
+    __m128i
+        lo = _mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 14, 15, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1))),
+        hi = _mm_or_si128(
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3))),
+        bytes = _mm_packus_epi16(
+            _mm_maddubs_epi16(lo, _mm_set1_epi16(0x0110)),
+            _mm_maddubs_epi16(hi, _mm_set1_epi16(0x0110)));
+
+    // Data1, Data2 and Data3 are stored little-endian.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&guid), _mm_shuffle_epi8(bytes, _mm_setr_epi8(3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15)));
+    return true;
+}
+
+#endif
+
+
+template<class _Tchr>
+static const _Tchr* guid_parse_chars(_In_z_ const _Tchr *str, _Out_ GUID &guid)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    const _Tchr *p = *str == '{' ? str + 1 : str;
+
+    // Loading 48 characters may read past the string terminator. This is safe as long as the loads stay within the page.
+    if (((size_t)p & 0xfff) <= 0x1000 - 48*sizeof(_Tchr) && winstd::cpu_has_ssse3()) {
+        GUID g;
+        if (!guid_parse_ssse3(p, g))
+            return NULL;
+        p += 36;
+        if (p - str == 37 && *p++ != '}')
+            return NULL;
+        guid = g;
+        return p;
+    }
+#endif
+    return winstd::guid_parse<_Tchr>(str, guid);
+}
+
+/// \endcond
+
+
+_Success_(return != NULL) const char *winstd::guid_parse(_In_z_ const char *str, _Out_ GUID &guid)
+{
+    return guid_parse_chars(str, guid);
+}
+
+
+_Success_(return != NULL) const wchar_t *winstd::guid_parse(_In_z_ const wchar_t *str, _Out_ GUID &guid)
+{
+    return guid_parse_chars(str, guid);
+}
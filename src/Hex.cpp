@@ -0,0 +1,309 @@
+﻿/*
+    Copyright 1991-2019 Amebis
+    Copyright 2016 GÉANT
+
+    This file is part of WinStd.
+
+    Setup is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Setup is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Setup. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "StdAfx.h"
+
+
+//////////////////////////////////////////////////////////////////////
+// Hexadecimal encoding
+//////////////////////////////////////////////////////////////////////
+
+/// \cond internal
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//
+// Each byte is split into nibbles, which are mapped to digits using the digit table as a shuffle
+// control. Interleaving the high and low nibble digits yields the text in order.
+//
+static inline void hex_encode_block_ssse3(_In_ __m128i in, _In_ __m128i lut, _Out_ __m128i &lo, _Out_ __m128i &hi)
+{
+    __m128i
+        mask = _mm_set1_epi8(0x0f),
+        x_h  = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), mask)),
+        x_l  = _mm_shuffle_epi8(lut, _mm_and_si128(in, mask));
+    lo = _mm_unpacklo_epi8(x_h, x_l);
+    hi = _mm_unpackhi_epi8(x_h, x_l);
+}
+
+
+static inline void hex_encode_block_avx2(_In_ __m256i in, _In_ __m256i lut, _Out_ __m256i &lo, _Out_ __m256i &hi)
+{
+    __m256i
+        mask = _mm256_set1_epi8(0x0f),
+        x_h  = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(in, 4), mask)),
+        x_l  = _mm256_shuffle_epi8(lut, _mm256_and_si256(in, mask)),
+        a    = _mm256_unpacklo_epi8(x_h, x_l),
+        b    = _mm256_unpackhi_epi8(x_h, x_l);
+
+    // Unpacking works within 128-bit lanes. Reorder lanes to restore the byte order.
+    lo = _mm256_permute2x128_si256(a, b, 0x20);
+    hi = _mm256_permute2x128_si256(a, b, 0x31);
+}
+
+
+//
+// Stores 16 characters
+//
+static inline void hex_store_ssse3(_Out_writes_(16) char *out, _In_ __m128i chars)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+}
+
+
+static inline void hex_store_ssse3(_Out_writes_(16) wchar_t *out, _In_ __m128i chars)
+{
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out    ), _mm_unpacklo_epi8(chars, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(chars, zero));
+}
+
+
+//
+// Stores 32 characters
+//
+static inline void hex_store_avx2(_Out_writes_(32) char *out, _In_ __m256i chars)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+}
+
+
+static inline void hex_store_avx2(_Out_writes_(32) wchar_t *out, _In_ __m256i chars)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out     ), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chars)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chars, 1)));
+}
+
+
+template<class _Tchr>
+static size_t hex_encode_ssse3(_Out_writes_(size*2) _Tchr *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(16) const char *lookup)
+{
+    __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lookup)), lo, hi;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16, out += 32) {
+        hex_encode_block_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), lut, lo, hi);
+        hex_store_ssse3(out     , lo);
+        hex_store_ssse3(out + 16, hi);
+    }
+    return i;
+}
+
+
+template<class _Tchr>
+static size_t hex_encode_avx2(_Out_writes_(size*2) _Tchr *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_count_c_(16) const char *lookup)
+{
+    __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lookup))), lo, hi;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32, out += 64) {
+        hex_encode_block_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), lut, lo, hi);
+        hex_store_avx2(out     , lo);
+        hex_store_avx2(out + 32, hi);
+    }
+    return i + hex_encode_ssse3(out, data + i, size - i, lookup);
+}
+
+#endif
+
+
+template<class _Tchr>
+static _Tchr *hex_encode_chars(_Out_writes_(size*2) _Tchr *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_ bool lowercase)
+{
+    const char *lookup = lowercase ? "0123456789abcdef" : "0123456789ABCDEF";
+    size_t i = 0;
+
+#if defined(_M_IX86) || defined(_M_X64)
+    if (winstd::cpu_has_avx2())
+        i = hex_encode_avx2(out, data, size, lookup);
+    else if (winstd::cpu_has_ssse3())
+        i = hex_encode_ssse3(out, data, size, lookup);
+#endif
+
+    out += i*2;
+    for (; i < size; i++) {
+        *out++ = lookup[data[i] >> 4];
+        *out++ = lookup[data[i] & 0x0f];
+    }
+
+    return out;
+}
+
+/// \endcond
+
+
+char *winstd::hex_encode(_Out_writes_(size*2) char *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_ bool lowercase)
+{
+    return hex_encode_chars(out, data, size, lowercase);
+}
+
+
+wchar_t *winstd::hex_encode(_Out_writes_(size*2) wchar_t *out, _In_bytecount_(size) const unsigned char *data, _In_ size_t size, _In_ bool lowercase)
+{
+    return hex_encode_chars(out, data, size, lowercase);
+}
+
+
+//////////////////////////////////////////////////////////////////////
+// Hexadecimal decoding
+//////////////////////////////////////////////////////////////////////
+
+/// \cond internal
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//
+// Translates hexadecimal digits to nibble values. Returns false if any of the characters is not a
+// hexadecimal digit.
+//
+static inline bool hex_translate_ssse3(_In_ __m128i in, _Out_ __m128i &values)
+{
+    __m128i
+        digit    = _mm_sub_epi8(in, _mm_set1_epi8('0')),
+        alpha    = _mm_sub_epi8(_mm_or_si128(in, _mm_set1_epi8(0x20)), _mm_set1_epi8('a' - 10)),
+        is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit),
+        is_alpha = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(15)), alpha), _mm_cmpgt_epi8(alpha, _mm_set1_epi8(9)));
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xffff)
+        return false;
+    values = _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, alpha));
+    return true;
+}
+
+
+static inline bool hex_translate_avx2(_In_ __m256i in, _Out_ __m256i &values)
+{
+    __m256i
+        digit    = _mm256_sub_epi8(in, _mm256_set1_epi8('0')),
+        alpha    = _mm256_sub_epi8(_mm256_or_si256(in, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a' - 10)),
+        is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit),
+        is_alpha = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(15)), alpha), _mm256_cmpgt_epi8(alpha, _mm256_set1_epi8(9)));
+    if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) != -1)
+        return false;
+    values = _mm256_or_si256(_mm256_and_si256(is_digit, digit), _mm256_and_si256(is_alpha, alpha));
+    return true;
+}
+
+
+//
+// Packs 16 nibble values into 8 bytes
+//
+static inline void hex_pack_ssse3(_Out_writes_(8) unsigned char *out, _In_ __m128i values)
+{
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(merged, merged));
+}
+
+
+//
+// Packs 32 nibble values into 16 bytes
+//
+static inline void hex_pack_avx2(_Out_writes_(16) unsigned char *out, _In_ __m256i values)
+{
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+    merged = _mm256_permute4x64_epi64(_mm256_packus_epi16(merged, merged), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(merged));
+}
+
+
+//
+// Loads 16 characters as bytes. Wide characters outside of Latin-1 saturate to 0 or 255, which are not hexadecimal digits.
+//
+static inline __m128i hex_load_ssse3(_In_count_c_(16) const char *data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+
+static inline __m128i hex_load_ssse3(_In_count_c_(16) const wchar_t *data)
+{
+    return _mm_packus_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data    )),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 8)));
+}
+
+
+//
+// Loads 32 characters as bytes
+//
+static inline __m256i hex_load_avx2(_In_count_c_(32) const char *data)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+
+static inline __m256i hex_load_avx2(_In_count_c_(32) const wchar_t *data)
+{
+    // Packing works within 128-bit lanes. Reorder lanes to restore the character order.
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data     )),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 16))), 0xd8);
+}
+
+
+template<class _Tchr>
+static size_t hex_decode_ssse3(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size)
+{
+    size_t i = 0;
+    for (__m128i values; i + 16 <= size && hex_translate_ssse3(hex_load_ssse3(data + i), values); i += 16, out += 8)
+        hex_pack_ssse3(out, values);
+    return i;
+}
+
+
+template<class _Tchr>
+static size_t hex_decode_avx2(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size)
+{
+    size_t i = 0;
+    for (__m256i values; i + 32 <= size && hex_translate_avx2(hex_load_avx2(data + i), values); i += 32, out += 16)
+        hex_pack_avx2(out, values);
+    return i + hex_decode_ssse3(out, data + i, size - i);
+}
+
+#endif
+
+
+template<class _Tchr>
+static size_t hex_decode_chars(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const _Tchr *data, _In_ size_t size)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    if (winstd::cpu_has_avx2())
+        return hex_decode_avx2(out, data, size);
+    else if (winstd::cpu_has_ssse3())
+        return hex_decode_ssse3(out, data, size);
+#else
+    UNREFERENCED_PARAMETER(out);
+    UNREFERENCED_PARAMETER(data);
+    UNREFERENCED_PARAMETER(size);
+#endif
+    return 0;
+}
+
+/// \endcond
+
+
+size_t winstd::hex_decode(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const char *data, _In_ size_t size)
+{
+    return hex_decode_chars(out, data, size);
+}
+
+
+size_t winstd::hex_decode(_Out_writes_(size/2) unsigned char *out, _In_count_(size) const wchar_t *data, _In_ size_t size)
+{
+    return hex_decode_chars(out, data, size);
+}
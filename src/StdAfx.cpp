@@ -19,3 +19,46 @@
 */
 
 #include "StdAfx.h"
+
+
+#if defined(_M_IX86) || defined(_M_X64)
+
+//////////////////////////////////////////////////////////////////////
+// CPU feature detection
+//////////////////////////////////////////////////////////////////////
+
+/// \cond internal
+
+bool winstd::cpu_has_ssse3()
+{
+    static const bool has = [] {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+    }();
+    return has;
+}
+
+
+bool winstd::cpu_has_avx2()
+{
+    static const bool has = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS must preserve YMM registers on context switch.
+        __cpuid(info, 1);
+        if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return has;
+}
+
+/// \endcond
+
+#endif
@@ -30,6 +30,7 @@
 #if _WIN32_WINNT >= _WIN32_WINNT_VISTA
 #include "../include/WinStd/ETW.h"
 #endif
+#include "../include/WinStd/Format.h"
 #include "../include/WinStd/Hex.h"
 #include "../include/WinStd/MSI.h"
 #if defined(SECURITY_WIN32) || defined(SECURITY_KERNEL) || defined(SECURITY_MAC)
@@ -44,3 +45,15 @@
 #include "../include/WinStd/Common.h"
 
 #include <tchar.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+
+namespace winstd
+{
+    /// \cond internal
+    bool cpu_has_ssse3();
+    bool cpu_has_avx2();
+    /// \endcond
+}
+#endif